@@ -0,0 +1,440 @@
+#include "artnet_receiver.h"
+#include "config.h"
+#include "led_driver.h"
+#include "universe_map.h"
+#include "wifi_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+static const char *TAG = "ARTNET";
+
+#define ARTNET_OEM_UNKNOWN      0x00FF
+#define ARTNET_ESTA_PROTOTYPE   0x7FF0
+#define ARTNET_PORT_TYPE_OUTPUT 0x80    // Outputs DMX512 received from the network
+#define ARTNET_GOOD_OUTPUT_DATA 0x80    // Data is being output
+#define ARTNET_STATUS1          0xD0    // Indicators normal, port-addresses set locally
+#define ARTNET_STATUS2          0x0E    // 15-bit port-addresses, DHCP capable and in use
+#define ARTNET_STOP_TIMEOUT_MS  500     // Longest wait for the task to leave its loop
+
+// Global variables
+static int g_socket_fd = -1;
+static bool g_running = false;
+static TaskHandle_t g_task_handle = NULL;
+static TaskHandle_t g_stop_waiter = NULL;     // Notified by the task once it has left its loop
+static universe_map_t g_map;
+static artnet_data_cb_t g_data_callback = NULL;
+static artnet_receiver_stats_t g_stats = {0};
+
+// Only one controller drives the LEDs; others wait until it goes silent
+static uint32_t g_source_addr = 0;
+static int64_t g_source_last_us = 0;
+
+static int64_t g_last_sync_us = 0;      // Sync mode while ArtSync keeps coming
+static uint32_t g_received = 0;         // Universes written since the last commit
+static uint32_t g_active = 0;           // Universes that ever received data, for ArtPollReply
+
+static uint16_t get_le16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint16_t get_be16(const uint8_t* p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static bool in_sync_mode(int64_t now_us)
+{
+    return g_last_sync_us && now_us - g_last_sync_us < (int64_t)ARTNET_SYNC_TIMEOUT_MS * 1000;
+}
+
+/**
+ * Show the frame in the LED buffer
+ * Stamping the receive time and the push go under one hold of the LED
+ * pipeline lock, so no other receiver's transmit takes the stamp.
+ */
+static void commit_frame(int64_t rx_time_us)
+{
+    g_received = 0;
+    g_stats.frames_committed++;
+    led_driver_lock();
+    led_driver_mark_frame_received(rx_time_us);
+    if (g_data_callback) {
+        g_data_callback(0, NULL, 0, true);
+    }
+    led_driver_unlock();
+}
+
+static void handle_dmx_packet(const artnet_dmx_packet_t* packet, uint32_t source_addr,
+                              int64_t rx_time_us)
+{
+    const universe_map_entry_t* entry = universe_map_lookup(&g_map, packet->port_address);
+    if (!entry) {
+        g_stats.ignored_packets++;
+        return;
+    }
+
+    if (source_addr != g_source_addr) {
+        if (g_source_addr &&
+            rx_time_us - g_source_last_us < (int64_t)ARTNET_SOURCE_TIMEOUT_MS * 1000) {
+            g_stats.ignored_packets++;
+            return;
+        }
+        ESP_LOGI(TAG, "Controller %d.%d.%d.%d took over",
+                 (int)((source_addr >> 0) & 0xFF), (int)((source_addr >> 8) & 0xFF),
+                 (int)((source_addr >> 16) & 0xFF), (int)((source_addr >> 24) & 0xFF));
+        g_source_addr = source_addr;
+        g_last_sync_us = 0;
+        g_received = 0;
+    }
+    g_source_last_us = rx_time_us;
+
+    uint32_t bit = 1UL << universe_map_index(&g_map, entry);
+
+    // Other receivers write the same buffer; hold the lock from showing
+    // the previous frame to the push that completes this one
+    led_driver_lock();
+
+    // A universe arriving twice means the previous frame is as complete
+    // as it will get; in sync mode only if an ArtSync was lost
+    if (g_received & bit) {
+        commit_frame(rx_time_us);
+    }
+
+    size_t len = packet->len < entry->length ? packet->len : entry->length;
+    if (g_data_callback && len > 0) {
+        g_data_callback(entry->byte_offset, packet->data, len, false);
+    }
+    g_received |= bit;
+    g_active |= bit;
+    g_stats.dmx_packets++;
+
+    if (!in_sync_mode(rx_time_us) && g_received == universe_map_all_mask(&g_map)) {
+        commit_frame(rx_time_us);
+    }
+    led_driver_unlock();
+}
+
+static void handle_sync_packet(uint32_t source_addr, int64_t rx_time_us)
+{
+    // ArtSync from anyone but the controller sending our data is ignored
+    if (source_addr != g_source_addr) {
+        g_stats.ignored_packets++;
+        return;
+    }
+
+    if (!in_sync_mode(rx_time_us)) {
+        ESP_LOGI(TAG, "ArtSync received, latching frames on sync");
+    }
+    g_last_sync_us = rx_time_us;
+    g_stats.sync_packets++;
+
+    if (g_received) {
+        commit_frame(rx_time_us);
+    }
+}
+
+/**
+ * Answer an ArtPoll
+ * One ArtPollReply describes up to four output ports sharing a net and
+ * sub-net, so a strip spanning more universes is announced as several
+ * bound nodes.
+ */
+static void send_poll_reply(const struct sockaddr_in* poller)
+{
+    uint8_t reply[ARTNET_POLL_REPLY_SIZE];
+    esp_ip4_addr_t ip = wifi_manager_get_ip();
+    uint8_t mac[6] = {0};
+    esp_wifi_get_mac(WIFI_IF_STA, mac);
+
+    struct sockaddr_in dest = *poller;
+    dest.sin_port = htons(ARTNET_PORT);
+
+    size_t next = 0;
+    uint8_t bind_index = 1;
+    while (next < g_map.count) {
+        uint16_t base = g_map.entries[next].universe;
+        size_t ports = 0;
+        while (next + ports < g_map.count && ports < ARTNET_POLL_REPLY_PORTS &&
+               (g_map.entries[next + ports].universe & 0x7FF0) == (base & 0x7FF0)) {
+            ports++;
+        }
+
+        memset(reply, 0, sizeof(reply));
+        memcpy(&reply[0], ARTNET_ID, ARTNET_ID_SIZE);
+        reply[8] = ARTNET_OP_POLL_REPLY & 0xFF;
+        reply[9] = ARTNET_OP_POLL_REPLY >> 8;
+        memcpy(&reply[10], &ip.addr, 4);            // Network byte order already
+        reply[14] = ARTNET_PORT & 0xFF;             // Port is little-endian
+        reply[15] = ARTNET_PORT >> 8;
+        reply[18] = (base >> 8) & 0x7F;             // Net
+        reply[19] = (base >> 4) & 0x0F;             // Sub-net
+        reply[20] = ARTNET_OEM_UNKNOWN >> 8;
+        reply[21] = ARTNET_OEM_UNKNOWN & 0xFF;
+        reply[23] = ARTNET_STATUS1;
+        reply[24] = ARTNET_ESTA_PROTOTYPE & 0xFF;
+        reply[25] = ARTNET_ESTA_PROTOTYPE >> 8;
+        strncpy((char*)&reply[26], config_get_mdns_hostname(), 17);
+        strncpy((char*)&reply[44], "ESP32-C3 Ambient Light Board", 63);
+        snprintf((char*)&reply[108], 64, "#0001 [%04" PRIu32 "] OK",
+                 g_stats.poll_replies % 10000);
+        reply[173] = ports;
+        for (size_t i = 0; i < ports; i++) {
+            size_t index = next + i;
+            reply[174 + i] = ARTNET_PORT_TYPE_OUTPUT;
+            reply[182 + i] = (g_active & (1UL << index)) ? ARTNET_GOOD_OUTPUT_DATA : 0;
+            reply[190 + i] = g_map.entries[index].universe & 0x0F;
+        }
+        memcpy(&reply[201], mac, 6);
+        memcpy(&reply[207], &ip.addr, 4);
+        reply[211] = bind_index;
+        reply[212] = ARTNET_STATUS2;
+
+        if (sendto(g_socket_fd, reply, sizeof(reply), 0, (const struct sockaddr *)&dest,
+                   sizeof(dest)) < 0) {
+            ESP_LOGW(TAG, "Failed to send ArtPollReply: errno %d", errno);
+            return;
+        }
+        g_stats.poll_replies++;
+
+        next += ports;
+        bind_index++;
+    }
+}
+
+/**
+ * Art-Net receiver task
+ */
+static void artnet_receiver_task(void *pvParameters)
+{
+    uint8_t rx_buffer[ARTNET_MAX_PACKET_SIZE];
+    struct sockaddr_in source_addr;
+    socklen_t socklen = sizeof(source_addr);
+
+    ESP_LOGI(TAG, "Art-Net receiver task started");
+
+    while (g_running) {
+        // Blocks until a datagram arrives; the stop function sends one to wake it
+        int len = recvfrom(g_socket_fd, rx_buffer, sizeof(rx_buffer), 0,
+                           (struct sockaddr *)&source_addr, &socklen);
+
+        if (!g_running) {
+            break;
+        }
+
+        if (len < 0) {
+            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
+            break;
+        }
+
+        int64_t rx_time_us = esp_timer_get_time();
+        g_stats.packets_received++;
+
+        if (len < ARTNET_HEADER_SIZE || memcmp(rx_buffer, ARTNET_ID, ARTNET_ID_SIZE) != 0) {
+            g_stats.invalid_packets++;
+            continue;
+        }
+
+        switch (get_le16(&rx_buffer[8])) {
+            case ARTNET_OP_DMX: {
+                artnet_dmx_packet_t packet;
+                if (artnet_receiver_parse_dmx_packet(rx_buffer, len, &packet)) {
+                    handle_dmx_packet(&packet, source_addr.sin_addr.s_addr, rx_time_us);
+                } else {
+                    g_stats.invalid_packets++;
+                }
+                break;
+            }
+
+            case ARTNET_OP_SYNC:
+                handle_sync_packet(source_addr.sin_addr.s_addr, rx_time_us);
+                break;
+
+            case ARTNET_OP_POLL:
+                send_poll_reply(&source_addr);
+                break;
+
+            default:
+                // Including our own and other nodes' ArtPollReply broadcasts
+                g_stats.ignored_packets++;
+                break;
+        }
+    }
+
+    ESP_LOGI(TAG, "Art-Net receiver task ended");
+    g_task_handle = NULL;
+    if (g_stop_waiter) {
+        xTaskNotifyGive(g_stop_waiter);
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t artnet_receiver_init(uint16_t first_port_address)
+{
+    if (g_socket_fd >= 0) {
+        ESP_LOGW(TAG, "Art-Net receiver already initialized");
+        return ESP_OK;
+    }
+
+    esp_err_t ret = universe_map_build(&g_map, first_port_address, led_driver_get_buffer_size(),
+                                       LED_CHANNELS_PER_LED);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    g_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (g_socket_fd < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    // Controllers usually broadcast ArtPoll and often ArtDmx
+    int broadcast = 1;
+    setsockopt(g_socket_fd, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+    struct sockaddr_in bind_addr;
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(ARTNET_PORT);
+
+    if (bind(g_socket_fd, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
+        close(g_socket_fd);
+        g_socket_fd = -1;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Art-Net receiver initialized on port %d", ARTNET_PORT);
+    return ESP_OK;
+}
+
+esp_err_t artnet_receiver_start(void)
+{
+    if (g_socket_fd < 0) {
+        ESP_LOGE(TAG, "Art-Net receiver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (g_running) {
+        return ESP_OK;
+    }
+
+    g_source_addr = 0;
+    g_last_sync_us = 0;
+    g_received = 0;
+    g_running = true;
+
+    BaseType_t result = xTaskCreate(artnet_receiver_task, "artnet", 4096, NULL, 5, &g_task_handle);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create Art-Net receiver task - result: %d", result);
+        g_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Art-Net receiver started");
+    return ESP_OK;
+}
+
+esp_err_t artnet_receiver_stop(void)
+{
+    if (!g_running) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Stopping Art-Net receiver");
+
+    g_stop_waiter = xTaskGetCurrentTaskHandle();
+    g_running = false;
+
+    // The task blocks in recvfrom() without a timeout; a datagram to
+    // itself over loopback wakes it to see the flag. It notifies once out of
+    // its loop, so it is never deleted holding the LED pipeline lock. The
+    // single byte is not a valid packet of any protocol, so should it arrive
+    // after a restart it is only counted as invalid.
+    if (g_task_handle) {
+        static const uint8_t wakeup = 0;
+        struct sockaddr_in self = {
+            .sin_family = AF_INET,
+            .sin_port = htons(ARTNET_PORT),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+        sendto(g_socket_fd, &wakeup, sizeof(wakeup), 0, (struct sockaddr *)&self, sizeof(self));
+
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ARTNET_STOP_TIMEOUT_MS)) == 0 && g_task_handle) {
+            ESP_LOGW(TAG, "Art-Net receiver task did not stop, deleting it");
+            vTaskDelete(g_task_handle);
+            g_task_handle = NULL;
+        }
+    }
+    g_stop_waiter = NULL;
+
+    ESP_LOGI(TAG, "Art-Net receiver stopped");
+    return ESP_OK;
+}
+
+bool artnet_receiver_is_running(void)
+{
+    return g_running;
+}
+
+bool artnet_receiver_parse_dmx_packet(const uint8_t* data, size_t len, artnet_dmx_packet_t* packet)
+{
+    if (!data || !packet || len < ARTNET_DMX_HEADER_SIZE ||
+        memcmp(data, ARTNET_ID, ARTNET_ID_SIZE) != 0 || get_le16(&data[8]) != ARTNET_OP_DMX) {
+        return false;
+    }
+
+    // The spec asks for an even length, but odd ones are harmless
+    uint16_t channels = get_be16(&data[16]);
+    if (channels == 0 || channels > DMX_UNIVERSE_SIZE || channels > len - ARTNET_DMX_HEADER_SIZE) {
+        return false;
+    }
+
+    packet->sequence = data[12];
+    packet->port_address = get_le16(&data[14]) & 0x7FFF;
+    packet->data = &data[ARTNET_DMX_HEADER_SIZE];
+    packet->len = channels;
+    return true;
+}
+
+esp_err_t artnet_receiver_register_data_callback(artnet_data_cb_t callback)
+{
+    g_data_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t artnet_receiver_get_stats(artnet_receiver_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t artnet_receiver_deinit(void)
+{
+    if (g_running) {
+        artnet_receiver_stop();
+    }
+
+    if (g_socket_fd >= 0) {
+        close(g_socket_fd);
+        g_socket_fd = -1;
+    }
+
+    g_data_callback = NULL;
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    ESP_LOGI(TAG, "Art-Net receiver deinitialized");
+    return ESP_OK;
+}
@@ -0,0 +1,98 @@
+#ifndef ARTNET_RECEIVER_H
+#define ARTNET_RECEIVER_H
+
+#include "esp_err.h"
+#include "config.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Parsed ArtDmx packet
+ */
+typedef struct {
+    uint8_t sequence;       // 1-255, 0 if the sender does not number packets
+    uint16_t port_address;  // 15-bit net:sub-net:universe
+    const uint8_t* data;    // DMX channel data
+    size_t len;             // Number of channels
+} artnet_dmx_packet_t;
+
+/**
+ * Art-Net receiver statistics
+ */
+typedef struct {
+    uint32_t packets_received;  // Total packets received
+    uint32_t dmx_packets;       // ArtDmx packets written to the LED buffer
+    uint32_t sync_packets;      // ArtSync packets that latched a frame
+    uint32_t poll_replies;      // ArtPollReply packets sent
+    uint32_t frames_committed;  // Frames displayed
+    uint32_t ignored_packets;   // Valid packets for other universes, other sources or unhandled opcodes
+    uint32_t invalid_packets;   // Malformed packets
+} artnet_receiver_stats_t;
+
+/**
+ * Art-Net data callback function type
+ * Called for every accepted universe in arrival order; push is true when
+ * the frame is complete and should be made visible. A push-only call has
+ * len 0.
+ */
+typedef void (*artnet_data_cb_t)(uint32_t offset, const uint8_t* data, size_t len, bool push);
+
+/**
+ * Initialize Art-Net receiver
+ * Must be called after the LED count is set; the universe table is
+ * computed from the LED buffer size.
+ * @param first_port_address Port-address carrying the first LED
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t artnet_receiver_init(uint16_t first_port_address);
+
+/**
+ * Start Art-Net receiver
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t artnet_receiver_start(void);
+
+/**
+ * Stop Art-Net receiver
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t artnet_receiver_stop(void);
+
+/**
+ * Check if Art-Net receiver is running
+ * @return true if running, false otherwise
+ */
+bool artnet_receiver_is_running(void);
+
+/**
+ * Parse ArtDmx packet
+ * The data pointer refers into the packet; nothing is copied.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param packet Pointer to store parsed packet
+ * @return true if packet is a valid ArtDmx packet, false otherwise
+ */
+bool artnet_receiver_parse_dmx_packet(const uint8_t* data, size_t len, artnet_dmx_packet_t* packet);
+
+/**
+ * Register Art-Net data callback
+ * @param callback Callback function to register
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t artnet_receiver_register_data_callback(artnet_data_cb_t callback);
+
+/**
+ * Get receiver statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t artnet_receiver_get_stats(artnet_receiver_stats_t* stats);
+
+/**
+ * Deinitialize Art-Net receiver
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t artnet_receiver_deinit(void);
+
+#endif // ARTNET_RECEIVER_H
@@ -0,0 +1,199 @@
+#include "backpressure.h"
+#include "config.h"
+#include "udp_server.h"
+#include "led_driver.h"
+#include "telemetry.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "BACKPRESSURE";
+
+#define BACKPRESSURE_OVERLOAD_PERMILLE  20      // Dropping more than 2% of frames is overload
+#define BACKPRESSURE_QUEUE_WARN_BYTES   2944    // Two full-size datagrams waiting
+
+#define BACKPRESSURE_FLAG_OVERLOADED    0x01
+#define BACKPRESSURE_FLAG_QUEUE_BUILDING 0x02
+#define BACKPRESSURE_FLAG_QUEUE_UNKNOWN 0x04
+
+// Global variables
+static bool g_initialized = false;
+static esp_timer_handle_t g_report_timer = NULL;
+static backpressure_stats_t g_stats = {0};
+static uint32_t g_frame_time_us = 0;    // Encode plus wire time of a transmission
+
+// Counters at the previous tick, to work on per-interval deltas
+static struct {
+    int64_t time_us;
+    uint32_t frames_displayed;
+    uint32_t frames_skipped;
+    uint32_t frames_dropped;
+    uint32_t encode_count;
+    uint64_t encode_time_total_us;
+} g_last = {0};
+
+static void put_be(uint8_t* out, uint32_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static uint32_t clamp_u16(uint64_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : (uint32_t)value;
+}
+
+static uint32_t rate_x10(uint32_t count, int64_t elapsed_us)
+{
+    return elapsed_us > 0 ? (uint32_t)((uint64_t)count * 10000000 / elapsed_us) : 0;
+}
+
+/**
+ * Work out the interval's figures and send them to the streaming source
+ * Layout (big-endian), BACKPRESSURE_REPORT_SIZE bytes:
+ *   0 type, 1 version, 2 flags, 3 reserved
+ *   4 interval ms (u16), 6 achievable fps x10, 8 offered fps x10, 10 shown fps x10 (u16)
+ *   12 drop rate per mille (u16), 14 frame time us (u16)
+ *   16 receive queue bytes (u32, 0xFFFFFFFF if unknown)
+ */
+static void report_timer_callback(void* arg)
+{
+    int64_t now_us = esp_timer_get_time();
+    led_pipeline_stats_t pipeline = {0};
+    led_driver_get_pipeline_stats(&pipeline);
+    uint32_t frames_dropped = telemetry_get_dropped_frames();
+
+    int64_t elapsed_us = now_us - g_last.time_us;
+    uint32_t displayed = pipeline.frames_displayed - g_last.frames_displayed;
+    uint32_t lost = (pipeline.frames_skipped - g_last.frames_skipped) +
+                    (frames_dropped - g_last.frames_dropped);
+    uint32_t encodes = pipeline.encode_count - g_last.encode_count;
+    uint64_t encode_total = pipeline.encode_time_total_us - g_last.encode_time_total_us;
+
+    // The strip is refreshed one transmission at a time, each encoded and
+    // then clocked out; keep the last figure while nothing is transmitted
+    if (encodes > 0 && pipeline.last_wire_time_us > 0) {
+        g_frame_time_us = (uint32_t)(encode_total / encodes) + pipeline.last_wire_time_us;
+    }
+
+    g_last.time_us = now_us;
+    g_last.frames_displayed = pipeline.frames_displayed;
+    g_last.frames_skipped = pipeline.frames_skipped;
+    g_last.frames_dropped = frames_dropped;
+    g_last.encode_count = pipeline.encode_count;
+    g_last.encode_time_total_us = pipeline.encode_time_total_us;
+
+    struct sockaddr_in source;
+    if (!udp_server_get_stream_source(&source) || elapsed_us <= 0) {
+        return;
+    }
+
+    uint32_t offered = displayed + lost;
+    uint32_t achievable_x10 = g_frame_time_us ? 10000000 / g_frame_time_us : 0;
+    uint32_t offered_x10 = rate_x10(offered, elapsed_us);
+    uint32_t drop_permille = offered ? (uint32_t)((uint64_t)lost * 1000 / offered) : 0;
+    int queued = udp_server_get_rx_queue_bytes();
+
+    uint8_t flags = 0;
+    if (drop_permille > BACKPRESSURE_OVERLOAD_PERMILLE ||
+        (achievable_x10 && offered_x10 > achievable_x10)) {
+        flags |= BACKPRESSURE_FLAG_OVERLOADED;
+    }
+    if (queued < 0) {
+        flags |= BACKPRESSURE_FLAG_QUEUE_UNKNOWN;
+    } else if (queued >= BACKPRESSURE_QUEUE_WARN_BYTES) {
+        flags |= BACKPRESSURE_FLAG_QUEUE_BUILDING;
+    }
+
+    uint8_t report[BACKPRESSURE_REPORT_SIZE] = {0};
+    report[0] = PACKET_TYPE_BACKPRESSURE;
+    report[1] = BACKPRESSURE_VERSION;
+    report[2] = flags;
+    put_be(&report[4], clamp_u16(elapsed_us / 1000), 2);
+    put_be(&report[6], clamp_u16(achievable_x10), 2);
+    put_be(&report[8], clamp_u16(offered_x10), 2);
+    put_be(&report[10], clamp_u16(rate_x10(displayed, elapsed_us)), 2);
+    put_be(&report[12], drop_permille, 2);
+    put_be(&report[14], clamp_u16(g_frame_time_us), 2);
+    put_be(&report[16], queued < 0 ? UINT32_MAX : (uint32_t)queued, 4);
+
+    if (udp_server_send_to(&source, report, sizeof(report)) == ESP_OK) {
+        g_stats.reports_sent++;
+    }
+    g_stats.achievable_fps_x10 = achievable_x10;
+    g_stats.offered_fps_x10 = offered_x10;
+    g_stats.drop_permille = drop_permille;
+    g_stats.rx_queue_bytes = queued;
+    g_stats.overloaded = (flags & BACKPRESSURE_FLAG_OVERLOADED) != 0;
+
+    ESP_LOGD(TAG, "Offered %" PRIu32 ".%" PRIu32 " fps, achievable %" PRIu32 ".%" PRIu32
+             " fps, %" PRIu32 " permille dropped, %d bytes queued",
+             offered_x10 / 10, offered_x10 % 10, achievable_x10 / 10, achievable_x10 % 10,
+             drop_permille, queued);
+}
+
+esp_err_t backpressure_init(void)
+{
+    if (g_initialized) {
+        ESP_LOGW(TAG, "Backpressure already initialized");
+        return ESP_OK;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = report_timer_callback,
+        .name = "backpressure",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &g_report_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create backpressure timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    memset(&g_last, 0, sizeof(g_last));
+    g_last.time_us = esp_timer_get_time();
+
+    ret = esp_timer_start_periodic(g_report_timer, (uint64_t)CONFIG_BACKPRESSURE_INTERVAL_MS * 1000);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start backpressure timer: %s", esp_err_to_name(ret));
+        esp_timer_delete(g_report_timer);
+        g_report_timer = NULL;
+        return ret;
+    }
+
+    g_initialized = true;
+    ESP_LOGI(TAG, "Backpressure reports every %d ms to the streaming host",
+             CONFIG_BACKPRESSURE_INTERVAL_MS);
+    return ESP_OK;
+}
+
+esp_err_t backpressure_get_stats(backpressure_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t backpressure_deinit(void)
+{
+    if (!g_initialized) {
+        ESP_LOGW(TAG, "Backpressure not initialized");
+        return ESP_OK;
+    }
+
+    if (g_report_timer) {
+        esp_timer_stop(g_report_timer);
+        esp_timer_delete(g_report_timer);
+        g_report_timer = NULL;
+    }
+
+    g_initialized = false;
+
+    ESP_LOGI(TAG, "Backpressure deinitialized");
+    return ESP_OK;
+}
@@ -0,0 +1,41 @@
+#ifndef BACKPRESSURE_H
+#define BACKPRESSURE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Last backpressure figures, as sent to the host
+ */
+typedef struct {
+    uint32_t reports_sent;          // Reports sent since boot
+    uint32_t achievable_fps_x10;    // Refresh rate the output path sustains, in 0.1 fps
+    uint32_t offered_fps_x10;       // Frames the host asked to show, in 0.1 fps
+    uint32_t drop_permille;         // Share of offered frames never shown
+    int32_t rx_queue_bytes;         // Receive queue depth, -1 if unknown
+    bool overloaded;                // Host sends faster than the strip can show
+} backpressure_stats_t;
+
+/**
+ * Initialize backpressure reporting
+ * Every BACKPRESSURE_INTERVAL_MS, the source streaming LED data is sent a
+ * report (0x0E); nothing is sent while no source is streaming.
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t backpressure_init(void);
+
+/**
+ * Get the figures of the last report
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t backpressure_get_stats(backpressure_stats_t* stats);
+
+/**
+ * Deinitialize backpressure reporting
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t backpressure_deinit(void);
+
+#endif // BACKPRESSURE_H
@@ -0,0 +1,140 @@
+#include "capabilities.h"
+#include "config.h"
+#include "udp_server.h"
+#include "led_driver.h"
+#include "esp_log.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "CAPABILITIES";
+
+#define RMT_TICKS_PER_US        10      // RMT_CLK_DIV 8 on the 80 MHz APB clock
+#define LED_BIT_TICKS           (SK6812_T0H_TICKS + SK6812_T0L_TICKS)
+
+// Native packet types this firmware implements, in either direction
+static const uint8_t g_packet_types[] = {
+    PACKET_TYPE_PING,
+    PACKET_TYPE_LED_DATA,
+    PACKET_TYPE_LED_RGB565,
+    PACKET_TYPE_LED_RGB444,
+    PACKET_TYPE_LED_SCATTER,
+    PACKET_TYPE_LED_DATA_EXT,
+    PACKET_TYPE_TIME_SYNC,
+    PACKET_TYPE_TELEMETRY,
+    PACKET_TYPE_SOURCE_CLAIM,
+    PACKET_TYPE_FEC_PARITY,
+    PACKET_TYPE_NACK,
+#if CONFIG_BACKPRESSURE_ENABLE
+    PACKET_TYPE_BACKPRESSURE,
+#endif
+    PACKET_TYPE_CAPABILITIES,
+};
+
+static void put_be(uint8_t* out, uint32_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static uint32_t clamp_u16(uint32_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : value;
+}
+
+esp_err_t capabilities_get(capabilities_t* caps)
+{
+    if (!caps) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(caps, 0, sizeof(*caps));
+    caps->protocol_version = NATIVE_PROTOCOL_VERSION;
+    for (size_t i = 0; i < sizeof(g_packet_types); i++) {
+        caps->packet_types |= 1UL << g_packet_types[i];
+    }
+    caps->ext_flags = LED_DATA_EXT_FLAGS_SUPPORTED;
+    caps->pixel_formats = CAPABILITY_FORMAT_RAW | CAPABILITY_FORMAT_RGB565 | CAPABILITY_FORMAT_RGB444;
+
+#if CONFIG_DDP_SERVER_ENABLE
+    caps->receivers |= CAPABILITY_RECEIVER_DDP;
+#endif
+#if CONFIG_E131_RECEIVER_ENABLE
+    caps->receivers |= CAPABILITY_RECEIVER_E131;
+#endif
+#if CONFIG_ARTNET_RECEIVER_ENABLE
+    caps->receivers |= CAPABILITY_RECEIVER_ARTNET;
+#endif
+#if !CONFIG_SOURCE_ARBITRATION_NONE
+    caps->flags |= CAPABILITY_FLAG_ARBITRATION;
+#endif
+#if CONFIG_BACKPRESSURE_ENABLE
+    caps->flags |= CAPABILITY_FLAG_BACKPRESSURE;
+#endif
+
+    // The driver reads the order from sdkconfig, so report that
+    strncpy(caps->color_order, CONFIG_LED_COLOR_ORDER_STRING, sizeof(caps->color_order) - 1);
+    caps->channels = strlen(CONFIG_LED_COLOR_ORDER_STRING);
+    caps->led_count = led_driver_get_led_count();
+    caps->max_led_count = MAX_LED_COUNT;
+    caps->max_payload = UDP_MAX_UNFRAGMENTED_PAYLOAD;
+
+    led_pipeline_stats_t pipeline = {0};
+    led_driver_get_pipeline_stats(&pipeline);
+    if (pipeline.encode_count > 0 && pipeline.last_wire_time_us > 0) {
+        caps->frame_time_us = (uint32_t)(pipeline.encode_time_total_us / pipeline.encode_count) +
+                              pipeline.last_wire_time_us;
+    } else {
+        // Wire time only: every bit takes the same time, plus the reset pulse
+        uint32_t bits = (uint32_t)caps->led_count * caps->channels * 8;
+        caps->frame_time_us = (bits * LED_BIT_TICKS + SK6812_RESET_TICKS) / RMT_TICKS_PER_US;
+        caps->flags |= CAPABILITY_FLAG_FPS_ESTIMATED;
+    }
+    caps->max_fps_x10 = caps->frame_time_us ? 10000000 / caps->frame_time_us : 0;
+
+    return ESP_OK;
+}
+
+/**
+ * Build the response
+ * Layout (big-endian), CAPABILITIES_RESPONSE_SIZE bytes:
+ *   0 type, 1 kind, 2 layout version, 3 protocol version
+ *   4 packet types (u32 bitmap), 8 0x08 flags, 9 pixel formats, 10 receivers, 11 flags
+ *   12 channels, 13 color order (4 chars, zero padded), 17 reserved
+ *   18 LED count, 20 max LED count, 22 max payload, 24 max fps x10, 26 frame time us (u16)
+ */
+bool capabilities_handle_packet(const uint8_t* data, size_t len, const struct sockaddr_in* source)
+{
+    if (!data || !source || len != CAPABILITIES_REQUEST_SIZE ||
+        data[0] != PACKET_TYPE_CAPABILITIES || data[1] != CAPABILITIES_KIND_REQUEST) {
+        return false;
+    }
+
+    capabilities_t caps;
+    capabilities_get(&caps);
+
+    uint8_t response[CAPABILITIES_RESPONSE_SIZE] = {0};
+    response[0] = PACKET_TYPE_CAPABILITIES;
+    response[1] = CAPABILITIES_KIND_RESPONSE;
+    response[2] = CAPABILITIES_LAYOUT_VERSION;
+    response[3] = caps.protocol_version;
+    put_be(&response[4], caps.packet_types, 4);
+    response[8] = caps.ext_flags;
+    response[9] = caps.pixel_formats;
+    response[10] = caps.receivers;
+    response[11] = caps.flags;
+    response[12] = caps.channels;
+    memcpy(&response[13], caps.color_order, 4);
+    put_be(&response[18], caps.led_count, 2);
+    put_be(&response[20], caps.max_led_count, 2);
+    put_be(&response[22], caps.max_payload, 2);
+    put_be(&response[24], clamp_u16(caps.max_fps_x10), 2);
+    put_be(&response[26], clamp_u16(caps.frame_time_us), 2);
+
+    udp_server_send_to(source, response, sizeof(response));
+
+    ESP_LOGD(TAG, "Capabilities sent: %d LEDs, %s, max %" PRIu32 ".%" PRIu32 " fps",
+             caps.led_count, caps.color_order, caps.max_fps_x10 / 10, caps.max_fps_x10 % 10);
+    return true;
+}
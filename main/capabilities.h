@@ -0,0 +1,60 @@
+#ifndef CAPABILITIES_H
+#define CAPABILITIES_H
+
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define CAPABILITY_FORMAT_RAW       0x01    // 8 bits per channel (0x02, 0x07, 0x08)
+#define CAPABILITY_FORMAT_RGB565    0x02    // 0x05
+#define CAPABILITY_FORMAT_RGB444    0x04    // 0x06
+
+#define CAPABILITY_RECEIVER_DDP     0x01
+#define CAPABILITY_RECEIVER_E131    0x02
+#define CAPABILITY_RECEIVER_ARTNET  0x04
+
+#define CAPABILITY_FLAG_ARBITRATION 0x01    // LED data is only taken from the source holding the lock
+#define CAPABILITY_FLAG_BACKPRESSURE 0x02   // Streaming sources get 0x0E reports
+#define CAPABILITY_FLAG_FPS_ESTIMATED 0x04  // Nothing transmitted yet; max fps is worked out from LED timing
+
+/**
+ * What this board supports, as reported to hosts
+ */
+typedef struct {
+    uint8_t protocol_version;       // NATIVE_PROTOCOL_VERSION
+    uint32_t packet_types;          // Bit n: native packet type n is implemented
+    uint8_t ext_flags;              // 0x08 flags understood
+    uint8_t pixel_formats;          // CAPABILITY_FORMAT_* bits
+    uint8_t receivers;              // CAPABILITY_RECEIVER_* bits, other protocols served
+    uint8_t flags;                  // CAPABILITY_FLAG_* bits
+    uint8_t channels;               // Bytes per LED
+    char color_order[5];            // Channel order on the wire, e.g. "GRBW"
+    uint16_t led_count;             // LEDs driven
+    uint16_t max_led_count;         // LEDs this build can drive
+    uint16_t max_payload;           // Largest datagram that avoids IP fragmentation
+    uint32_t frame_time_us;         // Encode plus wire time of one refresh
+    uint32_t max_fps_x10;           // Refresh rate the strip sustains, in 0.1 fps
+} capabilities_t;
+
+/**
+ * Collect the board's capabilities
+ * The frame time comes from the LED driver's measurements once a
+ * transmission has happened, and from the LED timing before that.
+ * @param caps Pointer to store capabilities
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t capabilities_get(capabilities_t* caps);
+
+/**
+ * Handle a received capabilities packet (0x0F)
+ * A request is answered with a response to its sender.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param source Address the packet came from
+ * @return true if packet was a valid capabilities request, false otherwise
+ */
+bool capabilities_handle_packet(const uint8_t* data, size_t len, const struct sockaddr_in* source);
+
+#endif // CAPABILITIES_H
@@ -0,0 +1,469 @@
+#include "clock_sync.h"
+#include "config.h"
+#include "udp_server.h"
+#include "jitter_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "CLOCK_SYNC";
+
+#define CLOCK_SYNC_SAMPLES              8         // Min-delay filter window
+#define CLOCK_SYNC_MIN_SAMPLES          4         // Samples before the clock is usable
+#define CLOCK_SYNC_FAST_INTERVAL_US     200000    // Request interval while acquiring
+#define CLOCK_SYNC_INTERVAL_US          1000000   // Request interval once synced
+#define CLOCK_SYNC_MAX_RTT_US           100000    // Responses slower than this are discarded
+#define CLOCK_SYNC_MAX_MISSED           10        // Consecutive misses before sync is lost
+#define CLOCK_SYNC_DRIFT_MIN_SPAN_US    4000000   // Shortest baseline for a drift measurement
+#define CLOCK_SYNC_DRIFT_ANCHOR_US      60000000  // Baseline after which the anchor moves
+#define CLOCK_SYNC_MAX_DRIFT_PPB        500000    // 500 ppm, far beyond any crystal
+
+typedef struct {
+    int64_t local_us;       // Local midpoint of the exchange
+    int64_t offset_us;      // Host minus local
+    uint32_t delay_us;      // Round trip without host processing time
+} sync_sample_t;
+
+// Global variables
+static bool g_initialized = false;
+static esp_timer_handle_t g_request_timer = NULL;
+
+// Request state, shared by the esp_timer task and the udp server task
+static portMUX_TYPE g_request_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct sockaddr_in g_host_addr;
+static bool g_host_valid = false;
+static uint8_t g_request_seq = 0;
+static bool g_request_pending = false;
+static uint32_t g_missed = 0;
+static bool g_fast_requests = true;     // Filter window not yet full
+
+// Filter state (udp server task only)
+static sync_sample_t g_samples[CLOCK_SYNC_SAMPLES];
+static uint32_t g_sample_count = 0;
+static sync_sample_t g_drift_anchor;
+static bool g_anchor_valid = false;
+static bool g_drift_valid = false;
+static int64_t g_last_fit_local_us = 0;
+static uint32_t g_jitter_us = 0;
+
+// Clock model, read from any task
+static portMUX_TYPE g_model_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct {
+    bool synced;
+    int64_t ref_local_us;
+    int64_t offset_us;
+    int32_t drift_ppb;
+    uint32_t error_us;
+    uint32_t min_rtt_us;
+} g_model = {0};
+
+// Statistics
+static uint32_t g_stat_samples = 0;
+static uint32_t g_stat_timeouts = 0;
+
+static void put_u64(uint8_t* out, uint64_t value)
+{
+    for (int i = 7; i >= 0; i--) {
+        out[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static void put_u32(uint8_t* out, uint32_t value)
+{
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static uint64_t get_u64(const uint8_t* in)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+/**
+ * Host time predicted by the current model
+ */
+static int64_t model_local_to_host(int64_t local_us)
+{
+    return local_us + g_model.offset_us +
+           (local_us - g_model.ref_local_us) * g_model.drift_ppb / 1000000000LL;
+}
+
+/**
+ * Arm the next request
+ */
+static void schedule_request(void)
+{
+    portENTER_CRITICAL(&g_request_lock);
+    uint64_t interval = g_fast_requests ? CLOCK_SYNC_FAST_INTERVAL_US : CLOCK_SYNC_INTERVAL_US;
+    portEXIT_CRITICAL(&g_request_lock);
+    esp_timer_stop(g_request_timer);
+    esp_timer_start_once(g_request_timer, interval);
+}
+
+/**
+ * Request timer callback (esp_timer task)
+ */
+static void request_timer_callback(void* arg)
+{
+    struct sockaddr_in host;
+    uint8_t seq;
+    bool lost = false;
+
+    portENTER_CRITICAL(&g_request_lock);
+    if (!g_host_valid) {
+        portEXIT_CRITICAL(&g_request_lock);
+        return;
+    }
+    if (g_request_pending) {
+        g_stat_timeouts++;
+        if (++g_missed >= CLOCK_SYNC_MAX_MISSED) {
+            g_host_valid = false;
+            g_request_pending = false;
+            lost = true;
+        }
+    }
+    host = g_host_addr;
+    seq = ++g_request_seq;
+    portEXIT_CRITICAL(&g_request_lock);
+
+    if (lost) {
+        ESP_LOGW(TAG, "Time host stopped responding, sync lost");
+        portENTER_CRITICAL(&g_model_lock);
+        g_model.synced = false;
+        portEXIT_CRITICAL(&g_model_lock);
+        return;
+    }
+
+    uint8_t request[TIME_SYNC_REQUEST_SIZE];
+    request[0] = PACKET_TYPE_TIME_SYNC;
+    request[1] = TIME_SYNC_KIND_REQUEST;
+    request[2] = seq;
+    put_u64(&request[3], (uint64_t)esp_timer_get_time());
+
+    if (udp_server_send_to(&host, request, sizeof(request)) == ESP_OK) {
+        portENTER_CRITICAL(&g_request_lock);
+        // Unless a start or stop from the host reset the exchange meanwhile
+        if (g_host_valid && g_request_seq == seq) {
+            g_request_pending = true;
+        }
+        portEXIT_CRITICAL(&g_request_lock);
+    }
+
+    schedule_request();
+}
+
+/**
+ * Start requesting time from a host
+ */
+static void handle_start(const struct sockaddr_in* source)
+{
+    portENTER_CRITICAL(&g_request_lock);
+    bool same_host = g_host_valid &&
+                     g_host_addr.sin_addr.s_addr == source->sin_addr.s_addr &&
+                     g_host_addr.sin_port == source->sin_port;
+    g_host_addr = *source;
+    g_host_valid = true;
+    g_missed = 0;
+    g_request_pending = false;
+    if (!same_host) {
+        g_fast_requests = true;
+    }
+    portEXIT_CRITICAL(&g_request_lock);
+
+    if (!same_host) {
+        // A different host has a different clock; start over
+        ESP_LOGI(TAG, "Time host set to %d.%d.%d.%d:%d",
+                 (int)((source->sin_addr.s_addr >> 0) & 0xFF),
+                 (int)((source->sin_addr.s_addr >> 8) & 0xFF),
+                 (int)((source->sin_addr.s_addr >> 16) & 0xFF),
+                 (int)((source->sin_addr.s_addr >> 24) & 0xFF),
+                 ntohs(source->sin_port));
+
+        g_sample_count = 0;
+        g_anchor_valid = false;
+        g_drift_valid = false;
+        g_jitter_us = 0;
+
+        portENTER_CRITICAL(&g_model_lock);
+        memset(&g_model, 0, sizeof(g_model));
+        portEXIT_CRITICAL(&g_model_lock);
+    }
+
+    esp_timer_stop(g_request_timer);
+    esp_timer_start_once(g_request_timer, 0);
+}
+
+/**
+ * Feed one completed exchange into the filter
+ */
+static void handle_response(const uint8_t* data, int64_t t4)
+{
+    uint8_t seq = data[2];
+    int64_t t1 = (int64_t)get_u64(&data[3]);
+    int64_t t2 = (int64_t)get_u64(&data[11]);
+    int64_t t3 = (int64_t)get_u64(&data[19]);
+
+    int64_t rtt = (t4 - t1) - (t3 - t2);
+    if (t4 < t1 || rtt < 0 || t4 - t1 > CLOCK_SYNC_MAX_RTT_US) {
+        ESP_LOGD(TAG, "Discarding sync response %d: rtt %" PRId64 " us", seq, rtt);
+        return;
+    }
+
+    sync_sample_t sample = {
+        .local_us = t1 + (t4 - t1) / 2,
+        .offset_us = ((t2 - t1) + (t3 - t4)) / 2,
+        .delay_us = (uint32_t)rtt,
+    };
+
+    // Track how far fresh samples land from the prediction
+    if (g_model.synced) {
+        int64_t predicted = model_local_to_host(sample.local_us) - sample.local_us;
+        int64_t residual = sample.offset_us - predicted;
+        uint32_t magnitude = (uint32_t)(residual < 0 ? -residual : residual);
+        g_jitter_us += ((int32_t)magnitude - (int32_t)g_jitter_us) / 8;
+    }
+
+    g_samples[g_sample_count % CLOCK_SYNC_SAMPLES] = sample;
+    g_sample_count++;
+    g_stat_samples++;
+
+    portENTER_CRITICAL(&g_request_lock);
+    if (seq == g_request_seq) {
+        g_request_pending = false;
+        g_missed = 0;
+    }
+    g_fast_requests = g_sample_count < CLOCK_SYNC_SAMPLES;
+    portEXIT_CRITICAL(&g_request_lock);
+
+    // The exchange with the shortest round trip was least disturbed by
+    // queueing, so its offset is the most trustworthy
+    uint32_t window = g_sample_count < CLOCK_SYNC_SAMPLES ? g_sample_count : CLOCK_SYNC_SAMPLES;
+    const sync_sample_t* best = &g_samples[0];
+    for (uint32_t i = 1; i < window; i++) {
+        if (g_samples[i].delay_us < best->delay_us) {
+            best = &g_samples[i];
+        }
+    }
+
+    if (best->local_us == g_last_fit_local_us) {
+        // Same sample as before, model unchanged apart from the error estimate
+        portENTER_CRITICAL(&g_model_lock);
+        g_model.error_us = best->delay_us / 2 + g_jitter_us;
+        portEXIT_CRITICAL(&g_model_lock);
+        return;
+    }
+    g_last_fit_local_us = best->local_us;
+
+    int32_t drift_ppb = g_model.drift_ppb;
+    if (!g_anchor_valid) {
+        g_drift_anchor = *best;
+        g_anchor_valid = true;
+    } else if (best->local_us - g_drift_anchor.local_us >= CLOCK_SYNC_DRIFT_MIN_SPAN_US) {
+        int64_t span = best->local_us - g_drift_anchor.local_us;
+        int64_t measured = (best->offset_us - g_drift_anchor.offset_us) * 1000000000LL / span;
+        if (measured > CLOCK_SYNC_MAX_DRIFT_PPB) {
+            measured = CLOCK_SYNC_MAX_DRIFT_PPB;
+        } else if (measured < -CLOCK_SYNC_MAX_DRIFT_PPB) {
+            measured = -CLOCK_SYNC_MAX_DRIFT_PPB;
+        }
+
+        drift_ppb = g_drift_valid ? drift_ppb + (int32_t)((measured - drift_ppb) / 4)
+                                  : (int32_t)measured;
+        g_drift_valid = true;
+
+        if (span >= CLOCK_SYNC_DRIFT_ANCHOR_US) {
+            g_drift_anchor = *best;
+        }
+    }
+
+    bool was_synced;
+    portENTER_CRITICAL(&g_model_lock);
+    was_synced = g_model.synced;
+    g_model.ref_local_us = best->local_us;
+    g_model.offset_us = best->offset_us;
+    g_model.drift_ppb = drift_ppb;
+    g_model.min_rtt_us = best->delay_us;
+    g_model.error_us = best->delay_us / 2 + g_jitter_us;
+    g_model.synced = g_sample_count >= CLOCK_SYNC_MIN_SAMPLES;
+    portEXIT_CRITICAL(&g_model_lock);
+
+    if (!was_synced && g_model.synced) {
+        ESP_LOGI(TAG, "Clock synchronized: offset %" PRId64 " us, rtt %" PRIu32 " us",
+                 best->offset_us, best->delay_us);
+    }
+}
+
+/**
+ * Report sync error and presentation phase to the asking host
+ */
+static void send_status(const struct sockaddr_in* dest)
+{
+    clock_sync_status_t status;
+    jitter_buffer_stats_t jitter_stats = {0};
+    clock_sync_get_status(&status);
+    jitter_buffer_get_stats(&jitter_stats);
+
+    uint8_t reply[TIME_SYNC_STATUS_SIZE];
+    reply[0] = PACKET_TYPE_TIME_SYNC;
+    reply[1] = TIME_SYNC_KIND_STATUS;
+    reply[2] = status.synced ? 1 : 0;
+    put_u32(&reply[3], status.error_us);
+    put_u32(&reply[7], jitter_stats.grid_frames);
+    put_u32(&reply[11], (uint32_t)jitter_stats.last_phase_error_us);
+    put_u32(&reply[15], jitter_stats.max_phase_error_us);
+
+    udp_server_send_to(dest, reply, sizeof(reply));
+}
+
+esp_err_t clock_sync_init(void)
+{
+    if (g_initialized) {
+        ESP_LOGW(TAG, "Clock sync already initialized");
+        return ESP_OK;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = request_timer_callback,
+        .name = "clock_sync",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &g_request_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create sync timer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    g_initialized = true;
+    ESP_LOGI(TAG, "Clock sync initialized");
+    return ESP_OK;
+}
+
+bool clock_sync_handle_packet(const uint8_t* data, size_t len,
+                              const struct sockaddr_in* source, int64_t rx_time_us)
+{
+    if (!g_initialized || !data || len < TIME_SYNC_HEADER_SIZE || !source ||
+        data[0] != PACKET_TYPE_TIME_SYNC) {
+        return false;
+    }
+
+    switch (data[1]) {
+        case TIME_SYNC_KIND_START:
+            handle_start(source);
+            return true;
+
+        case TIME_SYNC_KIND_STOP:
+            ESP_LOGI(TAG, "Time host stopped sync");
+            esp_timer_stop(g_request_timer);
+            portENTER_CRITICAL(&g_request_lock);
+            g_host_valid = false;
+            portEXIT_CRITICAL(&g_request_lock);
+            return true;
+
+        case TIME_SYNC_KIND_STATUS_REQUEST:
+            send_status(source);
+            return true;
+
+        case TIME_SYNC_KIND_RESPONSE: {
+            portENTER_CRITICAL(&g_request_lock);
+            bool from_host = g_host_valid &&
+                             source->sin_addr.s_addr == g_host_addr.sin_addr.s_addr;
+            portEXIT_CRITICAL(&g_request_lock);
+            if (len != TIME_SYNC_RESPONSE_SIZE || !from_host) {
+                return false;
+            }
+            handle_response(data, rx_time_us);
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+bool clock_sync_is_synced(void)
+{
+    return g_model.synced;
+}
+
+int64_t clock_sync_get_time_us(void)
+{
+    return clock_sync_local_to_host(esp_timer_get_time());
+}
+
+int64_t clock_sync_local_to_host(int64_t local_us)
+{
+    int64_t host_us;
+    portENTER_CRITICAL(&g_model_lock);
+    host_us = model_local_to_host(local_us);
+    portEXIT_CRITICAL(&g_model_lock);
+    return host_us;
+}
+
+int64_t clock_sync_host_to_local(int64_t host_us)
+{
+    int64_t local_us;
+    portENTER_CRITICAL(&g_model_lock);
+    // First-order inverse of model_local_to_host(); exact to well under
+    // a microsecond for any plausible drift
+    local_us = host_us - g_model.offset_us;
+    local_us -= (local_us - g_model.ref_local_us) * g_model.drift_ppb / 1000000000LL;
+    portEXIT_CRITICAL(&g_model_lock);
+    return local_us;
+}
+
+esp_err_t clock_sync_get_status(clock_sync_status_t* status)
+{
+    if (!status) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&g_model_lock);
+    status->synced = g_model.synced;
+    status->offset_us = g_model.offset_us;
+    status->drift_ppb = g_model.drift_ppb;
+    status->error_us = g_model.error_us;
+    status->min_rtt_us = g_model.min_rtt_us;
+    portEXIT_CRITICAL(&g_model_lock);
+
+    status->samples = g_stat_samples;
+    portENTER_CRITICAL(&g_request_lock);
+    status->timeouts = g_stat_timeouts;
+    portEXIT_CRITICAL(&g_request_lock);
+    return ESP_OK;
+}
+
+esp_err_t clock_sync_deinit(void)
+{
+    if (!g_initialized) {
+        ESP_LOGW(TAG, "Clock sync not initialized");
+        return ESP_OK;
+    }
+
+    if (g_request_timer) {
+        esp_timer_stop(g_request_timer);
+        esp_timer_delete(g_request_timer);
+        g_request_timer = NULL;
+    }
+
+    g_host_valid = false;
+    g_request_pending = false;
+    g_fast_requests = true;
+    g_sample_count = 0;
+    g_anchor_valid = false;
+    g_drift_valid = false;
+    memset(&g_model, 0, sizeof(g_model));
+    g_stat_samples = 0;
+    g_stat_timeouts = 0;
+    g_initialized = false;
+
+    ESP_LOGI(TAG, "Clock sync deinitialized");
+    return ESP_OK;
+}
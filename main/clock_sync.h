@@ -0,0 +1,80 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Clock synchronization status
+ */
+typedef struct {
+    bool synced;            // Enough samples for a usable estimate
+    int64_t offset_us;      // Host clock minus local clock at the last fit
+    int32_t drift_ppb;      // Host clock rate relative to local clock (parts per billion)
+    uint32_t error_us;      // Estimated error of clock_sync_get_time_us()
+    uint32_t min_rtt_us;    // Round trip of the sample currently used
+    uint32_t samples;       // Responses processed
+    uint32_t timeouts;      // Requests that got no response
+} clock_sync_status_t;
+
+/**
+ * Initialize clock synchronization
+ * Requests start once a host sends a sync start packet.
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t clock_sync_init(void);
+
+/**
+ * Handle a received time sync packet (0x09)
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param source Address the packet came from
+ * @param rx_time_us Local receive time (esp_timer_get_time())
+ * @return true if packet was a valid time sync packet, false otherwise
+ */
+bool clock_sync_handle_packet(const uint8_t* data, size_t len,
+                              const struct sockaddr_in* source, int64_t rx_time_us);
+
+/**
+ * Check if the host clock is known
+ * @return true if synchronized, false otherwise
+ */
+bool clock_sync_is_synced(void);
+
+/**
+ * Get current host time
+ * @return Host time in microseconds (local time if not synchronized)
+ */
+int64_t clock_sync_get_time_us(void);
+
+/**
+ * Convert host time to local esp_timer time
+ * @param host_us Host time in microseconds
+ * @return Local time in microseconds
+ */
+int64_t clock_sync_host_to_local(int64_t host_us);
+
+/**
+ * Convert local esp_timer time to host time
+ * @param local_us Local time in microseconds
+ * @return Host time in microseconds
+ */
+int64_t clock_sync_local_to_host(int64_t local_us);
+
+/**
+ * Get clock synchronization status
+ * @param status Pointer to store status
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t clock_sync_get_status(clock_sync_status_t* status);
+
+/**
+ * Deinitialize clock synchronization
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t clock_sync_deinit(void);
+
+#endif // CLOCK_SYNC_H
@@ -36,7 +36,12 @@ typedef struct {
   uint8_t breathing_max_brightness;    // Breathing maximum brightness
   uint8_t breathing_step_size;         // Breathing step size
   uint16_t breathing_timer_period_ms;  // Breathing timer period
-  uint8_t reserved[48];                // Reserved for future use
+  uint8_t static_ip_enabled;           // Use the addresses below instead of DHCP
+  uint8_t static_ip[4];                // Static IPv4 address, a.b.c.d
+  uint8_t static_netmask[4];           // Static netmask
+  uint8_t static_gateway[4];           // Static gateway
+  uint8_t static_dns[4];               // Static DNS server, 0.0.0.0 for none
+  uint8_t reserved[31];                // Reserved for future use
   uint32_t checksum;                   // CRC32 checksum
 } __attribute__((packed)) firmware_config_t;
 
@@ -57,6 +62,7 @@ const char* config_get_mdns_hostname(void);
 uint8_t config_get_led_pin(void);
 uint16_t config_get_max_leds(void);
 const char* config_get_led_order(void);
+bool config_get_static_ip(uint32_t* ip, uint32_t* netmask, uint32_t* gateway, uint32_t* dns);
 
 // Hardware Configuration - use sdkconfig values
 #define LED_DATA_PIN            (gpio_num_t)CONFIG_LED_DATA_PIN
@@ -69,14 +75,144 @@ const char* config_get_led_order(void);
 #define MDNS_PROTOCOL           "_udp"
 #define MDNS_HOSTNAME           CONFIG_MDNS_HOSTNAME
 #define MDNS_ANNOUNCE_INTERVAL  30000  // 30 seconds in ms
+#define MDNS_ANNOUNCE_BURST_FIRST_MS 2000  // First extra announcement after got-IP
+#define MDNS_ANNOUNCE_BURST_COUNT    4     // Extra announcements, each interval doubled
+#define MDNS_TXT_CHECK_INTERVAL_MS   2000  // How often TXT values are compared with the live ones
+#define MDNS_TXT_MIN_INTERVAL_MS     10000 // Least time between TXT replacements while online
+#define MDNS_TXT_BUSY_MS             5000  // Shown frames keep the board busy this long
 
 // Protocol Configuration
 #define PACKET_TYPE_PING        0x01
 #define PACKET_TYPE_LED_DATA    0x02
 #define PACKET_TYPE_IGNORE_1    0x03
 #define PACKET_TYPE_IGNORE_2    0x04
+#define PACKET_TYPE_LED_RGB565  0x05
+#define PACKET_TYPE_LED_RGB444  0x06
+#define PACKET_TYPE_LED_SCATTER 0x07
+#define PACKET_TYPE_LED_DATA_EXT 0x08
+#define PACKET_TYPE_TIME_SYNC   0x09
+#define PACKET_TYPE_TELEMETRY   0x0A
+#define PACKET_TYPE_SOURCE_CLAIM 0x0B
+#define PACKET_TYPE_FEC_PARITY  0x0C
+#define PACKET_TYPE_NACK        0x0D
+#define PACKET_TYPE_BACKPRESSURE 0x0E
+#define PACKET_TYPE_CAPABILITIES 0x0F
 #define MAX_PACKET_SIZE         4096
+#define TELEMETRY_KIND_SUBSCRIBE 0x00  // Host -> board: [Interval_ms u16], 0 unsubscribes
+#define TELEMETRY_KIND_REPORT   0x01  // Board -> host
+#define TELEMETRY_SUBSCRIBE_SIZE 4
+#define TELEMETRY_LAYOUT_VERSION 1
+#define TELEMETRY_REPORT_SIZE   72
+#define BACKPRESSURE_VERSION    1
+#define BACKPRESSURE_REPORT_SIZE 20
+#define PING_EXT_VERSION        1
+#define PING_EXT_REQUEST_SIZE   10  // Type + Version + Host timestamp
+#define PING_EXT_RESPONSE_SIZE  30  // Type + Version + Host ts + Board rx + Board tx + Frame latency
 #define LED_DATA_HEADER_SIZE    3  // Type + Offset (2 bytes)
+#define LED_PACKED_HEADER_SIZE  3  // Type + LED offset (2 bytes, LED units)
+#define LED_SCATTER_HEADER_SIZE 2  // Type + Run count
+#define LED_SCATTER_RUN_HEADER_SIZE 4  // Offset (2 bytes) + Length (2 bytes)
+#define LED_SCATTER_MAX_RUNS    32
+#define LED_DATA_EXT_HEADER_SIZE 7  // Type + Version + Flags + Offset (4 bytes)
+#define LED_DATA_EXT_VERSION    1
+#define LED_DATA_EXT_FLAG_LED_UNITS 0x01  // Offset is in LEDs, not bytes
+#define LED_DATA_EXT_FLAG_TIMESTAMP 0x02  // 8-byte presentation timestamp (us) follows offset
+#define LED_DATA_EXT_FLAG_PUSH      0x04  // Last packet of a frame
+#define LED_DATA_EXT_FLAG_SEQUENCE  0x08  // Sequence number and frame id (2 bytes each) follow
+#define LED_DATA_EXT_FLAG_FEC       0x10  // FEC group, index and size (1 byte each) follow; needs SEQUENCE
+#define LED_DATA_EXT_FLAG_FRAGMENT  0x20  // Fragment index and count (1 byte each) follow; needs SEQUENCE
+#define LED_DATA_EXT_FLAGS_SUPPORTED (LED_DATA_EXT_FLAG_LED_UNITS | LED_DATA_EXT_FLAG_TIMESTAMP | \
+                                      LED_DATA_EXT_FLAG_PUSH | LED_DATA_EXT_FLAG_SEQUENCE | \
+                                      LED_DATA_EXT_FLAG_FEC | LED_DATA_EXT_FLAG_FRAGMENT)
+#define LED_DATA_EXT_TIMESTAMP_SIZE 8
+#define LED_DATA_EXT_SEQUENCE_SIZE  4
+#define LED_DATA_EXT_FEC_SIZE       3
+#define LED_DATA_EXT_FRAGMENT_SIZE  2
+#define FRAME_MAX_FRAGMENTS     32  // Fragments of one reliable frame, one NACK bitmap bit each
+#define NACK_VERSION            1
+#define NACK_PACKET_SIZE        9  // Type + Version + Frame id (2 bytes) + Fragment count + Missing bitmap (4 bytes)
+#define FEC_PARITY_VERSION      1
+#define FEC_PARITY_HEADER_SIZE  6  // Type + Version + Frame id (2 bytes) + Group + Group size
+#define FEC_MAX_GROUP_SIZE      16  // Data packets covered by one parity packet
+#define FEC_MAX_PACKET_SIZE     1472  // Protected datagrams must fit one unfragmented IPv4 packet
+#define TIME_SYNC_HEADER_SIZE   2  // Type + Kind
+#define TIME_SYNC_REQUEST_SIZE  11  // Type + Kind + Seq + T1
+#define TIME_SYNC_RESPONSE_SIZE 27  // Type + Kind + Seq + T1 + T2 + T3
+#define TIME_SYNC_KIND_START    0x00  // Host -> board: use me as time host
+#define TIME_SYNC_KIND_REQUEST  0x01  // Board -> host
+#define TIME_SYNC_KIND_RESPONSE 0x02  // Host -> board
+#define TIME_SYNC_KIND_STOP     0x03  // Host -> board: stop requesting
+#define TIME_SYNC_KIND_STATUS_REQUEST 0x04  // Host -> board
+#define TIME_SYNC_KIND_STATUS   0x05  // Board -> host: sync and phase status
+#define TIME_SYNC_STATUS_SIZE   19  // Type + Kind + Synced + Error + Grid frames + Phase + Max phase
+#define SOURCE_CLAIM_HEADER_SIZE 2  // Type + Kind
+#define SOURCE_CLAIM_REQUEST_SIZE 3  // Type + Kind + Priority
+#define SOURCE_CLAIM_STATUS_SIZE 12  // Type + Kind + Granted + Owner priority + Owner IP + Owner port + Lock remaining ms
+#define SOURCE_CLAIM_KIND_CLAIM 0x00  // Host -> board: [Priority u8], also renews the lock
+#define SOURCE_CLAIM_KIND_RELEASE 0x01  // Host -> board
+#define SOURCE_CLAIM_KIND_STATUS 0x02  // Board -> host
+#define CAPABILITIES_KIND_REQUEST 0x00  // Host -> board
+#define CAPABILITIES_KIND_RESPONSE 0x01  // Board -> host
+#define CAPABILITIES_REQUEST_SIZE 2  // Type + Kind
+#define CAPABILITIES_RESPONSE_SIZE 28
+#define CAPABILITIES_LAYOUT_VERSION 1
+#define NATIVE_PROTOCOL_VERSION 1  // Raised when a native packet format changes incompatibly
+#define UDP_MAX_UNFRAGMENTED_PAYLOAD 1472  // 1500-byte MTU minus IPv4 and UDP headers
+
+// DDP (Distributed Display Protocol) Configuration
+#define DDP_PORT                4048
+#define DDP_MAX_PACKET_SIZE     1500  // 1440 bytes of data per packet is the DDP norm
+#define DDP_HEADER_SIZE         10  // Flags + Sequence + Data type + Id + Offset (4) + Length (2)
+#define DDP_TIMECODE_SIZE       4
+#define DDP_FLAG_VERSION_MASK   0xC0
+#define DDP_FLAG_VERSION_1      0x40
+#define DDP_FLAG_TIMECODE       0x10  // 4-byte timecode follows the header
+#define DDP_FLAG_STORAGE        0x08
+#define DDP_FLAG_REPLY          0x04
+#define DDP_FLAG_QUERY          0x02
+#define DDP_FLAG_PUSH           0x01  // Display the frame
+#define DDP_SEQUENCE_MASK       0x0F
+#define DDP_TYPE_SIZE_MASK      0x07
+#define DDP_TYPE_SIZE_8BIT      0x03
+#define DDP_ID_DEFAULT          0x00  // Reserved, treated as the display by common senders
+#define DDP_ID_DISPLAY          0x01
+#define DDP_ID_ALL              0xFF
+
+// E1.31 (sACN) Configuration
+#define E131_PORT               5568
+#define E131_MAX_PACKET_SIZE    638  // Full 512-channel data packet
+#define E131_ACN_ID             "ASC-E1.17\0\0\0"
+#define E131_ACN_ID_SIZE        12
+#define E131_CID_SIZE           16
+#define E131_ROOT_VECTOR_DATA   0x00000004
+#define E131_ROOT_VECTOR_EXTENDED 0x00000008
+#define E131_FRAMING_VECTOR_DATA 0x00000002
+#define E131_FRAMING_VECTOR_SYNC 0x00000001
+#define E131_DMP_VECTOR         0x02
+#define E131_DMP_ADDRESS_TYPE   0xA1
+#define E131_DATA_HEADER_SIZE   126  // Root + framing + DMP layers, up to and including the start code
+#define E131_SYNC_PACKET_SIZE   49
+#define E131_OPTION_PREVIEW     0x80  // Visualizer data, not for output
+#define E131_OPTION_TERMINATED  0x40  // Source is stopping
+#define E131_SOURCE_TIMEOUT_MS  2500  // E1.31 network data loss timeout
+#define E131_MULTICAST_PREFIX   0xEFFF0000  // 239.255.<universe hi>.<universe lo>
+
+// Art-Net Configuration
+#define ARTNET_PORT             6454
+#define ARTNET_MAX_PACKET_SIZE  530  // Full 512-channel ArtDmx
+#define ARTNET_ID               "Art-Net"  // Followed by a NUL, 8 bytes
+#define ARTNET_ID_SIZE          8
+#define ARTNET_PROTOCOL_VERSION 14
+#define ARTNET_OP_POLL          0x2000
+#define ARTNET_OP_POLL_REPLY    0x2100
+#define ARTNET_OP_DMX           0x5000
+#define ARTNET_OP_SYNC          0x5200
+#define ARTNET_HEADER_SIZE      12  // ID + OpCode (little-endian) + ProtVer
+#define ARTNET_DMX_HEADER_SIZE  18  // Header + Sequence + Physical + Port-Address (2) + Length (2)
+#define ARTNET_POLL_REPLY_SIZE  239
+#define ARTNET_POLL_REPLY_PORTS 4  // Ports described per ArtPollReply
+#define ARTNET_SYNC_TIMEOUT_MS  4000  // Without ArtSync for this long, output immediately again
+#define ARTNET_SOURCE_TIMEOUT_MS 4000
 
 // Performance Configuration - use sdkconfig values
 #define LED_REFRESH_RATE_FPS    CONFIG_LED_REFRESH_RATE_FPS
@@ -166,6 +302,14 @@ const char* config_get_led_order(void);
 #define WIFI_RETRY_DELAY_MS     5000
 #define DHCP_TIMEOUT_MS         30000
 
+#if CONFIG_WIFI_IDLE_POWER_SAVE_NONE
+#define WIFI_IDLE_POWER_SAVE    WIFI_PS_NONE
+#elif CONFIG_WIFI_IDLE_POWER_SAVE_MAX_MODEM
+#define WIFI_IDLE_POWER_SAVE    WIFI_PS_MAX_MODEM
+#else
+#define WIFI_IDLE_POWER_SAVE    WIFI_PS_MIN_MODEM
+#endif
+
 // State Machine Timeouts
 #define STATE_TIMEOUT_WIFI_MS       30000
 #define STATE_TIMEOUT_DHCP_MS       30000
@@ -39,6 +39,12 @@ esp_err_t config_init(void)
     ESP_LOGI(TAG, "  LED Pin: %d", g_firmware_config.led_pin);
     ESP_LOGI(TAG, "  Max LEDs: %d", g_firmware_config.max_leds);
     ESP_LOGI(TAG, "  LED Order: %s", g_firmware_config.led_order);
+    if (g_firmware_config.static_ip_enabled) {
+        const uint8_t* ip = g_firmware_config.static_ip;
+        const uint8_t* gw = g_firmware_config.static_gateway;
+        ESP_LOGI(TAG, "  Static IP: %d.%d.%d.%d, gateway %d.%d.%d.%d",
+                 ip[0], ip[1], ip[2], ip[3], gw[0], gw[1], gw[2], gw[3]);
+    }
     
     return ESP_OK;
 }
@@ -228,3 +234,29 @@ const char* config_get_led_order(void)
 {
     return g_firmware_config.led_order;
 }
+
+// Addresses come back in network byte order, as lwIP stores them;
+// false means the address is to come from DHCP
+bool config_get_static_ip(uint32_t* ip, uint32_t* netmask, uint32_t* gateway, uint32_t* dns)
+{
+    const firmware_config_t* config = &g_firmware_config;
+    uint32_t addr;
+    memcpy(&addr, config->static_ip, sizeof(addr));
+    if (!config->static_ip_enabled || addr == 0) {
+        return false;
+    }
+
+    if (ip) {
+        *ip = addr;
+    }
+    if (netmask) {
+        memcpy(netmask, config->static_netmask, sizeof(*netmask));
+    }
+    if (gateway) {
+        memcpy(gateway, config->static_gateway, sizeof(*gateway));
+    }
+    if (dns) {
+        memcpy(dns, config->static_dns, sizeof(*dns));
+    }
+    return true;
+}
@@ -0,0 +1,314 @@
+#include "ddp_server.h"
+#include "config.h"
+#include "led_driver.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+static const char *TAG = "DDP_SERVER";
+
+#define DDP_STOP_TIMEOUT_MS     500     // Longest wait for the task to leave its loop
+
+// Global variables
+static int g_socket_fd = -1;
+static bool g_server_running = false;
+static uint16_t g_server_port = 0;
+static TaskHandle_t g_server_task_handle = NULL;
+static TaskHandle_t g_stop_waiter = NULL;     // Notified by the task once it has left its loop
+
+// Callbacks
+static ddp_data_cb_t g_data_callback = NULL;
+
+// Statistics
+static ddp_server_stats_t g_stats = {0};
+
+/**
+ * DDP server task
+ */
+static void ddp_server_task(void *pvParameters)
+{
+    uint8_t rx_buffer[DDP_MAX_PACKET_SIZE];
+    struct sockaddr_in source_addr;
+    socklen_t socklen = sizeof(source_addr);
+
+    ESP_LOGI(TAG, "DDP server task started on port %d", g_server_port);
+
+    while (g_server_running) {
+        // Blocks until a datagram arrives; the stop function sends one to wake it
+        int len = recvfrom(g_socket_fd, rx_buffer, sizeof(rx_buffer), 0,
+                           (struct sockaddr *)&source_addr, &socklen);
+
+        if (!g_server_running) {
+            break;
+        }
+
+        if (len < 0) {
+            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
+            break;
+        } else if (len == 0) {
+            continue;
+        }
+
+        int64_t rx_time_us = esp_timer_get_time();
+
+        g_stats.packets_received++;
+        g_stats.bytes_received += len;
+
+        // Discovery and status queries are not LED data; this receiver
+        // only implements the display path
+        if (len >= 1 && (rx_buffer[0] & (DDP_FLAG_QUERY | DDP_FLAG_REPLY))) {
+            ESP_LOGD(TAG, "Ignoring DDP query/reply: flags=0x%02X", rx_buffer[0]);
+            continue;
+        }
+
+        ddp_header_t header;
+        const uint8_t* payload;
+        if (!ddp_server_parse_packet(rx_buffer, len, &header, &payload)) {
+            ESP_LOGD(TAG, "Invalid DDP packet: %d bytes", len);
+            g_stats.invalid_packets++;
+            continue;
+        }
+
+        bool push = (header.flags & DDP_FLAG_PUSH) != 0;
+        size_t data_len = header.length;
+
+        if (data_len > 0) {
+            // Senders configured for a longer strip still get their
+            // leading pixels shown
+            size_t buffer_size = led_driver_get_buffer_size();
+            if (header.offset >= buffer_size) {
+                ESP_LOGD(TAG, "DDP offset %" PRIu32 " beyond LED buffer", header.offset);
+                g_stats.invalid_packets++;
+                if (!push) {
+                    continue;
+                }
+                data_len = 0;
+            } else if (header.offset + data_len > buffer_size) {
+                data_len = buffer_size - header.offset;
+            }
+        }
+
+        if (data_len > 0) {
+            g_stats.data_packets++;
+        }
+        // The receive time is only consumed by the transmit on push, so the
+        // two go under one hold of the pipeline lock
+        led_driver_lock();
+        if (push) {
+            g_stats.frames_pushed++;
+            led_driver_mark_frame_received(rx_time_us);
+        }
+
+        if (g_data_callback) {
+            g_data_callback(header.offset, payload, data_len, push);
+        }
+        led_driver_unlock();
+    }
+
+    ESP_LOGI(TAG, "DDP server task ended");
+    g_server_task_handle = NULL;
+    if (g_stop_waiter) {
+        xTaskNotifyGive(g_stop_waiter);
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t ddp_server_init(uint16_t port)
+{
+    if (g_socket_fd >= 0) {
+        ESP_LOGW(TAG, "DDP server already initialized");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Initializing DDP server on port %d", port);
+
+    g_server_port = port;
+
+    g_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (g_socket_fd < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    struct sockaddr_in dest_addr;
+    dest_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_port = htons(port);
+
+    int err = bind(g_socket_fd, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    if (err < 0) {
+        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
+        close(g_socket_fd);
+        g_socket_fd = -1;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "DDP server initialized on port %d", port);
+    return ESP_OK;
+}
+
+esp_err_t ddp_server_start(void)
+{
+    if (g_socket_fd < 0) {
+        ESP_LOGE(TAG, "DDP server not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (g_server_running) {
+        ESP_LOGW(TAG, "DDP server already running");
+        return ESP_OK;
+    }
+
+    g_server_running = true;
+
+    BaseType_t result = xTaskCreate(ddp_server_task,
+                                    "ddp_server",
+                                    4096,
+                                    NULL,
+                                    5,
+                                    &g_server_task_handle);
+
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create DDP server task - result: %d", result);
+        g_server_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "DDP server started");
+    return ESP_OK;
+}
+
+esp_err_t ddp_server_stop(void)
+{
+    if (!g_server_running) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Stopping DDP server");
+
+    g_stop_waiter = xTaskGetCurrentTaskHandle();
+    g_server_running = false;
+
+    // The task blocks in recvfrom() without a timeout; a datagram to
+    // itself over loopback wakes it to see the flag. It notifies once out of
+    // its loop, so it is never deleted holding the LED pipeline lock. The
+    // single byte is not a valid packet of any protocol, so should it arrive
+    // after a restart it is only counted as invalid.
+    if (g_server_task_handle) {
+        static const uint8_t wakeup = 0;
+        struct sockaddr_in self = {
+            .sin_family = AF_INET,
+            .sin_port = htons(g_server_port),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+        sendto(g_socket_fd, &wakeup, sizeof(wakeup), 0, (struct sockaddr *)&self, sizeof(self));
+
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DDP_STOP_TIMEOUT_MS)) == 0 && g_server_task_handle) {
+            ESP_LOGW(TAG, "DDP server task did not stop, deleting it");
+            vTaskDelete(g_server_task_handle);
+            g_server_task_handle = NULL;
+        }
+    }
+    g_stop_waiter = NULL;
+
+    ESP_LOGI(TAG, "DDP server stopped");
+    return ESP_OK;
+}
+
+bool ddp_server_is_running(void)
+{
+    return g_server_running;
+}
+
+bool ddp_server_parse_packet(const uint8_t* data, size_t len, ddp_header_t* header,
+                             const uint8_t** payload)
+{
+    if (!data || !header || !payload || len < DDP_HEADER_SIZE) {
+        return false;
+    }
+
+    header->flags = data[0];
+    header->sequence = data[1] & DDP_SEQUENCE_MASK;
+    header->data_type = data[2];
+    header->destination = data[3];
+    header->offset = ((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) |
+                     ((uint32_t)data[6] << 8) | data[7];
+    header->length = (data[8] << 8) | data[9];
+
+    if ((header->flags & DDP_FLAG_VERSION_MASK) != DDP_FLAG_VERSION_1) {
+        ESP_LOGD(TAG, "Unsupported DDP version: flags=0x%02X", header->flags);
+        return false;
+    }
+
+    if (header->flags & (DDP_FLAG_STORAGE | DDP_FLAG_QUERY | DDP_FLAG_REPLY)) {
+        return false;
+    }
+
+    if (header->destination != DDP_ID_DISPLAY && header->destination != DDP_ID_DEFAULT &&
+        header->destination != DDP_ID_ALL) {
+        ESP_LOGD(TAG, "Unsupported DDP destination: %d", header->destination);
+        return false;
+    }
+
+    // Bytes go into the buffer as-is, so only the element size matters;
+    // type 0 means undefined and is what most senders use
+    if (header->data_type != 0 &&
+        (header->data_type & DDP_TYPE_SIZE_MASK) != DDP_TYPE_SIZE_8BIT) {
+        ESP_LOGD(TAG, "Unsupported DDP data type: 0x%02X", header->data_type);
+        return false;
+    }
+
+    size_t header_size = DDP_HEADER_SIZE;
+    if (header->flags & DDP_FLAG_TIMECODE) {
+        header_size += DDP_TIMECODE_SIZE;
+    }
+
+    if (len < header_size || header->length > len - header_size) {
+        return false;
+    }
+
+    *payload = &data[header_size];
+    return true;
+}
+
+esp_err_t ddp_server_register_data_callback(ddp_data_cb_t callback)
+{
+    g_data_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t ddp_server_get_stats(ddp_server_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t ddp_server_deinit(void)
+{
+    ESP_LOGI(TAG, "Deinitializing DDP server");
+
+    if (g_server_running) {
+        ddp_server_stop();
+    }
+
+    if (g_socket_fd >= 0) {
+        close(g_socket_fd);
+        g_socket_fd = -1;
+    }
+
+    g_server_port = 0;
+    g_data_callback = NULL;
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    ESP_LOGI(TAG, "DDP server deinitialized");
+    return ESP_OK;
+}
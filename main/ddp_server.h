@@ -0,0 +1,97 @@
+#ifndef DDP_SERVER_H
+#define DDP_SERVER_H
+
+#include "esp_err.h"
+#include "config.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Parsed DDP packet header
+ */
+typedef struct {
+    uint8_t flags;          // DDP_FLAG_* bits
+    uint8_t sequence;       // 1-15, 0 if the sender does not number packets
+    uint8_t data_type;      // DDP data type byte
+    uint8_t destination;    // DDP destination id
+    uint32_t offset;        // Byte offset in LED buffer
+    uint16_t length;        // Length of data
+} ddp_header_t;
+
+/**
+ * DDP server statistics
+ */
+typedef struct {
+    uint32_t packets_received;  // Total packets received
+    uint32_t bytes_received;    // Total bytes received
+    uint32_t data_packets;      // Data packets written to the LED buffer
+    uint32_t frames_pushed;     // PUSH packets, i.e. frames displayed
+    uint32_t invalid_packets;   // Malformed, unsupported or out of range packets
+} ddp_server_stats_t;
+
+/**
+ * DDP data callback function type
+ * Called for every data packet in arrival order; push is true on the
+ * packet that completes the frame and should make it visible.
+ */
+typedef void (*ddp_data_cb_t)(uint32_t offset, const uint8_t* data, size_t len, bool push);
+
+/**
+ * Initialize DDP server
+ * @param port UDP port to bind to (DDP_PORT)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ddp_server_init(uint16_t port);
+
+/**
+ * Start DDP server
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ddp_server_start(void);
+
+/**
+ * Stop DDP server
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ddp_server_stop(void);
+
+/**
+ * Check if DDP server is running
+ * @return true if running, false otherwise
+ */
+bool ddp_server_is_running(void);
+
+/**
+ * Parse DDP packet
+ * Only version 1 display packets with 8-bit elements are accepted.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param header Pointer to store parsed header
+ * @param payload Pointer to store data pointer
+ * @return true if packet is a valid DDP data packet, false otherwise
+ */
+bool ddp_server_parse_packet(const uint8_t* data, size_t len, ddp_header_t* header,
+                             const uint8_t** payload);
+
+/**
+ * Register DDP data callback
+ * @param callback Callback function to register
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ddp_server_register_data_callback(ddp_data_cb_t callback);
+
+/**
+ * Get server statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ddp_server_get_stats(ddp_server_stats_t* stats);
+
+/**
+ * Deinitialize DDP server
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t ddp_server_deinit(void);
+
+#endif // DDP_SERVER_H
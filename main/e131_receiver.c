@@ -0,0 +1,474 @@
+#include "e131_receiver.h"
+#include "config.h"
+#include "led_driver.h"
+#include "universe_map.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+static const char *TAG = "E131";
+
+// Sequence numbers this far behind the last one are out of order rather
+// than a restarted sender (E1.31 section 6.7.2)
+#define E131_SEQUENCE_WINDOW    20
+#define E131_STOP_TIMEOUT_MS    500     // Longest wait for the task to leave its loop
+
+// Global variables
+static int g_socket_fd = -1;
+static bool g_running = false;
+static TaskHandle_t g_task_handle = NULL;
+static TaskHandle_t g_stop_waiter = NULL;     // Notified by the task once it has left its loop
+static universe_map_t g_map;
+static e131_data_cb_t g_data_callback = NULL;
+static e131_receiver_stats_t g_stats = {0};
+
+// The one source currently driving the LEDs
+static struct {
+    bool active;
+    uint8_t cid[E131_CID_SIZE];
+    uint8_t priority;
+    int64_t last_seen_us;
+    uint16_t sync_address;      // From its latest data packet
+} g_source = {0};
+
+// Per mapped universe
+static uint8_t g_last_sequence[UNIVERSE_MAP_MAX_UNIVERSES];
+static uint32_t g_sequence_valid = 0;   // Bit per universe index
+static uint32_t g_received = 0;         // Universes written since the last commit
+static uint16_t g_joined_sync_group = 0;
+
+static uint16_t get_be16(const uint8_t* p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+static uint32_t get_be32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/**
+ * Join or leave the multicast group of a universe
+ */
+static int set_membership(uint16_t universe, bool join)
+{
+    struct ip_mreq mreq = {0};
+    mreq.imr_multiaddr.s_addr = htonl(E131_MULTICAST_PREFIX | universe);
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    int err = setsockopt(g_socket_fd, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+                         &mreq, sizeof(mreq));
+    if (err < 0 && join) {
+        ESP_LOGW(TAG, "Failed to join universe %d multicast group: errno %d", universe, errno);
+    }
+    return err;
+}
+
+/**
+ * Validate the root layer shared by data and sync packets
+ * @return Root layer vector, or 0 if the packet is not E1.31
+ */
+static uint32_t parse_root_layer(const uint8_t* data, size_t len)
+{
+    if (len < E131_SYNC_PACKET_SIZE || get_be16(&data[0]) != 0x0010 || get_be16(&data[2]) != 0 ||
+        memcmp(&data[4], E131_ACN_ID, E131_ACN_ID_SIZE) != 0) {
+        return 0;
+    }
+    return get_be32(&data[18]);
+}
+
+/**
+ * Show the frame in the LED buffer
+ * The receive time is only consumed by this push's transmit, so both go
+ * under one hold of the LED pipeline lock.
+ */
+static void commit_frame(int64_t rx_time_us)
+{
+    g_received = 0;
+    g_stats.frames_committed++;
+    led_driver_lock();
+    led_driver_mark_frame_received(rx_time_us);
+    if (g_data_callback) {
+        g_data_callback(0, NULL, 0, true);
+    }
+    led_driver_unlock();
+}
+
+/**
+ * Decide whether a sender may drive the LEDs
+ * The highest priority wins; between equal priorities the first source
+ * keeps control until it goes silent or terminates.
+ */
+static bool arbitrate(const e131_data_packet_t* packet, int64_t now_us)
+{
+    bool same = g_source.active && memcmp(g_source.cid, packet->cid, E131_CID_SIZE) == 0;
+
+    if (g_source.active && !same &&
+        now_us - g_source.last_seen_us > (int64_t)E131_SOURCE_TIMEOUT_MS * 1000) {
+        ESP_LOGI(TAG, "Source timed out");
+        g_source.active = false;
+    }
+
+    if (packet->options & E131_OPTION_TERMINATED) {
+        if (same) {
+            ESP_LOGI(TAG, "Source terminated stream");
+            g_source.active = false;
+        }
+        return false;
+    }
+
+    if (g_source.active && !same) {
+        if (packet->priority <= g_source.priority) {
+            return false;
+        }
+        ESP_LOGI(TAG, "Higher priority source took over (%d > %d)",
+                 packet->priority, g_source.priority);
+    }
+
+    if (!same) {
+        memcpy(g_source.cid, packet->cid, E131_CID_SIZE);
+        g_source.active = true;
+        g_sequence_valid = 0;
+        g_received = 0;
+    }
+    g_source.priority = packet->priority;
+    g_source.last_seen_us = now_us;
+    return true;
+}
+
+static void handle_data_packet(const e131_data_packet_t* packet, int64_t rx_time_us)
+{
+    const universe_map_entry_t* entry = universe_map_lookup(&g_map, packet->universe);
+    if (!entry || (packet->options & E131_OPTION_PREVIEW) || !arbitrate(packet, rx_time_us)) {
+        g_stats.ignored_packets++;
+        return;
+    }
+
+    size_t index = universe_map_index(&g_map, entry);
+    uint32_t bit = 1UL << index;
+
+    if (g_sequence_valid & bit) {
+        int8_t ahead = (int8_t)(packet->sequence - g_last_sequence[index]);
+        if (ahead <= 0 && ahead > -E131_SEQUENCE_WINDOW) {
+            g_stats.sequence_errors++;
+            return;
+        }
+    }
+    g_last_sequence[index] = packet->sequence;
+    g_sequence_valid |= bit;
+
+    if (packet->sync_address != g_source.sync_address) {
+        g_source.sync_address = packet->sync_address;
+        if (g_joined_sync_group && g_joined_sync_group != packet->sync_address) {
+            set_membership(g_joined_sync_group, false);
+            g_joined_sync_group = 0;
+        }
+        // The sync universe is usually not one of ours
+        if (packet->sync_address && !universe_map_lookup(&g_map, packet->sync_address) &&
+            set_membership(packet->sync_address, true) == 0) {
+            g_joined_sync_group = packet->sync_address;
+        }
+    }
+
+    // Other receivers write the same buffer; hold the lock from showing
+    // the previous frame to this universe's data and, without sync, the
+    // push that completes the frame
+    led_driver_lock();
+
+    // A universe arriving twice means the previous frame is as complete
+    // as it will get; with sync this only happens if a sync packet was lost
+    if (g_received & bit) {
+        commit_frame(rx_time_us);
+    }
+
+    size_t len = packet->len < entry->length ? packet->len : entry->length;
+    if (g_data_callback && len > 0) {
+        g_data_callback(entry->byte_offset, packet->data, len, false);
+    }
+    g_received |= bit;
+    g_stats.data_packets++;
+
+    if (!g_source.sync_address && g_received == universe_map_all_mask(&g_map)) {
+        commit_frame(rx_time_us);
+    }
+    led_driver_unlock();
+}
+
+static void handle_sync_packet(const uint8_t* data, size_t len, int64_t rx_time_us)
+{
+    if (len < E131_SYNC_PACKET_SIZE || get_be32(&data[40]) != E131_FRAMING_VECTOR_SYNC) {
+        g_stats.invalid_packets++;
+        return;
+    }
+
+    uint16_t sync_address = get_be16(&data[45]);
+    if (!g_source.active || memcmp(g_source.cid, &data[22], E131_CID_SIZE) != 0 ||
+        sync_address != g_source.sync_address || sync_address == 0) {
+        g_stats.ignored_packets++;
+        return;
+    }
+
+    g_stats.sync_packets++;
+    if (g_received) {
+        commit_frame(rx_time_us);
+    }
+}
+
+/**
+ * E1.31 receiver task
+ */
+static void e131_receiver_task(void *pvParameters)
+{
+    uint8_t rx_buffer[E131_MAX_PACKET_SIZE];
+
+    ESP_LOGI(TAG, "E1.31 receiver task started");
+
+    while (g_running) {
+        // Blocks until a datagram arrives; the stop function sends one to wake it
+        int len = recv(g_socket_fd, rx_buffer, sizeof(rx_buffer), 0);
+
+        if (!g_running) {
+            break;
+        }
+
+        if (len < 0) {
+            ESP_LOGE(TAG, "recv failed: errno %d", errno);
+            break;
+        }
+
+        int64_t rx_time_us = esp_timer_get_time();
+        g_stats.packets_received++;
+
+        uint32_t vector = parse_root_layer(rx_buffer, len);
+        if (vector == E131_ROOT_VECTOR_DATA) {
+            e131_data_packet_t packet;
+            if (e131_receiver_parse_data_packet(rx_buffer, len, &packet)) {
+                handle_data_packet(&packet, rx_time_us);
+            } else {
+                g_stats.invalid_packets++;
+            }
+        } else if (vector == E131_ROOT_VECTOR_EXTENDED) {
+            // Universe discovery shares this vector; only sync is used
+            handle_sync_packet(rx_buffer, len, rx_time_us);
+        } else {
+            g_stats.invalid_packets++;
+        }
+    }
+
+    ESP_LOGI(TAG, "E1.31 receiver task ended");
+    g_task_handle = NULL;
+    if (g_stop_waiter) {
+        xTaskNotifyGive(g_stop_waiter);
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t e131_receiver_init(uint16_t first_universe)
+{
+    if (g_socket_fd >= 0) {
+        ESP_LOGW(TAG, "E1.31 receiver already initialized");
+        return ESP_OK;
+    }
+
+    esp_err_t ret = universe_map_build(&g_map, first_universe, led_driver_get_buffer_size(),
+                                       LED_CHANNELS_PER_LED);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    g_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (g_socket_fd < 0) {
+        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    struct sockaddr_in bind_addr;
+    bind_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    bind_addr.sin_family = AF_INET;
+    bind_addr.sin_port = htons(E131_PORT);
+
+    if (bind(g_socket_fd, (struct sockaddr *)&bind_addr, sizeof(bind_addr)) < 0) {
+        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
+        close(g_socket_fd);
+        g_socket_fd = -1;
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "E1.31 receiver initialized on port %d", E131_PORT);
+    return ESP_OK;
+}
+
+esp_err_t e131_receiver_start(void)
+{
+    if (g_socket_fd < 0) {
+        ESP_LOGE(TAG, "E1.31 receiver not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (g_running) {
+        return ESP_OK;
+    }
+
+    // Groups can only be joined once the interface has an address
+    for (size_t i = 0; i < g_map.count; i++) {
+        set_membership(g_map.entries[i].universe, true);
+    }
+
+    memset(&g_source, 0, sizeof(g_source));
+    g_sequence_valid = 0;
+    g_received = 0;
+    g_running = true;
+
+    BaseType_t result = xTaskCreate(e131_receiver_task, "e131", 4096, NULL, 5, &g_task_handle);
+    if (result != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create E1.31 receiver task - result: %d", result);
+        g_running = false;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "E1.31 receiver started");
+    return ESP_OK;
+}
+
+esp_err_t e131_receiver_stop(void)
+{
+    if (!g_running) {
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Stopping E1.31 receiver");
+
+    g_stop_waiter = xTaskGetCurrentTaskHandle();
+    g_running = false;
+
+    // The task blocks in recv() without a timeout; a datagram to
+    // itself over loopback wakes it to see the flag. It notifies once out of
+    // its loop, so it is never deleted holding the LED pipeline lock. The
+    // single byte is not a valid packet of any protocol, so should it arrive
+    // after a restart it is only counted as invalid.
+    if (g_task_handle) {
+        static const uint8_t wakeup = 0;
+        struct sockaddr_in self = {
+            .sin_family = AF_INET,
+            .sin_port = htons(E131_PORT),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+        sendto(g_socket_fd, &wakeup, sizeof(wakeup), 0, (struct sockaddr *)&self, sizeof(self));
+
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(E131_STOP_TIMEOUT_MS)) == 0 && g_task_handle) {
+            ESP_LOGW(TAG, "E1.31 receiver task did not stop, deleting it");
+            vTaskDelete(g_task_handle);
+            g_task_handle = NULL;
+        }
+    }
+    g_stop_waiter = NULL;
+
+    for (size_t i = 0; i < g_map.count; i++) {
+        set_membership(g_map.entries[i].universe, false);
+    }
+    if (g_joined_sync_group) {
+        set_membership(g_joined_sync_group, false);
+        g_joined_sync_group = 0;
+    }
+
+    ESP_LOGI(TAG, "E1.31 receiver stopped");
+    return ESP_OK;
+}
+
+esp_err_t e131_receiver_rejoin_multicast(void)
+{
+    if (!g_running) {
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < g_map.count; i++) {
+        set_membership(g_map.entries[i].universe, false);
+        set_membership(g_map.entries[i].universe, true);
+    }
+    if (g_joined_sync_group) {
+        set_membership(g_joined_sync_group, false);
+        set_membership(g_joined_sync_group, true);
+    }
+
+    ESP_LOGI(TAG, "Rejoined multicast groups of %d universes", (int)g_map.count);
+    return ESP_OK;
+}
+
+bool e131_receiver_is_running(void)
+{
+    return g_running;
+}
+
+bool e131_receiver_parse_data_packet(const uint8_t* data, size_t len, e131_data_packet_t* packet)
+{
+    if (!data || !packet || len < E131_DATA_HEADER_SIZE ||
+        parse_root_layer(data, len) != E131_ROOT_VECTOR_DATA) {
+        return false;
+    }
+
+    if (get_be32(&data[40]) != E131_FRAMING_VECTOR_DATA || data[117] != E131_DMP_VECTOR ||
+        data[118] != E131_DMP_ADDRESS_TYPE || get_be16(&data[119]) != 0 ||
+        get_be16(&data[121]) != 1) {
+        return false;
+    }
+
+    // Property values include the start code
+    uint16_t value_count = get_be16(&data[123]);
+    if (value_count < 1 || value_count - 1 > DMX_UNIVERSE_SIZE ||
+        value_count - 1 > len - E131_DATA_HEADER_SIZE) {
+        return false;
+    }
+
+    // Alternate start codes (e.g. per-channel priority) are not DMX levels
+    if (data[125] != 0) {
+        return false;
+    }
+
+    packet->cid = &data[22];
+    packet->priority = data[108];
+    packet->sync_address = get_be16(&data[109]);
+    packet->sequence = data[111];
+    packet->options = data[112];
+    packet->universe = get_be16(&data[113]);
+    packet->data = &data[E131_DATA_HEADER_SIZE];
+    packet->len = value_count - 1;
+    return true;
+}
+
+esp_err_t e131_receiver_register_data_callback(e131_data_cb_t callback)
+{
+    g_data_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t e131_receiver_get_stats(e131_receiver_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t e131_receiver_deinit(void)
+{
+    if (g_running) {
+        e131_receiver_stop();
+    }
+
+    if (g_socket_fd >= 0) {
+        close(g_socket_fd);
+        g_socket_fd = -1;
+    }
+
+    g_data_callback = NULL;
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    ESP_LOGI(TAG, "E1.31 receiver deinitialized");
+    return ESP_OK;
+}
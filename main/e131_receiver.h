@@ -0,0 +1,108 @@
+#ifndef E131_RECEIVER_H
+#define E131_RECEIVER_H
+
+#include "esp_err.h"
+#include "config.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Parsed E1.31 data packet
+ */
+typedef struct {
+    const uint8_t* cid;         // Sender component id, E131_CID_SIZE bytes
+    uint8_t priority;           // 0-200, higher wins
+    uint16_t sync_address;      // Universe whose sync packets commit this data, 0 for none
+    uint8_t sequence;
+    uint8_t options;            // E131_OPTION_* bits
+    uint16_t universe;
+    const uint8_t* data;        // DMX slots after the start code
+    size_t len;                 // Number of DMX slots
+} e131_data_packet_t;
+
+/**
+ * E1.31 receiver statistics
+ */
+typedef struct {
+    uint32_t packets_received;  // Total packets received
+    uint32_t data_packets;      // Data packets written to the LED buffer
+    uint32_t sync_packets;      // Sync packets that committed a frame
+    uint32_t frames_committed;  // Frames displayed
+    uint32_t ignored_packets;   // Valid packets from losing sources, preview data or other universes
+    uint32_t sequence_errors;   // Out-of-order packets dropped
+    uint32_t invalid_packets;   // Malformed or unsupported packets
+} e131_receiver_stats_t;
+
+/**
+ * E1.31 data callback function type
+ * Called for every accepted universe in arrival order; push is true when
+ * the frame is complete and should be made visible. A push-only call has
+ * len 0.
+ */
+typedef void (*e131_data_cb_t)(uint32_t offset, const uint8_t* data, size_t len, bool push);
+
+/**
+ * Initialize E1.31 receiver
+ * Must be called after the LED count is set; the universe table is
+ * computed from the LED buffer size.
+ * @param first_universe Universe carrying the first LED
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t e131_receiver_init(uint16_t first_universe);
+
+/**
+ * Start E1.31 receiver and join the universes' multicast groups
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t e131_receiver_start(void);
+
+/**
+ * Stop E1.31 receiver and leave its multicast groups
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t e131_receiver_stop(void);
+
+/**
+ * Renew the multicast group memberships after the IP address changed
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t e131_receiver_rejoin_multicast(void);
+
+/**
+ * Check if E1.31 receiver is running
+ * @return true if running, false otherwise
+ */
+bool e131_receiver_is_running(void);
+
+/**
+ * Parse E1.31 data packet
+ * Only null start code (DMX) data is accepted.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param packet Pointer to store parsed packet
+ * @return true if packet is a valid E1.31 data packet, false otherwise
+ */
+bool e131_receiver_parse_data_packet(const uint8_t* data, size_t len, e131_data_packet_t* packet);
+
+/**
+ * Register E1.31 data callback
+ * @param callback Callback function to register
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t e131_receiver_register_data_callback(e131_data_cb_t callback);
+
+/**
+ * Get receiver statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t e131_receiver_get_stats(e131_receiver_stats_t* stats);
+
+/**
+ * Deinitialize E1.31 receiver
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t e131_receiver_deinit(void);
+
+#endif // E131_RECEIVER_H
@@ -0,0 +1,256 @@
+#include "fec_decoder.h"
+#include "config.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "FEC_DECODER";
+
+#define FEC_MAX_GROUPS          4       // Parity groups in flight, about two frames
+#define FEC_GROUP_TIMEOUT_MS    100     // Groups still open this long are given up
+#define FEC_LENGTH_SIZE         2       // Every protected datagram is prefixed with its length
+
+/**
+ * One parity group being collected
+ * The accumulator holds the XOR of [length][datagram] of every packet
+ * folded in so far, zero padded to the longest one. With the parity
+ * folded in and one packet missing, it is exactly the missing packet.
+ */
+typedef struct {
+    bool in_use;
+    uint32_t addr;
+    uint16_t port;
+    uint16_t frame_id;
+    uint8_t group;
+    uint8_t size;
+    uint32_t received;          // Bit n: data packet n folded in
+    bool parity;                // Parity folded in
+    bool done;                  // Every packet present, by arrival or rebuild
+    bool recovered;             // A packet was rebuilt
+    TickType_t started;
+    uint8_t acc[FEC_LENGTH_SIZE + FEC_MAX_PACKET_SIZE];
+} fec_group_t;
+
+// Global variables
+static fec_group_t g_groups[FEC_MAX_GROUPS];
+static fec_decoder_stats_t g_stats = {0};
+
+static bool same_source(const fec_group_t* g, const struct sockaddr_in* source)
+{
+    return g->addr == source->sin_addr.s_addr && g->port == source->sin_port;
+}
+
+/**
+ * Close every group of a frame and count the frame's outcome once
+ */
+static void retire_frame(const fec_group_t* first)
+{
+    uint32_t addr = first->addr;
+    uint16_t port = first->port;
+    uint16_t frame_id = first->frame_id;
+    bool lost = false;
+    bool recovered = false;
+
+    for (int i = 0; i < FEC_MAX_GROUPS; i++) {
+        fec_group_t* g = &g_groups[i];
+        if (g->in_use && g->addr == addr && g->port == port && g->frame_id == frame_id) {
+            lost |= !g->done;
+            recovered |= g->recovered;
+            g->in_use = false;
+        }
+    }
+
+    if (lost) {
+        g_stats.frames_unrecoverable++;
+        ESP_LOGD(TAG, "Frame %u unrecoverable", frame_id);
+    } else if (recovered) {
+        g_stats.frames_recovered++;
+    }
+}
+
+/**
+ * Close groups that timed out or belong to frames older than frame_id
+ * @return false if frame_id itself is older than a frame already seen
+ */
+static bool retire_stale(const struct sockaddr_in* source, uint16_t frame_id, TickType_t now)
+{
+    bool current = true;
+
+    for (int i = 0; i < FEC_MAX_GROUPS; i++) {
+        fec_group_t* g = &g_groups[i];
+        if (!g->in_use) {
+            continue;
+        }
+        int16_t age = (int16_t)(frame_id - g->frame_id);
+        if (now - g->started > pdMS_TO_TICKS(FEC_GROUP_TIMEOUT_MS)) {
+            retire_frame(g);
+        } else if (same_source(g, source)) {
+            if (age > 0) {
+                retire_frame(g);
+            } else if (age < 0) {
+                current = false;
+            }
+        }
+    }
+
+    return current;
+}
+
+/**
+ * Find a group, opening it in a free slot (or the oldest) if it is new
+ */
+static fec_group_t* get_group(const struct sockaddr_in* source, uint16_t frame_id, uint8_t group,
+                              uint8_t size, TickType_t now)
+{
+    if (!retire_stale(source, frame_id, now)) {
+        return NULL;  // Late packet of a frame already given up
+    }
+
+    fec_group_t* oldest = &g_groups[0];
+    for (int i = 0; i < FEC_MAX_GROUPS; i++) {
+        fec_group_t* g = &g_groups[i];
+        if (g->in_use && same_source(g, source) && g->frame_id == frame_id && g->group == group) {
+            return g->size == size ? g : NULL;
+        }
+        if (!g->in_use || (oldest->in_use && g->started < oldest->started)) {
+            oldest = g;
+        }
+    }
+
+    if (oldest->in_use) {
+        retire_frame(oldest);
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->in_use = true;
+    oldest->addr = source->sin_addr.s_addr;
+    oldest->port = source->sin_port;
+    oldest->frame_id = frame_id;
+    oldest->group = group;
+    oldest->size = size;
+    oldest->started = now;
+    return oldest;
+}
+
+static void fold(fec_group_t* g, const uint8_t* body, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        g->acc[i] ^= body[i];
+    }
+}
+
+/**
+ * Mark the group done if it is complete, rebuilding the one missing
+ * packet when the parity allows it
+ */
+static void try_complete(fec_group_t* g, const uint8_t** recovered, size_t* recovered_len)
+{
+    uint32_t missing = ((1UL << g->size) - 1) & ~g->received;
+
+    if (missing == 0) {
+        g->done = true;
+        return;
+    }
+    if (!g->parity || (missing & (missing - 1)) != 0) {
+        return;  // Wait for more, or two or more are gone for good
+    }
+
+    size_t len = ((size_t)g->acc[0] << 8) | g->acc[1];
+    g->done = true;
+    if (len == 0 || len > FEC_MAX_PACKET_SIZE) {
+        ESP_LOGW(TAG, "Rebuilt packet has bad length %d, frame %u", (int)len, g->frame_id);
+        return;
+    }
+
+    g->recovered = true;
+    g_stats.recovered_packets++;
+    *recovered = &g->acc[FEC_LENGTH_SIZE];
+    *recovered_len = len;
+    ESP_LOGD(TAG, "Rebuilt %d-byte packet of frame %u, group %d", (int)len, g->frame_id, g->group);
+}
+
+esp_err_t fec_decoder_init(void)
+{
+    fec_decoder_reset();
+    ESP_LOGI(TAG, "FEC decoder initialized, %d groups of up to %d packets",
+             FEC_MAX_GROUPS, FEC_MAX_GROUP_SIZE);
+    return ESP_OK;
+}
+
+void fec_decoder_add_packet(const struct sockaddr_in* source, uint16_t frame_id, uint8_t group,
+                            uint8_t index, uint8_t size, const uint8_t* data, size_t len,
+                            const uint8_t** recovered, size_t* recovered_len)
+{
+    *recovered = NULL;
+    *recovered_len = 0;
+
+    if (len > FEC_MAX_PACKET_SIZE || index >= size || size > FEC_MAX_GROUP_SIZE) {
+        return;
+    }
+
+    fec_group_t* g = get_group(source, frame_id, group, size, xTaskGetTickCount());
+    if (!g || g->done || (g->received & (1UL << index))) {
+        return;
+    }
+
+    uint8_t length[FEC_LENGTH_SIZE] = { len >> 8, len & 0xFF };
+    fold(g, length, FEC_LENGTH_SIZE);
+    for (size_t i = 0; i < len; i++) {
+        g->acc[FEC_LENGTH_SIZE + i] ^= data[i];
+    }
+    g->received |= 1UL << index;
+
+    try_complete(g, recovered, recovered_len);
+}
+
+bool fec_decoder_handle_parity(const uint8_t* data, size_t len, const struct sockaddr_in* source,
+                               const uint8_t** recovered, size_t* recovered_len)
+{
+    *recovered = NULL;
+    *recovered_len = 0;
+
+    if (len < FEC_PARITY_HEADER_SIZE + FEC_LENGTH_SIZE || data[0] != PACKET_TYPE_FEC_PARITY ||
+        data[1] != FEC_PARITY_VERSION) {
+        return false;
+    }
+
+    uint16_t frame_id = (data[2] << 8) | data[3];
+    uint8_t group = data[4];
+    uint8_t size = data[5];
+    size_t parity_len = len - FEC_PARITY_HEADER_SIZE;
+
+    if (size == 0 || size > FEC_MAX_GROUP_SIZE || parity_len > sizeof(g_groups[0].acc)) {
+        return false;
+    }
+
+    g_stats.parity_packets++;
+
+    fec_group_t* g = get_group(source, frame_id, group, size, xTaskGetTickCount());
+    if (!g || g->done || g->parity) {
+        return true;
+    }
+
+    fold(g, &data[FEC_PARITY_HEADER_SIZE], parity_len);
+    g->parity = true;
+
+    try_complete(g, recovered, recovered_len);
+    return true;
+}
+
+esp_err_t fec_decoder_get_stats(fec_decoder_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t fec_decoder_reset(void)
+{
+    memset(g_groups, 0, sizeof(g_groups));
+    memset(&g_stats, 0, sizeof(g_stats));
+    return ESP_OK;
+}
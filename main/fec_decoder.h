@@ -0,0 +1,71 @@
+#ifndef FEC_DECODER_H
+#define FEC_DECODER_H
+
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * FEC decoder statistics
+ */
+typedef struct {
+    uint32_t parity_packets;        // Parity packets received
+    uint32_t recovered_packets;     // Data packets rebuilt from parity
+    uint32_t frames_recovered;      // Frames made whole by at least one rebuilt packet
+    uint32_t frames_unrecoverable;  // Frames with a group missing two or more packets, or one without parity
+} fec_decoder_stats_t;
+
+/**
+ * Initialize FEC decoder
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fec_decoder_init(void);
+
+/**
+ * Fold a received data packet into its parity group
+ * Must be called from a single task (the UDP server task). When the packet
+ * leaves exactly one packet of the group missing and the group's parity
+ * has already arrived, the missing packet is rebuilt.
+ * @param source Address the packet came from
+ * @param frame_id Frame the packet belongs to
+ * @param group Parity group within the frame
+ * @param index Position of the packet in the group
+ * @param size Data packets in the group
+ * @param data Whole datagram, header included
+ * @param len Length of the datagram
+ * @param recovered Set to the rebuilt datagram, or NULL; valid until the next call
+ * @param recovered_len Set to the length of the rebuilt datagram
+ */
+void fec_decoder_add_packet(const struct sockaddr_in* source, uint16_t frame_id, uint8_t group,
+                            uint8_t index, uint8_t size, const uint8_t* data, size_t len,
+                            const uint8_t** recovered, size_t* recovered_len);
+
+/**
+ * Handle a received parity packet (0x0C)
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param source Address the packet came from
+ * @param recovered Set to the rebuilt datagram, or NULL; valid until the next call
+ * @param recovered_len Set to the length of the rebuilt datagram
+ * @return true if packet was a valid parity packet, false otherwise
+ */
+bool fec_decoder_handle_parity(const uint8_t* data, size_t len, const struct sockaddr_in* source,
+                               const uint8_t** recovered, size_t* recovered_len);
+
+/**
+ * Get FEC decoder statistics
+ * Frames are counted once none of their groups is pending any more.
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fec_decoder_get_stats(fec_decoder_stats_t* stats);
+
+/**
+ * Reset FEC decoder statistics and pending groups
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t fec_decoder_reset(void);
+
+#endif // FEC_DECODER_H
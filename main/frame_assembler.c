@@ -0,0 +1,367 @@
+#include "frame_assembler.h"
+#include "config.h"
+#include "led_driver.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "FRAME_ASSEMBLER";
+
+#define FRAME_ASSEMBLER_SLOTS   3       // Frames being assembled at once
+#define NACK_DELAY_US           ((int64_t)CONFIG_RELIABLE_NACK_DELAY_MS * 1000)
+#define FRAME_DEADLINE_US       ((int64_t)CONFIG_RELIABLE_FRAME_DEADLINE_MS * 1000)
+#define TIMER_RETRY_US          1000    // Timer found the assembler busy
+#define FRAME_RESTART_GAP       256     // Frame ids this far behind mean the sender restarted
+
+typedef struct {
+    bool in_use;
+    struct sockaddr_in source;
+    uint16_t frame_id;
+    uint8_t count;              // Fragments in the frame
+    uint32_t received;          // Bit n: fragment n present
+    bool timed;
+    uint64_t pts_us;
+    bool nacked;                // At least one NACK was sent
+    int64_t first_rx_us;
+    int64_t next_nack_us;
+    int64_t deadline_us;
+    led_data_run_t fragments[FRAME_MAX_FRAGMENTS];
+    uint8_t* frame;             // Staging buffer, LED buffer sized
+} pending_frame_t;
+
+// Global variables
+static bool g_initialized = false;
+static bool g_allocated = false;
+static size_t g_frame_size = 0;
+static SemaphoreHandle_t g_mutex = NULL;
+static esp_timer_handle_t g_timer = NULL;
+static frame_assembler_deliver_cb_t g_deliver = NULL;
+static pending_frame_t g_frames[FRAME_ASSEMBLER_SLOTS];
+static frame_assembler_stats_t g_stats = {0};
+
+// Last frame delivered, so its stragglers and older frames are refused
+static bool g_delivered = false;
+static struct sockaddr_in g_delivered_source;
+static uint16_t g_delivered_frame = 0;
+
+static bool same_source(const struct sockaddr_in* a, const struct sockaddr_in* b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+static uint32_t full_mask(uint8_t count)
+{
+    return count >= 32 ? UINT32_MAX : (1UL << count) - 1;
+}
+
+static void put_be(uint8_t* out, uint32_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static esp_err_t allocate_frames(void)
+{
+    g_frame_size = led_driver_get_buffer_size();
+    for (int i = 0; i < FRAME_ASSEMBLER_SLOTS; i++) {
+        g_frames[i].frame = malloc(g_frame_size);
+        if (!g_frames[i].frame) {
+            ESP_LOGE(TAG, "Failed to allocate staging buffer (%" PRIu32 " bytes)",
+                     (uint32_t)g_frame_size);
+            for (int j = 0; j < i; j++) {
+                free(g_frames[j].frame);
+                g_frames[j].frame = NULL;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    g_allocated = true;
+    ESP_LOGI(TAG, "Frame assembler allocated: %d frames x %" PRIu32 " bytes",
+             FRAME_ASSEMBLER_SLOTS, (uint32_t)g_frame_size);
+    return ESP_OK;
+}
+
+static void drop_frame(pending_frame_t* frame, const char* reason)
+{
+    ESP_LOGD(TAG, "Dropping frame %u (%s): have 0x%08" PRIX32 " of %d fragments",
+             frame->frame_id, reason, frame->received, frame->count);
+    frame->in_use = false;
+    g_stats.frames_dropped++;
+}
+
+static void send_nack(pending_frame_t* frame, int64_t now)
+{
+    uint8_t nack[NACK_PACKET_SIZE];
+    nack[0] = PACKET_TYPE_NACK;
+    nack[1] = NACK_VERSION;
+    put_be(&nack[2], frame->frame_id, 2);
+    nack[4] = frame->count;
+    put_be(&nack[5], full_mask(frame->count) & ~frame->received, 4);
+
+    udp_server_send_to(&frame->source, nack, sizeof(nack));
+    frame->nacked = true;
+    frame->next_nack_us = now + NACK_DELAY_US;
+    g_stats.nacks_sent++;
+}
+
+/**
+ * Arm the timer for the earliest NACK or deadline; caller holds the mutex
+ */
+static void schedule_next_locked(void)
+{
+    int64_t next = INT64_MAX;
+    for (int i = 0; i < FRAME_ASSEMBLER_SLOTS; i++) {
+        const pending_frame_t* frame = &g_frames[i];
+        if (frame->in_use) {
+            int64_t due = frame->next_nack_us < frame->deadline_us ? frame->next_nack_us
+                                                                   : frame->deadline_us;
+            if (due < next) {
+                next = due;
+            }
+        }
+    }
+
+    esp_timer_stop(g_timer);
+    if (next != INT64_MAX) {
+        int64_t delay = next - esp_timer_get_time();
+        esp_timer_start_once(g_timer, delay > 0 ? (uint64_t)delay : 0);
+    }
+}
+
+/**
+ * NACK and deadline timer callback (esp_timer task)
+ */
+static void frame_timer_callback(void* arg)
+{
+    // Never hold up other esp_timer callbacks behind a frame delivery
+    if (xSemaphoreTake(g_mutex, 0) != pdTRUE) {
+        esp_timer_start_once(g_timer, TIMER_RETRY_US);
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < FRAME_ASSEMBLER_SLOTS; i++) {
+        pending_frame_t* frame = &g_frames[i];
+        if (!frame->in_use) {
+            continue;
+        }
+        if (now >= frame->deadline_us) {
+            drop_frame(frame, "deadline");
+        } else if (now >= frame->next_nack_us) {
+            send_nack(frame, now);
+        }
+    }
+
+    schedule_next_locked();
+    xSemaphoreGive(g_mutex);
+}
+
+/**
+ * Hand a complete frame over and drop older frames still missing
+ * fragments, so frames are never shown out of order
+ */
+static void deliver_frame(pending_frame_t* frame)
+{
+    for (int i = 0; i < FRAME_ASSEMBLER_SLOTS; i++) {
+        pending_frame_t* other = &g_frames[i];
+        if (other != frame && other->in_use && same_source(&other->source, &frame->source) &&
+            (int16_t)(other->frame_id - frame->frame_id) < 0) {
+            drop_frame(other, "superseded");
+        }
+    }
+
+    led_data_run_t runs[FRAME_MAX_FRAGMENTS];
+    size_t run_count = 0;
+    for (int i = 0; i < frame->count; i++) {
+        if (frame->fragments[i].len > 0) {
+            runs[run_count++] = frame->fragments[i];
+        }
+    }
+
+    g_stats.frames_completed++;
+    if (frame->nacked) {
+        g_stats.frames_recovered++;
+    }
+
+    g_delivered = true;
+    g_delivered_source = frame->source;
+    g_delivered_frame = frame->frame_id;
+    frame->in_use = false;
+
+    if (g_deliver) {
+        g_deliver(frame->timed, frame->pts_us, runs, run_count, frame->first_rx_us);
+    }
+}
+
+/**
+ * Find the frame's slot, opening one if it is new
+ */
+static pending_frame_t* get_frame(const struct sockaddr_in* source,
+                                  const led_data_ext_header_t* header, int64_t now)
+{
+    pending_frame_t* slot = NULL;
+    for (int i = 0; i < FRAME_ASSEMBLER_SLOTS; i++) {
+        pending_frame_t* frame = &g_frames[i];
+        if (frame->in_use && same_source(&frame->source, source) &&
+            frame->frame_id == header->frame_id) {
+            return frame->count == header->frag_count ? frame : NULL;
+        }
+        if (!frame->in_use) {
+            slot = frame;
+        } else if (!slot || (slot->in_use && frame->first_rx_us < slot->first_rx_us)) {
+            slot = frame;
+        }
+    }
+
+    if (slot->in_use) {
+        drop_frame(slot, "no free slot");
+    }
+
+    memset(slot->fragments, 0, sizeof(slot->fragments));
+    slot->in_use = true;
+    slot->source = *source;
+    slot->frame_id = header->frame_id;
+    slot->count = header->frag_count;
+    slot->received = 0;
+    slot->timed = (header->flags & LED_DATA_EXT_FLAG_TIMESTAMP) != 0;
+    slot->pts_us = header->pts_us;
+    slot->nacked = false;
+    slot->first_rx_us = now;
+    slot->next_nack_us = now + NACK_DELAY_US;
+    slot->deadline_us = now + FRAME_DEADLINE_US;
+    return slot;
+}
+
+esp_err_t frame_assembler_init(frame_assembler_deliver_cb_t deliver)
+{
+    if (g_initialized) {
+        g_deliver = deliver;
+        return ESP_OK;
+    }
+
+    g_mutex = xSemaphoreCreateMutex();
+    if (!g_mutex) {
+        ESP_LOGE(TAG, "Failed to create frame assembler mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = frame_timer_callback,
+        .name = "frame_nack",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &g_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create NACK timer: %s", esp_err_to_name(ret));
+        vSemaphoreDelete(g_mutex);
+        g_mutex = NULL;
+        return ret;
+    }
+
+    g_deliver = deliver;
+    memset(g_frames, 0, sizeof(g_frames));
+    g_initialized = true;
+
+    ESP_LOGI(TAG, "Frame assembler initialized: NACK after %d ms, deadline %d ms",
+             CONFIG_RELIABLE_NACK_DELAY_MS, CONFIG_RELIABLE_FRAME_DEADLINE_MS);
+    return ESP_OK;
+}
+
+void frame_assembler_add(const struct sockaddr_in* source, const led_data_ext_header_t* header,
+                         uint32_t offset, const uint8_t* data, size_t len, int64_t rx_time_us)
+{
+    if (!g_initialized || header->frag_index >= header->frag_count) {
+        return;
+    }
+
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+
+    if (!g_allocated && allocate_frames() != ESP_OK) {
+        xSemaphoreGive(g_mutex);
+        return;
+    }
+
+    if (g_delivered && same_source(&g_delivered_source, source)) {
+        int16_t behind = (int16_t)(g_delivered_frame - header->frame_id);
+        if (behind >= 0 && behind < FRAME_RESTART_GAP) {
+            g_stats.late_fragments++;
+            xSemaphoreGive(g_mutex);
+            return;
+        }
+    }
+
+    // Pixels past the configured LED count are clipped, as
+    // led_driver_update_buffer() clips them on the unreliable path; a
+    // fragment with nothing left still counts towards the frame. Its
+    // offset may lie outside this board's buffer, so it is recorded at 0.
+    if (offset >= g_frame_size) {
+        len = 0;
+    } else if (len > g_frame_size - offset) {
+        len = g_frame_size - offset;
+    }
+    if (len == 0) {
+        offset = 0;
+    }
+
+    pending_frame_t* frame = get_frame(source, header, rx_time_us);
+    uint32_t bit = 1UL << header->frag_index;
+    if (!frame || (frame->received & bit)) {
+        xSemaphoreGive(g_mutex);
+        return;
+    }
+
+    if (len > 0) {
+        memcpy(frame->frame + offset, data, len);
+    }
+    frame->fragments[header->frag_index].offset = offset;
+    frame->fragments[header->frag_index].data = frame->frame + offset;
+    frame->fragments[header->frag_index].len = len;
+    frame->received |= bit;
+    if (frame->nacked) {
+        g_stats.resent_fragments++;
+    }
+
+    if (frame->received == full_mask(frame->count)) {
+        deliver_frame(frame);
+    }
+
+    schedule_next_locked();
+    xSemaphoreGive(g_mutex);
+}
+
+esp_err_t frame_assembler_get_stats(frame_assembler_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t frame_assembler_reset(void)
+{
+    if (g_mutex) {
+        xSemaphoreTake(g_mutex, portMAX_DELAY);
+    }
+
+    for (int i = 0; i < FRAME_ASSEMBLER_SLOTS; i++) {
+        g_frames[i].in_use = false;
+    }
+    g_delivered = false;
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    if (g_mutex) {
+        if (g_timer) {
+            esp_timer_stop(g_timer);
+        }
+        xSemaphoreGive(g_mutex);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,69 @@
+#ifndef FRAME_ASSEMBLER_H
+#define FRAME_ASSEMBLER_H
+
+#include "esp_err.h"
+#include "udp_server.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Frame assembler statistics
+ */
+typedef struct {
+    uint32_t frames_completed;      // Reliable frames delivered whole
+    uint32_t frames_recovered;      // Completed frames that needed a NACK
+    uint32_t frames_dropped;        // Frames that missed their deadline or were superseded
+    uint32_t nacks_sent;            // NACK packets sent
+    uint32_t resent_fragments;      // Fragments that arrived after being NACKed
+    uint32_t late_fragments;        // Fragments of frames already delivered or dropped
+} frame_assembler_stats_t;
+
+/**
+ * Complete frame delivery callback function type
+ * Runs are in fragment order and point into the assembler's staging
+ * buffer; they are only valid during the call.
+ */
+typedef void (*frame_assembler_deliver_cb_t)(bool timed, uint64_t pts_us, const led_data_run_t* runs,
+                                             size_t run_count, int64_t first_rx_us);
+
+/**
+ * Initialize frame assembler
+ * Staging buffers are allocated on the first fragment, once the LED
+ * count is known.
+ * @param deliver Callback receiving every completed frame
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t frame_assembler_init(frame_assembler_deliver_cb_t deliver);
+
+/**
+ * Add a fragment of a reliable frame (0x08 with FRAGMENT)
+ * The frame is delivered once all its fragments are present. Missing
+ * fragments are NACKed to the source every RELIABLE_NACK_DELAY_MS, and
+ * the frame is dropped RELIABLE_FRAME_DEADLINE_MS after its first
+ * fragment arrived.
+ * @param source Address the fragment came from
+ * @param header Parsed header, with frame id and fragment fields
+ * @param offset Byte offset of the data in the LED buffer; ignored when len is 0
+ * @param data LED data, may be NULL when len is 0
+ * @param len Length of LED data; 0 for a fragment with nothing for this board
+ * @param rx_time_us Receive time of the fragment
+ */
+void frame_assembler_add(const struct sockaddr_in* source, const led_data_ext_header_t* header,
+                         uint32_t offset, const uint8_t* data, size_t len, int64_t rx_time_us);
+
+/**
+ * Get frame assembler statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t frame_assembler_get_stats(frame_assembler_stats_t* stats);
+
+/**
+ * Reset frame assembler statistics and drop pending frames
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t frame_assembler_reset(void);
+
+#endif // FRAME_ASSEMBLER_H
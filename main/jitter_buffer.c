@@ -0,0 +1,616 @@
+#include "jitter_buffer.h"
+#include "config.h"
+#include "led_driver.h"
+#include "clock_sync.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "JITTER_BUFFER";
+
+// One slot is being filled while up to DEPTH complete frames wait
+#define JITTER_BUFFER_SLOTS         (CONFIG_JITTER_BUFFER_DEPTH + 1)
+// Frames whose target passed more than one refresh period ago are dropped
+#define JITTER_LATE_TOLERANCE_US    (LED_REFRESH_PERIOD_MS * 1000)
+// Frames due within this window are presented by the current timer shot
+#define JITTER_PRESENT_SLACK_US     200
+// Frames over which the minimum transit delay is re-estimated
+#define JITTER_OFFSET_WINDOW_FRAMES 128
+#define JITTER_GRID_PERIOD_US       CONFIG_JITTER_BUFFER_GRID_PERIOD_US
+// Above the UDP server task, so a due frame is not held up by receiving
+#define JITTER_PRESENT_TASK_PRIORITY 6
+#define JITTER_PRESENT_TASK_STACK   4096
+#define JITTER_STOP_TIMEOUT_MS      500
+
+typedef enum {
+    SLOT_FREE,
+    SLOT_FILLING,   // Receiving fragments, PUSH not seen yet
+    SLOT_READY,     // Complete, waiting for its presentation time
+    SLOT_PRESENTING // Being copied to the LED buffer and transmitted
+} slot_state_t;
+
+typedef struct {
+    slot_state_t state;
+    uint64_t pts_us;        // Host presentation timestamp
+    int64_t target_us;      // Local presentation time (esp_timer clock)
+    int64_t grid_host_us;   // Grid boundary on the host clock, if on_grid
+    int64_t received_us;    // Arrival of the packet that completed the frame
+    bool on_grid;
+    uint32_t sequence;      // Allocation order
+    uint8_t* frame;
+} frame_slot_t;
+
+// Global variables
+static frame_slot_t g_slots[JITTER_BUFFER_SLOTS];
+static size_t g_frame_size = 0;
+static bool g_initialized = false;
+static bool g_allocated = false;
+static uint32_t g_slot_sequence = 0;
+static uint32_t g_latency_us = CONFIG_JITTER_BUFFER_LATENCY_MS * 1000;
+static SemaphoreHandle_t g_mutex = NULL;
+static esp_timer_handle_t g_present_timer = NULL;
+static TaskHandle_t g_present_task = NULL;
+static TaskHandle_t g_stop_waiter = NULL;
+static volatile bool g_present_stop = false;
+static volatile int64_t g_fired_us = 0;   // When the presentation timer last fired
+
+// Callbacks
+static jitter_present_cb_t g_present_callback = NULL;
+
+// Host to local clock mapping: the smallest observed (arrival - pts) is
+// taken as the transit delay of an undelayed packet
+static bool g_offset_valid = false;
+static int64_t g_offset_us = 0;
+static int64_t g_window_min_us = 0;
+static uint32_t g_window_frames = 0;
+
+// Time from timer expiry to the RMT starting, learned from past frames
+// and subtracted from grid targets so the wire start lands on the grid
+static int64_t g_wire_lead_us = 0;
+
+// Statistics
+static jitter_buffer_stats_t g_stats = {0};
+static const uint32_t g_histogram_bounds[JITTER_BUFFER_HISTOGRAM_BUCKETS] =
+    JITTER_BUFFER_HISTOGRAM_BOUNDS_US;
+
+/**
+ * Allocate frame storage for all slots
+ */
+static esp_err_t allocate_slots(void)
+{
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        g_slots[i].frame = malloc(g_frame_size);
+        if (!g_slots[i].frame) {
+            ESP_LOGE(TAG, "Failed to allocate jitter buffer slot (%" PRIu32 " bytes)",
+                     (uint32_t)g_frame_size);
+            for (int j = 0; j < i; j++) {
+                free(g_slots[j].frame);
+                g_slots[j].frame = NULL;
+            }
+            return ESP_ERR_NO_MEM;
+        }
+        g_slots[i].state = SLOT_FREE;
+    }
+
+    g_allocated = true;
+    ESP_LOGI(TAG, "Jitter buffer allocated: %d slots x %" PRIu32 " bytes, latency %" PRIu32 " us",
+             JITTER_BUFFER_SLOTS, (uint32_t)g_frame_size, g_latency_us);
+    return ESP_OK;
+}
+
+/**
+ * Count frames waiting for presentation
+ */
+static uint8_t ready_count(void)
+{
+    uint8_t count = 0;
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (g_slots[i].state == SLOT_READY) {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Find the newest slot in the given state, or NULL
+ */
+static frame_slot_t* newest_slot(slot_state_t state)
+{
+    frame_slot_t* newest = NULL;
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (g_slots[i].state == state &&
+            (!newest || (int32_t)(g_slots[i].sequence - newest->sequence) > 0)) {
+            newest = &g_slots[i];
+        }
+    }
+    return newest;
+}
+
+/**
+ * Find the oldest slot in the given state, or NULL
+ */
+static frame_slot_t* oldest_slot(slot_state_t state)
+{
+    frame_slot_t* oldest = NULL;
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (g_slots[i].state == state &&
+            (!oldest || (int32_t)(g_slots[i].sequence - oldest->sequence) < 0)) {
+            oldest = &g_slots[i];
+        }
+    }
+    return oldest;
+}
+
+/**
+ * Get a slot for a new frame, seeded with the most recent frame content
+ * so partial updates behave like they do on the live buffer
+ */
+static frame_slot_t* acquire_slot(uint64_t pts_us)
+{
+    frame_slot_t* slot = NULL;
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (g_slots[i].state == SLOT_FREE) {
+            slot = &g_slots[i];
+            break;
+        }
+    }
+
+    if (!slot) {
+        // Host is sending faster than frames are presented; give up the
+        // oldest frame to keep latency bounded
+        slot = oldest_slot(SLOT_READY);
+        if (!slot) {
+            slot = oldest_slot(SLOT_FILLING);
+        }
+        g_stats.overflow_drops++;
+        slot->state = SLOT_FREE;
+    }
+
+    frame_slot_t* seed = newest_slot(SLOT_READY);
+    if (!seed) {
+        seed = newest_slot(SLOT_FILLING);
+    }
+
+    if (seed) {
+        memcpy(slot->frame, seed->frame, g_frame_size);
+    } else {
+        const uint8_t* live = led_driver_get_buffer();
+        size_t live_size = led_driver_get_buffer_size();
+        memset(slot->frame, 0, g_frame_size);
+        if (live) {
+            memcpy(slot->frame, live, live_size < g_frame_size ? live_size : g_frame_size);
+        }
+    }
+
+    slot->state = SLOT_FILLING;
+    slot->pts_us = pts_us;
+    slot->sequence = ++g_slot_sequence;
+    return slot;
+}
+
+/**
+ * Map a host presentation timestamp to the local clock
+ * Falls back to the minimum observed (arrival - pts) when no host clock
+ * is available.
+ */
+static int64_t host_to_local_us(uint64_t pts_us, int64_t arrival_us)
+{
+    // A synchronized clock knows the real offset, including the transit
+    // delay the minimum-delay estimate below cannot see
+    if (clock_sync_is_synced()) {
+        return clock_sync_host_to_local((int64_t)pts_us);
+    }
+
+    int64_t sample = arrival_us - (int64_t)pts_us;
+
+    if (!g_offset_valid || sample < g_offset_us) {
+        g_offset_us = sample;
+        g_offset_valid = true;
+    }
+
+    // Re-estimate periodically so the mapping follows clock drift and
+    // route changes instead of sticking to an old minimum forever
+    if (g_window_frames == 0 || sample < g_window_min_us) {
+        g_window_min_us = sample;
+    }
+    if (++g_window_frames >= JITTER_OFFSET_WINDOW_FRAMES) {
+        g_offset_us = g_window_min_us;
+        g_window_frames = 0;
+    }
+
+    return (int64_t)pts_us + g_offset_us;
+}
+
+/**
+ * Arm the presentation timer for the earliest waiting frame
+ */
+static void schedule_next_locked(void)
+{
+    frame_slot_t* next = NULL;
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (g_slots[i].state == SLOT_READY &&
+            (!next || g_slots[i].target_us < next->target_us)) {
+            next = &g_slots[i];
+        }
+    }
+
+    esp_timer_stop(g_present_timer);
+    if (next) {
+        int64_t delay = next->target_us - esp_timer_get_time();
+        esp_timer_start_once(g_present_timer, delay > 0 ? (uint64_t)delay : 0);
+    }
+}
+
+/**
+ * Count an error magnitude in a histogram
+ */
+static void record_histogram(uint32_t* histogram, int64_t error_us)
+{
+    uint64_t magnitude = error_us < 0 ? (uint64_t)-error_us : (uint64_t)error_us;
+    for (int i = 0; i < JITTER_BUFFER_HISTOGRAM_BUCKETS; i++) {
+        if (magnitude <= g_histogram_bounds[i]) {
+            histogram[i]++;
+            return;
+        }
+    }
+}
+
+/**
+ * Measure where a grid frame actually hit the wire
+ */
+static void record_phase(const frame_slot_t* slot, int64_t fired_us, int64_t prev_start_us)
+{
+    int64_t start_us = led_driver_get_last_transmit_start_us();
+    if (start_us == prev_start_us) {
+        return;  // Nothing was transmitted
+    }
+
+    int64_t lead = start_us - fired_us;
+    if (lead >= 0 && lead < JITTER_GRID_PERIOD_US) {
+        g_wire_lead_us += (lead - g_wire_lead_us) / 8;
+    }
+
+    int64_t phase = clock_sync_local_to_host(start_us) - slot->grid_host_us;
+    uint32_t magnitude = (uint32_t)(phase < 0 ? -phase : phase);
+
+    g_stats.grid_frames++;
+    g_stats.last_phase_error_us = (int32_t)phase;
+    if (magnitude > g_stats.max_phase_error_us) {
+        g_stats.max_phase_error_us = magnitude;
+    }
+    record_histogram(g_stats.phase_histogram, phase);
+}
+
+/**
+ * Presentation timer callback (esp_timer task)
+ * Only wakes the present task: the encode and transmit take milliseconds
+ * and would hold up every other esp_timer client, WiFi's included.
+ */
+static void present_timer_callback(void* arg)
+{
+    g_fired_us = esp_timer_get_time();
+    xTaskNotifyGive(g_present_task);
+}
+
+/**
+ * Show the newest due frame
+ */
+static void present_due_frame(void)
+{
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+
+    int64_t now = esp_timer_get_time();
+
+    // Only the newest due frame is shown; older due frames are late
+    frame_slot_t* due = NULL;
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (g_slots[i].state == SLOT_READY &&
+            g_slots[i].target_us <= now + JITTER_PRESENT_SLACK_US &&
+            (!due || g_slots[i].target_us > due->target_us)) {
+            due = &g_slots[i];
+        }
+    }
+
+    if (!due) {
+        schedule_next_locked();
+        xSemaphoreGive(g_mutex);
+        return;
+    }
+
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (&g_slots[i] != due && g_slots[i].state == SLOT_READY &&
+            g_slots[i].target_us <= due->target_us) {
+            g_slots[i].state = SLOT_FREE;
+            g_stats.late_drops++;
+        }
+    }
+
+    record_histogram(g_stats.error_histogram, now - due->target_us);
+
+    // The UDP task keeps queueing frames while this one goes out
+    due->state = SLOT_PRESENTING;
+    xSemaphoreGive(g_mutex);
+
+    led_driver_lock();
+    int64_t prev_start_us = led_driver_get_last_transmit_start_us();
+    led_driver_mark_frame_received(due->received_us);
+    if (g_present_callback) {
+        g_present_callback(due->frame, g_frame_size);
+    }
+    led_driver_unlock();
+
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+    if (due->on_grid) {
+        record_phase(due, g_fired_us, prev_start_us);
+    }
+
+    due->state = SLOT_FREE;
+    g_stats.frames_presented++;
+    g_stats.depth = ready_count();
+
+    schedule_next_locked();
+    xSemaphoreGive(g_mutex);
+}
+
+/**
+ * Present task: shows frames when the presentation timer fires
+ */
+static void present_task(void* arg)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (g_present_stop) {
+            break;
+        }
+        present_due_frame();
+    }
+
+    if (g_stop_waiter) {
+        xTaskNotifyGive(g_stop_waiter);
+    }
+    vTaskDelete(NULL);
+}
+
+esp_err_t jitter_buffer_init(size_t frame_size)
+{
+    if (g_initialized) {
+        ESP_LOGW(TAG, "Jitter buffer already initialized");
+        return ESP_OK;
+    }
+
+    if (frame_size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    g_mutex = xSemaphoreCreateMutex();
+    if (!g_mutex) {
+        ESP_LOGE(TAG, "Failed to create jitter buffer mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // esp_timer rather than a FreeRTOS timer: presentation needs
+    // microsecond resolution, not tick resolution
+    const esp_timer_create_args_t timer_args = {
+        .callback = present_timer_callback,
+        .name = "jitter_present",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &g_present_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create presentation timer: %s", esp_err_to_name(ret));
+        vSemaphoreDelete(g_mutex);
+        g_mutex = NULL;
+        return ret;
+    }
+
+    g_present_stop = false;
+    if (xTaskCreate(present_task, "jitter_present", JITTER_PRESENT_TASK_STACK, NULL,
+                    JITTER_PRESENT_TASK_PRIORITY, &g_present_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create present task");
+        esp_timer_delete(g_present_timer);
+        g_present_timer = NULL;
+        vSemaphoreDelete(g_mutex);
+        g_mutex = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    g_frame_size = frame_size;
+    memset(g_slots, 0, sizeof(g_slots));
+    g_initialized = true;
+
+    ESP_LOGI(TAG, "Jitter buffer initialized: depth %d, latency %d ms",
+             CONFIG_JITTER_BUFFER_DEPTH, CONFIG_JITTER_BUFFER_LATENCY_MS);
+    return ESP_OK;
+}
+
+esp_err_t jitter_buffer_write(uint64_t pts_us, uint32_t offset, const uint8_t* data,
+                              size_t len, bool push)
+{
+    if (!g_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!data && len > 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (offset > g_frame_size) {
+        ESP_LOGW(TAG, "Frame offset out of range: byte_offset=%" PRIu32, offset);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Clip like led_driver_update_buffer does for the live buffer
+    if (len > g_frame_size - offset) {
+        len = g_frame_size - offset;
+    }
+
+    int64_t arrival_us = esp_timer_get_time();
+
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+
+    if (!g_allocated) {
+        esp_err_t ret = allocate_slots();
+        if (ret != ESP_OK) {
+            xSemaphoreGive(g_mutex);
+            return ret;
+        }
+    }
+
+    frame_slot_t* slot = NULL;
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        if (g_slots[i].state != SLOT_FREE && g_slots[i].pts_us == pts_us) {
+            slot = &g_slots[i];
+            break;
+        }
+    }
+
+    if (slot && slot->state == SLOT_PRESENTING) {
+        // Already on its way to the wire; too late to patch
+        xSemaphoreGive(g_mutex);
+        return ESP_OK;
+    }
+
+    if (slot && slot->state == SLOT_READY) {
+        // Late fragment of a frame already pushed but not yet presented
+        if (len > 0) {
+            memcpy(slot->frame + offset, data, len);
+        }
+        xSemaphoreGive(g_mutex);
+        return ESP_OK;
+    }
+
+    if (!slot) {
+        slot = acquire_slot(pts_us);
+    }
+
+    if (len > 0) {
+        memcpy(slot->frame + offset, data, len);
+    }
+
+    if (push) {
+        // Frames still filling with an older timestamp lost their last
+        // fragment and will never complete
+        for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+            if (g_slots[i].state == SLOT_FILLING && g_slots[i].pts_us < pts_us) {
+                g_slots[i].state = SLOT_FREE;
+                g_stats.late_drops++;
+            }
+        }
+
+        slot->received_us = arrival_us;
+        slot->on_grid = JITTER_GRID_PERIOD_US > 0 && clock_sync_is_synced();
+        if (slot->on_grid) {
+            // Latch on the next grid boundary of the shared clock; every
+            // board synced to the same host picks the same instant
+            int64_t host_target = (int64_t)pts_us + g_latency_us;
+            slot->grid_host_us = (host_target + JITTER_GRID_PERIOD_US - 1) /
+                                 JITTER_GRID_PERIOD_US * JITTER_GRID_PERIOD_US;
+            slot->target_us = clock_sync_host_to_local(slot->grid_host_us) - g_wire_lead_us;
+        } else {
+            slot->target_us = host_to_local_us(pts_us, arrival_us) + g_latency_us;
+        }
+
+        if (slot->target_us < arrival_us - JITTER_LATE_TOLERANCE_US) {
+            ESP_LOGD(TAG, "Dropping late frame: %" PRId64 " us past target",
+                     arrival_us - slot->target_us);
+            slot->state = SLOT_FREE;
+            g_stats.late_drops++;
+        } else {
+            slot->state = SLOT_READY;
+            g_stats.frames_queued++;
+            g_stats.depth = ready_count();
+            if (g_stats.depth > g_stats.max_depth) {
+                g_stats.max_depth = g_stats.depth;
+            }
+            schedule_next_locked();
+        }
+    }
+
+    xSemaphoreGive(g_mutex);
+    return ESP_OK;
+}
+
+esp_err_t jitter_buffer_set_latency(uint32_t latency_us)
+{
+    g_latency_us = latency_us;
+    ESP_LOGI(TAG, "Latency target set to %" PRIu32 " us", latency_us);
+    return ESP_OK;
+}
+
+esp_err_t jitter_buffer_register_present_callback(jitter_present_cb_t callback)
+{
+    g_present_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t jitter_buffer_get_stats(jitter_buffer_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t jitter_buffer_reset_stats(void)
+{
+    memset(&g_stats, 0, sizeof(g_stats));
+    ESP_LOGI(TAG, "Jitter buffer statistics reset");
+    return ESP_OK;
+}
+
+esp_err_t jitter_buffer_deinit(void)
+{
+    if (!g_initialized) {
+        ESP_LOGW(TAG, "Jitter buffer not initialized");
+        return ESP_OK;
+    }
+
+    ESP_LOGI(TAG, "Deinitializing jitter buffer");
+
+    if (g_present_timer) {
+        esp_timer_stop(g_present_timer);
+        esp_timer_delete(g_present_timer);
+        g_present_timer = NULL;
+    }
+
+    // Let the present task finish the frame it may be showing
+    if (g_present_task) {
+        g_stop_waiter = xTaskGetCurrentTaskHandle();
+        g_present_stop = true;
+        xTaskNotifyGive(g_present_task);
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(JITTER_STOP_TIMEOUT_MS)) == 0) {
+            ESP_LOGW(TAG, "Present task did not stop, deleting it");
+            vTaskDelete(g_present_task);
+        }
+        g_present_task = NULL;
+        g_stop_waiter = NULL;
+    }
+
+    if (g_mutex) {
+        vSemaphoreDelete(g_mutex);
+        g_mutex = NULL;
+    }
+
+    for (int i = 0; i < JITTER_BUFFER_SLOTS; i++) {
+        free(g_slots[i].frame);
+        g_slots[i].frame = NULL;
+        g_slots[i].state = SLOT_FREE;
+    }
+
+    g_allocated = false;
+    g_initialized = false;
+    g_offset_valid = false;
+    g_window_frames = 0;
+    g_wire_lead_us = 0;
+    g_present_callback = NULL;
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    ESP_LOGI(TAG, "Jitter buffer deinitialized");
+    return ESP_OK;
+}
@@ -0,0 +1,92 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// Presentation error histogram bucket upper bounds in microseconds; the last
+// bucket collects everything above the previous bound
+#define JITTER_BUFFER_HISTOGRAM_BUCKETS 8
+#define JITTER_BUFFER_HISTOGRAM_BOUNDS_US {250, 500, 1000, 2000, 4000, 8000, 16000, UINT32_MAX}
+
+/**
+ * Jitter buffer statistics
+ */
+typedef struct {
+    uint32_t frames_queued;       // Frames completed (PUSH received) and queued
+    uint32_t frames_presented;    // Frames handed to the present callback
+    uint32_t late_drops;          // Frames dropped because their presentation time had passed
+    uint32_t overflow_drops;      // Frames dropped because all slots were in use
+    uint8_t depth;                // Frames currently waiting for presentation
+    uint8_t max_depth;            // Highest depth seen
+    uint32_t error_histogram[JITTER_BUFFER_HISTOGRAM_BUCKETS];  // |actual - target| presentation time
+    uint32_t grid_frames;         // Frames latched on the synchronized presentation grid
+    int32_t last_phase_error_us;  // Wire start minus grid boundary, on the host clock
+    uint32_t max_phase_error_us;  // Largest |phase error| seen
+    uint32_t phase_histogram[JITTER_BUFFER_HISTOGRAM_BUCKETS];  // |phase error|
+} jitter_buffer_stats_t;
+
+/**
+ * Frame presentation callback function type
+ * Called from the jitter buffer's present task, with the LED pipeline lock
+ * held, with a complete frame.
+ */
+typedef void (*jitter_present_cb_t)(const uint8_t* frame, size_t len);
+
+/**
+ * Initialize jitter buffer
+ * Frame slots are allocated on the first timestamped frame.
+ * @param frame_size Size of one full frame in bytes (LED buffer size)
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jitter_buffer_init(size_t frame_size);
+
+/**
+ * Write timestamped LED data into the frame it belongs to
+ * Data for a frame that is complete but not yet presented patches it.
+ * @param pts_us Host presentation timestamp in microseconds
+ * @param offset Byte offset in frame
+ * @param data LED data
+ * @param len Length of LED data in bytes
+ * @param push true if this packet completes the frame
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jitter_buffer_write(uint64_t pts_us, uint32_t offset, const uint8_t* data,
+                              size_t len, bool push);
+
+/**
+ * Set latency target added to every presentation timestamp
+ * @param latency_us Latency target in microseconds
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jitter_buffer_set_latency(uint32_t latency_us);
+
+/**
+ * Register frame presentation callback
+ * @param callback Callback function to register
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jitter_buffer_register_present_callback(jitter_present_cb_t callback);
+
+/**
+ * Get jitter buffer statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jitter_buffer_get_stats(jitter_buffer_stats_t* stats);
+
+/**
+ * Reset jitter buffer statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jitter_buffer_reset_stats(void);
+
+/**
+ * Deinitialize jitter buffer
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t jitter_buffer_deinit(void);
+
+#endif // JITTER_BUFFER_H
@@ -1,6 +1,7 @@
 #include "led_driver.h"
 #include "config.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/rmt.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -8,6 +9,7 @@
 #include "freertos/semphr.h"
 #include <string.h>
 #include <inttypes.h>
+#include <math.h>
 
 static const char *TAG = "LED_DRIVER";
 
@@ -19,19 +21,34 @@ static gpio_num_t g_data_pin = LED_DATA_PIN;
 static bool g_initialized = false;
 static bool g_transmitting = false;
 static SemaphoreHandle_t g_transmission_semaphore = NULL;
+static SemaphoreHandle_t g_pipeline_mutex = NULL;  // Recursive; see led_driver_lock()
 
 // Breathing effect
 static led_breathing_t g_breathing = {0};
 static TimerHandle_t g_breathing_timer = NULL;
 static bool g_mixed_mode = false;  // Mixed mode: breathing + LED data
 
+// Lookup tables for expanding reduced bit-depth pixels to 8-bit channels
+static uint8_t g_expand4[16];
+static uint8_t g_expand5[32];
+static uint8_t g_expand6[64];
+// For each byte of an LED: index into an expanded {R, G, B, W, 0} tuple
+static uint8_t g_channel_map[8];
+
 // Statistics
 static struct {
     uint32_t transmissions;
     uint32_t bytes_transmitted;
     uint32_t last_transmission_time;
+    int64_t last_transmit_start_us;  // esp_timer time the RMT was started
+    int64_t frame_received_us;       // Receive time of data not yet transmitted, 0 if none
+    uint32_t last_frame_latency_us;  // Receive to RMT start of the last frame
 } g_stats = {0};
 
+static led_pipeline_stats_t g_pipeline = {0};
+static const uint32_t g_latency_bounds[LED_LATENCY_HISTOGRAM_BUCKETS] =
+    LED_LATENCY_HISTOGRAM_BOUNDS_US;
+
 // RMT items for SK6812 timing
 static rmt_item32_t g_bit_1 = {
     .level0 = 1,
@@ -59,6 +76,7 @@ static rmt_item32_t g_reset = {
  */
 static void rmt_tx_done_callback(rmt_channel_t channel, void* arg)
 {
+    g_pipeline.last_wire_time_us = (uint32_t)(esp_timer_get_time() - g_stats.last_transmit_start_us);
     g_transmitting = false;
     if (g_transmission_semaphore) {
         BaseType_t xHigherPriorityTaskWoken = pdFALSE;
@@ -143,6 +161,48 @@ static void set_led_color(uint8_t* buffer, size_t offset, uint8_t r, uint8_t g,
   }
 }
 
+/**
+ * Expand an n-bit level to 8 bits, optionally applying gamma
+ */
+static uint8_t expand_level(uint32_t value, uint32_t max_value)
+{
+#if CONFIG_LED_PACKED_GAMMA_ENABLE
+    float normalized = (float)value / (float)max_value;
+    float gamma = (float)CONFIG_LED_PACKED_GAMMA_X10 / 10.0f;
+    return (uint8_t)(powf(normalized, gamma) * 255.0f + 0.5f);
+#else
+    return (uint8_t)((value * 255 + max_value / 2) / max_value);
+#endif
+}
+
+/**
+ * Build expansion tables and channel map for packed pixel formats
+ */
+static void init_packed_pixel_tables(void)
+{
+    for (uint32_t i = 0; i < 16; i++) {
+        g_expand4[i] = expand_level(i, 15);
+    }
+    for (uint32_t i = 0; i < 32; i++) {
+        g_expand5[i] = expand_level(i, 31);
+    }
+    for (uint32_t i = 0; i < 64; i++) {
+        g_expand6[i] = expand_level(i, 63);
+    }
+
+    const char* color_order = CONFIG_LED_COLOR_ORDER_STRING;
+    int channels = get_led_channels_count();
+    for (int i = 0; i < channels && i < (int)sizeof(g_channel_map); i++) {
+        switch (color_order[i]) {
+            case 'R': case 'r': g_channel_map[i] = 0; break;
+            case 'G': case 'g': g_channel_map[i] = 1; break;
+            case 'B': case 'b': g_channel_map[i] = 2; break;
+            case 'W': case 'w': g_channel_map[i] = 3; break;
+            default:            g_channel_map[i] = 4; break;
+        }
+    }
+}
+
 /**
  * Get status color based on current status
  */
@@ -212,6 +272,8 @@ static void get_status_color(led_status_t status, uint8_t* r, uint8_t* g, uint8_
     }
 }
 
+static void breathing_step(void);
+
 /**
  * Breathing effect timer callback
  */
@@ -221,6 +283,22 @@ static void breathing_timer_callback(TimerHandle_t xTimer)
         return;
     }
 
+    // A receiver is writing or transmitting a frame; skip this step
+    // rather than stall the timer task
+    if (g_pipeline_mutex && xSemaphoreTakeRecursive(g_pipeline_mutex, 0) != pdTRUE) {
+        return;
+    }
+    breathing_step();
+    if (g_pipeline_mutex) {
+        xSemaphoreGiveRecursive(g_pipeline_mutex);
+    }
+}
+
+/**
+ * Advance the breathing effect by one step and transmit it
+ */
+static void breathing_step(void)
+{
     // Additional safety check: ensure status colors are initialized
     if (g_breathing.status_r == 0 && g_breathing.status_g == 0 &&
         g_breathing.status_b == 0 && g_breathing.status_w == 0) {
@@ -309,6 +387,8 @@ esp_err_t led_driver_init(gpio_num_t data_pin)
     g_data_pin = data_pin;
     g_buffer_size = g_led_count * actual_channels;
 
+    init_packed_pixel_tables();
+
     // Allocate LED buffer
     g_led_buffer = malloc(g_buffer_size);
     if (!g_led_buffer) {
@@ -364,6 +444,17 @@ esp_err_t led_driver_init(gpio_num_t data_pin)
         return ESP_ERR_NO_MEM;
     }
     
+    // Create LED pipeline lock
+    g_pipeline_mutex = xSemaphoreCreateRecursiveMutex();
+    if (!g_pipeline_mutex) {
+        ESP_LOGE(TAG, "Failed to create LED pipeline mutex");
+        vSemaphoreDelete(g_transmission_semaphore);
+        rmt_driver_uninstall(RMT_CHANNEL);
+        free(g_led_buffer);
+        g_led_buffer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    
     // Create breathing timer
     g_breathing_timer = xTimerCreate(
         "led_breathing",
@@ -374,6 +465,8 @@ esp_err_t led_driver_init(gpio_num_t data_pin)
 
     if (!g_breathing_timer) {
         ESP_LOGE(TAG, "Failed to create breathing timer");
+        vSemaphoreDelete(g_pipeline_mutex);
+        g_pipeline_mutex = NULL;
         vSemaphoreDelete(g_transmission_semaphore);
         rmt_driver_uninstall(RMT_CHANNEL);
         free(g_led_buffer);
@@ -391,7 +484,7 @@ esp_err_t led_driver_init(gpio_num_t data_pin)
     return ESP_OK;
 }
 
-esp_err_t led_driver_update_buffer(uint16_t offset, const uint8_t* data, size_t len)
+esp_err_t led_driver_update_buffer(uint32_t offset, const uint8_t* data, size_t len)
 {
     if (!g_initialized || !g_led_buffer) {
         return ESP_ERR_INVALID_STATE;
@@ -404,8 +497,14 @@ esp_err_t led_driver_update_buffer(uint16_t offset, const uint8_t* data, size_t
     // offset is already a byte offset according to protocol specification
     size_t byte_offset = offset;
 
+    if (byte_offset >= g_buffer_size) {
+      ESP_LOGW(TAG, "LED data offset beyond buffer: byte_offset=%" PRIu32
+               ", buffer_size=%" PRIu32, offset, (uint32_t)g_buffer_size);
+      return ESP_ERR_INVALID_ARG;
+    }
+
     // Check bounds
-    if (byte_offset + len > g_buffer_size) {
+    if (len > g_buffer_size - byte_offset) {
       ESP_LOGW(
           TAG,
           "LED data exceeds buffer: byte_offset=%d, len=%d, buffer_size=%d",
@@ -424,6 +523,78 @@ esp_err_t led_driver_update_buffer(uint16_t offset, const uint8_t* data, size_t
     return ESP_OK;
 }
 
+size_t led_driver_packed_pixel_count(led_pixel_format_t format, size_t len)
+{
+    switch (format) {
+        case LED_PIXEL_FORMAT_RGB565:
+            return len / 2;
+        case LED_PIXEL_FORMAT_RGB444:
+            return (len * 2) / 3;
+        default:
+            return 0;
+    }
+}
+
+esp_err_t led_driver_update_buffer_packed(uint16_t led_offset, led_pixel_format_t format,
+                                          const uint8_t* data, size_t len)
+{
+    if (!g_initialized || !g_led_buffer) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!data || len == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int channels = get_led_channels_count();
+    size_t max_leds = g_buffer_size / channels;
+    size_t count = led_driver_packed_pixel_count(format, len);
+
+    if (led_offset >= max_leds) {
+        ESP_LOGW(TAG, "Packed LED offset %d beyond strip (%" PRIu32 " LEDs)",
+                 led_offset, (uint32_t)max_leds);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Check bounds
+    if (led_offset + count > max_leds) {
+        ESP_LOGW(TAG, "Packed LED data exceeds buffer: led_offset=%d, count=%" PRIu32,
+                 led_offset, (uint32_t)count);
+        count = max_leds - led_offset;
+    }
+
+    uint8_t* dst = g_led_buffer + (size_t)led_offset * channels;
+    uint8_t rgbw[5] = {0};  // R, G, B, W (always 0), unknown channel (0)
+    int mapped = channels < (int)sizeof(g_channel_map) ? channels : (int)sizeof(g_channel_map);
+
+    for (size_t i = 0; i < count; i++) {
+        if (format == LED_PIXEL_FORMAT_RGB565) {
+            uint16_t px = (uint16_t)((data[2 * i] << 8) | data[2 * i + 1]);
+            rgbw[0] = g_expand5[px >> 11];
+            rgbw[1] = g_expand6[(px >> 5) & 0x3F];
+            rgbw[2] = g_expand5[px & 0x1F];
+        } else {
+            // 12-bit pixels packed MSB first: pixel i starts at bit 12 * i
+            size_t k = (i * 3) / 2;
+            uint16_t px = (i & 1) ? (uint16_t)(((data[k] & 0x0F) << 8) | data[k + 1])
+                                  : (uint16_t)((data[k] << 4) | (data[k + 1] >> 4));
+            rgbw[0] = g_expand4[px >> 8];
+            rgbw[1] = g_expand4[(px >> 4) & 0x0F];
+            rgbw[2] = g_expand4[px & 0x0F];
+        }
+
+        for (int c = 0; c < mapped; c++) {
+            dst[c] = rgbw[g_channel_map[c]];
+        }
+        dst += channels;
+    }
+
+    ESP_LOGD(TAG, "Updated LED buffer from packed pixels: led_offset=%d, count=%" PRIu32,
+             led_offset, (uint32_t)count);
+
+    return ESP_OK;
+}
+
 esp_err_t led_driver_transmit_all(void)
 {
     if (!g_initialized || !g_led_buffer) {
@@ -432,10 +603,12 @@ esp_err_t led_driver_transmit_all(void)
     
     if (g_transmitting) {
         ESP_LOGW(TAG, "Transmission already in progress");
+        g_pipeline.frames_skipped++;
         return ESP_ERR_INVALID_STATE;
     }
     
     ESP_LOGD(TAG, "Transmitting %d LEDs (%" PRIu32 " bytes)", g_led_count, (uint32_t)g_buffer_size);
+    int64_t encode_start_us = esp_timer_get_time();
     
     // Allocate RMT items (8 bits per byte + reset)
     size_t rmt_item_count = g_buffer_size * 8 + 1;
@@ -452,6 +625,7 @@ esp_err_t led_driver_transmit_all(void)
     g_transmitting = true;
     
     // Transmit via RMT
+    int64_t start_us = esp_timer_get_time();
     esp_err_t ret = rmt_write_items(RMT_CHANNEL, rmt_items, actual_items, false);
     
     free(rmt_items);
@@ -466,6 +640,29 @@ esp_err_t led_driver_transmit_all(void)
     g_stats.transmissions++;
     g_stats.bytes_transmitted += g_buffer_size;
     g_stats.last_transmission_time = xTaskGetTickCount();
+    g_stats.last_transmit_start_us = start_us;
+
+    uint32_t encode_us = (uint32_t)(start_us - encode_start_us);
+    g_pipeline.encode_count++;
+    g_pipeline.encode_time_total_us += encode_us;
+    if (encode_us > g_pipeline.encode_time_max_us) {
+        g_pipeline.encode_time_max_us = encode_us;
+    }
+
+    if (g_stats.frame_received_us) {
+        uint32_t latency = (uint32_t)(start_us - g_stats.frame_received_us);
+        g_stats.last_frame_latency_us = latency;
+        g_stats.frame_received_us = 0;
+
+        g_pipeline.frames_displayed++;
+        g_pipeline.last_display_us = start_us;
+        for (int i = 0; i < LED_LATENCY_HISTOGRAM_BUCKETS; i++) {
+            if (latency <= g_latency_bounds[i]) {
+                g_pipeline.latency_histogram[i]++;
+                break;
+            }
+        }
+    }
     
     return ESP_OK;
 }
@@ -705,9 +902,50 @@ esp_err_t led_driver_get_stats(uint32_t* transmissions, uint32_t* bytes_transmit
     return ESP_OK;
 }
 
+void led_driver_lock(void)
+{
+    if (g_pipeline_mutex) {
+        xSemaphoreTakeRecursive(g_pipeline_mutex, portMAX_DELAY);
+    }
+}
+
+void led_driver_unlock(void)
+{
+    if (g_pipeline_mutex) {
+        xSemaphoreGiveRecursive(g_pipeline_mutex);
+    }
+}
+
+esp_err_t led_driver_mark_frame_received(int64_t rx_time_us)
+{
+    g_stats.frame_received_us = rx_time_us;
+    return ESP_OK;
+}
+
+uint32_t led_driver_get_last_frame_latency_us(void)
+{
+    return g_stats.last_frame_latency_us;
+}
+
+esp_err_t led_driver_get_pipeline_stats(led_pipeline_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_pipeline;
+    return ESP_OK;
+}
+
+int64_t led_driver_get_last_transmit_start_us(void)
+{
+    return g_stats.last_transmit_start_us;
+}
+
 esp_err_t led_driver_reset_stats(void)
 {
     memset(&g_stats, 0, sizeof(g_stats));
+    memset(&g_pipeline, 0, sizeof(g_pipeline));
     ESP_LOGI(TAG, "LED driver statistics reset");
     return ESP_OK;
 }
@@ -730,11 +968,15 @@ esp_err_t led_driver_deinit(void)
         g_breathing_timer = NULL;
     }
 
-    // Delete semaphore
+    // Delete semaphores
     if (g_transmission_semaphore) {
         vSemaphoreDelete(g_transmission_semaphore);
         g_transmission_semaphore = NULL;
     }
+    if (g_pipeline_mutex) {
+        vSemaphoreDelete(g_pipeline_mutex);
+        g_pipeline_mutex = NULL;
+    }
 
     // Uninstall RMT driver
     rmt_driver_uninstall(RMT_CHANNEL);
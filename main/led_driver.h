@@ -26,6 +26,32 @@ typedef enum {
   LED_STATUS_GENERAL_ERROR         // 一般错误 - 快闪红色
 } led_status_t;
 
+/**
+ * Reduced bit-depth pixel formats expanded on the board
+ */
+typedef enum {
+    LED_PIXEL_FORMAT_RGB565,  // 16-bit pixels, big-endian RRRRRGGG GGGBBBBB
+    LED_PIXEL_FORMAT_RGB444   // 12-bit pixels, packed 2 pixels per 3 bytes
+} led_pixel_format_t;
+
+// Receive-to-wire latency histogram bucket upper bounds in microseconds
+#define LED_LATENCY_HISTOGRAM_BUCKETS 8
+#define LED_LATENCY_HISTOGRAM_BOUNDS_US {1000, 2000, 4000, 8000, 16000, 32000, 64000, UINT32_MAX}
+
+/**
+ * Output pipeline statistics (cumulative)
+ */
+typedef struct {
+    uint32_t frames_displayed;      // Transmissions carrying received LED data
+    uint32_t frames_skipped;        // Transmit requests refused because the RMT was busy
+    uint32_t encode_count;          // Transmissions encoded
+    uint64_t encode_time_total_us;  // Time spent converting the buffer to RMT items
+    uint32_t encode_time_max_us;
+    uint32_t last_wire_time_us;     // RMT start to end of the last transmission
+    int64_t last_display_us;        // RMT start of the last transmission carrying LED data
+    uint32_t latency_histogram[LED_LATENCY_HISTOGRAM_BUCKETS];  // Receive to RMT start
+} led_pipeline_stats_t;
+
 /**
  * LED breathing effect parameters
  */
@@ -53,7 +79,28 @@ esp_err_t led_driver_init(gpio_num_t data_pin);
  * @param len Length of data in bytes
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t led_driver_update_buffer(uint16_t offset, const uint8_t* data, size_t len);
+esp_err_t led_driver_update_buffer(uint32_t offset, const uint8_t* data, size_t len);
+
+/**
+ * Update LED buffer with reduced bit-depth pixels
+ * Pixels are expanded through lookup tables into the configured color order;
+ * the W channel (if any) is set to 0.
+ * @param led_offset Offset in LED units
+ * @param format Pixel format of data
+ * @param data Packed pixel data
+ * @param len Length of data in bytes
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t led_driver_update_buffer_packed(uint16_t led_offset, led_pixel_format_t format,
+                                          const uint8_t* data, size_t len);
+
+/**
+ * Get number of pixels contained in a packed buffer
+ * @param format Pixel format
+ * @param len Length of packed data in bytes
+ * @return Number of complete pixels
+ */
+size_t led_driver_packed_pixel_count(led_pixel_format_t format, size_t len);
 
 /**
  * Transmit all LED data to the strip
@@ -162,6 +209,50 @@ esp_err_t led_driver_wait_transmission_complete(uint32_t timeout_ms);
 esp_err_t led_driver_get_stats(uint32_t* transmissions, uint32_t* bytes_transmitted,
                               uint32_t* last_transmission_time);
 
+/**
+ * Take the LED pipeline lock
+ * The native UDP task, the DDP, E1.31 and Art-Net tasks, the jitter
+ * buffer and the breathing effect all write the LED buffer and transmit
+ * it. Holding this lock from the buffer update to the transmit keeps a
+ * frame from being torn and the RMT channel from being started twice.
+ * It is recursive, so a receiver can hold it around a callback that takes
+ * it again.
+ */
+void led_driver_lock(void);
+
+/**
+ * Release the LED pipeline lock
+ */
+void led_driver_unlock(void);
+
+/**
+ * Record when the data for the next transmission was received
+ * The next transmission's start time minus this is reported as the
+ * frame's receive-to-wire latency.
+ * @param rx_time_us esp_timer time the data arrived
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t led_driver_mark_frame_received(int64_t rx_time_us);
+
+/**
+ * Get receive-to-wire latency of the last frame
+ * @return Latency in microseconds, 0 if unknown
+ */
+uint32_t led_driver_get_last_frame_latency_us(void);
+
+/**
+ * Get the time the last transmission started on the wire
+ * @return esp_timer time in microseconds, 0 if nothing was transmitted
+ */
+int64_t led_driver_get_last_transmit_start_us(void);
+
+/**
+ * Get output pipeline statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t led_driver_get_pipeline_stats(led_pipeline_stats_t* stats);
+
 /**
  * Reset transmission statistics
  * @return ESP_OK on success, error code otherwise
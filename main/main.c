@@ -13,6 +13,7 @@
 #include "nvs_flash.h"
 #include "driver/gpio.h"
 #include "esp_flash.h"
+#include "esp_timer.h"
 
 #include "config.h"
 #include "state_machine.h"
@@ -20,9 +21,31 @@
 #include "mdns_service.h"
 #include "udp_server.h"
 #include "led_driver.h"
+#include "jitter_buffer.h"
+#include "clock_sync.h"
+#include "telemetry.h"
+#include "backpressure.h"
+#include "ddp_server.h"
+#include "e131_receiver.h"
+#include "artnet_receiver.h"
+#include "source_arbiter.h"
 
 static const char *TAG = "MAIN";
 
+static int64_t g_app_main_us = 0;      // Boot time when app_main() was entered
+
+// WiFi drop recovery: disconnect to the first frame shown after reconnecting
+static esp_ip4_addr_t g_last_ip = {0};
+static struct {
+    bool pending;               // Link lost, no frame shown since reconnecting
+    bool reconnected;
+    int64_t lost_us;
+    uint32_t frames_baseline;   // frames_displayed when the link came back
+    uint32_t count;
+    uint32_t last_ms;
+    uint32_t max_ms;
+} g_recovery = {0};
+
 // LED data timeout detection
 static TimerHandle_t g_led_timeout_timer = NULL;
 static bool g_led_data_active = false;
@@ -33,6 +56,7 @@ static bool g_led_data_active = false;
  */
 static void led_timeout_callback(TimerHandle_t xTimer)
 {
+    led_driver_lock();
     if (g_led_data_active) {
         ESP_LOGI(TAG, "LED data timeout - resuming breathing effect");
         g_led_data_active = false;
@@ -40,11 +64,15 @@ static void led_timeout_callback(TimerHandle_t xTimer)
         // Resume full breathing effect
         led_driver_set_mixed_mode(false);
 
+        // Nothing to receive in a hurry any more; let the modem sleep
+        wifi_manager_set_streaming(false);
+
         // Ensure breathing effect is enabled
         if (!led_driver_is_breathing_enabled()) {
             led_driver_set_breathing_effect(true);
         }
     }
+    led_driver_unlock();
 }
 
 /**
@@ -107,6 +135,9 @@ static void print_system_info(void)
     ESP_LOGI(TAG, "  - LED Data Pin: GPIO%d", LED_DATA_PIN);
     ESP_LOGI(TAG, "  - Max LEDs: %d", MAX_LED_COUNT);
     ESP_LOGI(TAG, "  - UDP Port: %d", UDP_PORT);
+    #if CONFIG_DDP_SERVER_ENABLE
+    ESP_LOGI(TAG, "  - DDP Port: %d", DDP_PORT);
+    #endif
     ESP_LOGI(TAG, "  - mDNS Service: %s.%s.local", MDNS_SERVICE_NAME, MDNS_PROTOCOL);
 }
 
@@ -117,16 +148,47 @@ static void wifi_event_callback(wifi_status_t status, esp_ip4_addr_t ip_addr)
 {
     switch (status) {
         case WIFI_STATUS_CONNECTED:
-            ESP_LOGI(TAG, "WiFi connected, starting mDNS service");
-            mdns_service_start(ip_addr);
+            // A new lease without a drop keeps the responder running, and
+            // only the address record needs announcing
+            if (mdns_service_is_running()) {
+                mdns_service_update_ip(ip_addr);
+            } else {
+                ESP_LOGI(TAG, "WiFi connected, starting mDNS service");
+                mdns_service_start(ip_addr);
+            }
+
+            // Receivers are bound to any address, so they carry on as they
+            // are; only multicast memberships are tied to the old address
+            if (g_last_ip.addr != 0 && g_last_ip.addr != ip_addr.addr) {
+                ESP_LOGI(TAG, "IP address changed, renewing multicast memberships");
+                udp_server_rejoin_multicast();
+                e131_receiver_rejoin_multicast();
+            }
+            g_last_ip = ip_addr;
+
+            if (g_recovery.pending && !g_recovery.reconnected) {
+                led_pipeline_stats_t pipeline = {0};
+                led_driver_get_pipeline_stats(&pipeline);
+                g_recovery.frames_baseline = pipeline.frames_displayed;
+                g_recovery.reconnected = true;
+                ESP_LOGI(TAG, "Link back after %" PRId64 " ms",
+                         (esp_timer_get_time() - g_recovery.lost_us) / 1000);
+            }
+
             state_machine_handle_event(EVENT_NETWORK_READY);
             state_machine_handle_event(EVENT_UDP_START);
             break;
 
         case WIFI_STATUS_DISCONNECTED:
-            ESP_LOGW(TAG, "WiFi disconnected, stopping services");
+            // The receiver tasks and the LED buffer are kept, so streaming
+            // resumes with the first packet after reassociation
+            ESP_LOGW(TAG, "WiFi disconnected, keeping receivers running");
             mdns_service_stop();
-            udp_server_stop();
+            if (!g_recovery.pending) {
+                g_recovery.pending = true;
+                g_recovery.reconnected = false;
+                g_recovery.lost_us = esp_timer_get_time();
+            }
             state_machine_handle_event(EVENT_WIFI_DISCONNECTED);
             break;
 
@@ -141,12 +203,11 @@ static void wifi_event_callback(wifi_status_t status, esp_ip4_addr_t ip_addr)
 }
 
 /**
- * LED data callback from UDP server
+ * Switch to LED data mode and keep the data timeout alive
+ * Called with the LED pipeline lock held.
  */
-static void led_data_callback(uint16_t offset, const uint8_t* data, size_t len)
+static void led_data_activity(void)
 {
-    ESP_LOGD(TAG, "Received LED data: offset=%d, len=%d", offset, len);
-
     // Switch to mixed mode if not already active
     if (!g_led_data_active) {
         ESP_LOGI(TAG, "LED data received - switching to mixed mode");
@@ -155,6 +216,9 @@ static void led_data_callback(uint16_t offset, const uint8_t* data, size_t len)
         // Enable mixed mode (breathing status LED + LED data)
         led_driver_set_mixed_mode(true);
 
+        // Modem sleep would hold packets back until the next beacon
+        wifi_manager_set_streaming(true);
+
         // Ensure breathing effect is enabled for status LED
         if (!led_driver_is_breathing_enabled()) {
             led_driver_set_breathing_effect(true);
@@ -166,6 +230,36 @@ static void led_data_callback(uint16_t offset, const uint8_t* data, size_t len)
         xTimerReset(g_led_timeout_timer, 0);
     }
 
+    // Frames are shown after their data arrives, so the first one shown
+    // since reconnecting is seen with the next frame's data
+    if (g_recovery.reconnected) {
+        led_pipeline_stats_t pipeline = {0};
+        led_driver_get_pipeline_stats(&pipeline);
+        if (pipeline.frames_displayed != g_recovery.frames_baseline) {
+            uint32_t recovery_ms = (uint32_t)((pipeline.last_display_us - g_recovery.lost_us) / 1000);
+            g_recovery.count++;
+            g_recovery.last_ms = recovery_ms;
+            if (recovery_ms > g_recovery.max_ms) {
+                g_recovery.max_ms = recovery_ms;
+            }
+            g_recovery.pending = false;
+            g_recovery.reconnected = false;
+            ESP_LOGI(TAG, "Recovered from WiFi drop: first frame shown %" PRIu32 " ms after disconnect",
+                     recovery_ms);
+        }
+    }
+}
+
+/**
+ * LED data callback from UDP server
+ */
+static void led_data_callback(uint32_t offset, const uint8_t* data, size_t len)
+{
+    ESP_LOGD(TAG, "Received LED data: offset=%" PRIu32 ", len=%d", offset, len);
+
+    led_driver_lock();
+    led_data_activity();
+
     // Update LED buffer
     esp_err_t ret = led_driver_update_buffer(offset, data, len);
     if (ret == ESP_OK) {
@@ -174,7 +268,125 @@ static void led_data_callback(uint16_t offset, const uint8_t* data, size_t len)
     } else {
         ESP_LOGW(TAG, "Failed to update LED buffer: %s", esp_err_to_name(ret));
     }
+    led_driver_unlock();
+}
+
+/**
+ * Packed (RGB565/RGB444) LED data callback from UDP server
+ */
+static void led_packed_data_callback(uint16_t led_offset, led_pixel_format_t format,
+                                     const uint8_t* data, size_t len)
+{
+    ESP_LOGD(TAG, "Received packed LED data: led_offset=%d, format=%d, len=%d",
+             led_offset, format, len);
+
+    led_driver_lock();
+    led_data_activity();
+
+    // Expand pixels into LED buffer
+    esp_err_t ret = led_driver_update_buffer_packed(led_offset, format, data, len);
+    if (ret == ESP_OK) {
+        // Transmit updated data
+        led_driver_transmit_all();
+    } else {
+        ESP_LOGW(TAG, "Failed to update LED buffer: %s", esp_err_to_name(ret));
+    }
+    led_driver_unlock();
+}
+
+/**
+ * Scatter LED data callback from UDP server
+ */
+static void led_scatter_callback(const led_data_run_t* runs, size_t run_count)
+{
+    ESP_LOGD(TAG, "Received scatter LED data: %d runs", run_count);
+
+    led_driver_lock();
+    led_data_activity();
+
+    // Apply every run before a single transmit so the update is atomic.
+    // update_buffer() clips a run that ends past the configured LEDs; one
+    // that starts past them has nothing for this board and is skipped, so
+    // no run is rejected after earlier ones were written.
+    size_t buffer_size = led_driver_get_buffer_size();
+    size_t applied = 0;
+    for (size_t i = 0; i < run_count; i++) {
+        if (runs[i].offset >= buffer_size) {
+            continue;
+        }
+        esp_err_t ret = led_driver_update_buffer(runs[i].offset, runs[i].data, runs[i].len);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to update LED buffer: %s", esp_err_to_name(ret));
+            break;
+        }
+        applied++;
+    }
+
+    if (applied > 0) {
+        led_driver_transmit_all();
+    }
+    led_driver_unlock();
+}
+
+/**
+ * Timestamped LED data callback from UDP server
+ */
+static void led_timed_data_callback(uint64_t pts_us, uint32_t offset, const uint8_t* data,
+                                    size_t len, bool push)
+{
+    led_driver_lock();
+    led_data_activity();
+    led_driver_unlock();
+
+    esp_err_t ret = jitter_buffer_write(pts_us, offset, data, len, push);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to queue timestamped LED data: %s", esp_err_to_name(ret));
+    }
+}
+
+/**
+ * Jitter buffer presentation callback
+ */
+static void jitter_present_callback(const uint8_t* frame, size_t len)
+{
+    led_driver_lock();
+    led_data_activity();
+
+    esp_err_t ret = led_driver_update_buffer(0, frame, len);
+    if (ret == ESP_OK) {
+        led_driver_transmit_all();
+    } else {
+        ESP_LOGW(TAG, "Failed to update LED buffer: %s", esp_err_to_name(ret));
+    }
+    led_driver_unlock();
+}
+
+#if CONFIG_DDP_SERVER_ENABLE || CONFIG_E131_RECEIVER_ENABLE || CONFIG_ARTNET_RECEIVER_ENABLE
+/**
+ * Buffered LED data callback from the DDP, E1.31 and Art-Net receivers
+ * Packets only fill the LED buffer; the frame is shown on push. Each
+ * receiver runs on its own task, so the update and the transmit are done
+ * under the LED pipeline lock.
+ */
+static void push_data_callback(uint32_t offset, const uint8_t* data, size_t len, bool push)
+{
+    led_driver_lock();
+    led_data_activity();
+
+    esp_err_t ret = ESP_OK;
+    if (len > 0) {
+        ret = led_driver_update_buffer(offset, data, len);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to update LED buffer: %s", esp_err_to_name(ret));
+        }
+    }
+
+    if (push && ret == ESP_OK) {
+        led_driver_transmit_all();
+    }
+    led_driver_unlock();
 }
+#endif
 
 /**
  * State machine transition callback
@@ -235,6 +447,35 @@ static esp_err_t state_transition_callback(system_state_t from_state, system_sta
             esp_err_t udp_result = udp_server_start();
             if (udp_result == ESP_OK) {
                 ESP_LOGI(TAG, "UDP server started successfully");
+                static bool boot_time_logged = false;
+                if (!boot_time_logged) {
+                    wifi_connect_timing_t timing = {0};
+                    wifi_manager_get_connect_timing(&timing);
+                    ESP_LOGI(TAG, "app_main to UDP listening: %" PRId64 " ms (%s, %s)",
+                             (esp_timer_get_time() - g_app_main_us) / 1000,
+                             timing.cached_ap ? "cached AP" : "scan",
+                             timing.static_ip ? "static IP" : "DHCP");
+                    boot_time_logged = true;
+                }
+                #if CONFIG_DDP_SERVER_ENABLE
+                esp_err_t ddp_result = ddp_server_start();
+                if (ddp_result != ESP_OK) {
+                    // Native protocol keeps working without DDP
+                    ESP_LOGE(TAG, "Failed to start DDP server: %s", esp_err_to_name(ddp_result));
+                }
+                #endif
+                #if CONFIG_E131_RECEIVER_ENABLE
+                esp_err_t e131_result = e131_receiver_start();
+                if (e131_result != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to start E1.31 receiver: %s", esp_err_to_name(e131_result));
+                }
+                #endif
+                #if CONFIG_ARTNET_RECEIVER_ENABLE
+                esp_err_t artnet_result = artnet_receiver_start();
+                if (artnet_result != ESP_OK) {
+                    ESP_LOGE(TAG, "Failed to start Art-Net receiver: %s", esp_err_to_name(artnet_result));
+                }
+                #endif
             } else {
                 ESP_LOGE(TAG, "Failed to start UDP server: %s", esp_err_to_name(udp_result));
                 state_machine_handle_event(EVENT_UDP_FAILED);
@@ -319,6 +560,29 @@ static esp_err_t init_system_modules(void)
         return ret;
     }
 
+    // Initialize clock sync (host time for timestamped frames)
+    ret = clock_sync_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize clock sync: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Initialize telemetry (reports start when a host subscribes)
+    ret = telemetry_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize telemetry: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    #if CONFIG_BACKPRESSURE_ENABLE
+    // Initialize backpressure reports (sent only while a host streams)
+    ret = backpressure_init();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize backpressure reports: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    #endif
+
     // Initialize UDP server
     ret = udp_server_init(config_get_udp_port());
     if (ret != ESP_OK) {
@@ -328,6 +592,19 @@ static esp_err_t init_system_modules(void)
 
     // Register UDP callbacks
     udp_server_register_led_callback(led_data_callback);
+    udp_server_register_packed_led_callback(led_packed_data_callback);
+    udp_server_register_scatter_callback(led_scatter_callback);
+    udp_server_register_timed_led_callback(led_timed_data_callback);
+
+    #if CONFIG_DDP_SERVER_ENABLE
+    // Initialize DDP server
+    ret = ddp_server_init(DDP_PORT);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize DDP server: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ddp_server_register_data_callback(push_data_callback);
+    #endif
 
     // Initialize LED driver
     ret = led_driver_init((gpio_num_t)config_get_led_pin());
@@ -343,6 +620,34 @@ static esp_err_t init_system_modules(void)
       return ret;
     }
 
+    // Initialize jitter buffer for timestamped frames
+    ret = jitter_buffer_init(led_driver_get_buffer_size());
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize jitter buffer: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    jitter_buffer_register_present_callback(jitter_present_callback);
+
+    #if CONFIG_E131_RECEIVER_ENABLE
+    // Initialize E1.31 receiver (universe table follows the LED count)
+    ret = e131_receiver_init(CONFIG_E131_START_UNIVERSE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize E1.31 receiver: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    e131_receiver_register_data_callback(push_data_callback);
+    #endif
+
+    #if CONFIG_ARTNET_RECEIVER_ENABLE
+    // Initialize Art-Net receiver (universe table follows the LED count)
+    ret = artnet_receiver_init(CONFIG_ARTNET_START_UNIVERSE);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize Art-Net receiver: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    artnet_receiver_register_data_callback(push_data_callback);
+    #endif
+
     // Create LED data timeout timer
     g_led_timeout_timer = xTimerCreate("led_timeout",
                                       pdMS_TO_TICKS(LED_DATA_TIMEOUT_MS),
@@ -360,6 +665,7 @@ static esp_err_t init_system_modules(void)
 
 void app_main(void)
 {
+    g_app_main_us = esp_timer_get_time();
     ESP_LOGI(TAG, "Starting ESP32-C3 Ambient Light Board");
 
     // Initialize NVS
@@ -394,13 +700,6 @@ void app_main(void)
 
     ESP_LOGI(TAG, "System initialization complete");
 
-    // TEMPORARY: Force start mDNS service for debugging
-    ESP_LOGI(TAG, "=== FORCE STARTING MDNS SERVICE FOR DEBUGGING ===");
-    esp_ip4_addr_t debug_ip;
-    debug_ip.addr = esp_ip4addr_aton("192.168.31.182");  // Use current IP
-    esp_err_t mdns_debug_result = mdns_service_start(debug_ip);
-    ESP_LOGI(TAG, "Force mDNS start result: %s", esp_err_to_name(mdns_debug_result));
-
     // Main monitoring loop
     while (1) {
         // Print system status every 30 seconds
@@ -409,10 +708,86 @@ void app_main(void)
                  esp_get_free_heap_size());
 
         // Print statistics
-        uint32_t packets, bytes, led_packets, ping_packets;
-        if (udp_server_get_stats(&packets, &bytes, &led_packets, &ping_packets) == ESP_OK) {
-            ESP_LOGI(TAG, "UDP stats: %" PRIu32 " packets (%" PRIu32 " bytes), %" PRIu32 " LED, %" PRIu32 " ping",
-                     packets, bytes, led_packets, ping_packets);
+        udp_server_stats_t udp_stats;
+        if (udp_server_get_stats(&udp_stats) == ESP_OK) {
+            ESP_LOGI(TAG, "UDP stats: %" PRIu32 " packets (%" PRIu32 " bytes), %" PRIu32 " LED, %" PRIu32 " ping, %" PRIu32 " invalid",
+                     udp_stats.packets_received, udp_stats.bytes_received, udp_stats.led_packets,
+                     udp_stats.ping_packets, udp_stats.invalid_packets);
+            ESP_LOGI(TAG, "Sequencing: %" PRIu32 " lost, %" PRIu32 " reordered, %" PRIu32 " duplicate, %" PRIu32 " stale",
+                     udp_stats.lost_packets, udp_stats.reordered_packets,
+                     udp_stats.duplicate_packets, udp_stats.stale_packets);
+            if (udp_stats.fec_recovered_packets > 0 || udp_stats.fec_unrecoverable_frames > 0) {
+                ESP_LOGI(TAG, "FEC: %" PRIu32 " packets rebuilt, %" PRIu32 " frames recovered, %" PRIu32 " unrecoverable",
+                         udp_stats.fec_recovered_packets, udp_stats.fec_recovered_frames,
+                         udp_stats.fec_unrecoverable_frames);
+            }
+            if (udp_stats.reliable_frames > 0 || udp_stats.reliable_dropped_frames > 0) {
+                ESP_LOGI(TAG, "Reliable frames: %" PRIu32 " delivered (%" PRIu32 " after NACK), %" PRIu32 " dropped, %" PRIu32 " NACKs sent",
+                         udp_stats.reliable_frames, udp_stats.reliable_recovered_frames,
+                         udp_stats.reliable_dropped_frames, udp_stats.nacks_sent);
+            }
+            ESP_LOGI(TAG, "UDP receive: %" PRIu32 " us avg, %" PRIu32 " us max per datagram, %" PRIu32 " chained, %" PRIu32 " bytes stack free",
+                     udp_stats.handle_time_avg_us, udp_stats.handle_time_max_us,
+                     udp_stats.chained_packets, udp_stats.stack_free_min);
+            if (udp_stats.outside_slice_packets > 0) {
+                ESP_LOGI(TAG, "Shared frame: %" PRIu32 " packets for other boards",
+                         udp_stats.outside_slice_packets);
+            }
+        }
+
+        #if CONFIG_BACKPRESSURE_ENABLE
+        backpressure_stats_t bp_stats;
+        if (backpressure_get_stats(&bp_stats) == ESP_OK && bp_stats.reports_sent > 0) {
+            ESP_LOGI(TAG, "Backpressure: offered %" PRIu32 ".%" PRIu32 " fps, achievable %" PRIu32 ".%" PRIu32 " fps, %" PRIu32 " permille dropped, %" PRIi32 " bytes queued%s",
+                     bp_stats.offered_fps_x10 / 10, bp_stats.offered_fps_x10 % 10,
+                     bp_stats.achievable_fps_x10 / 10, bp_stats.achievable_fps_x10 % 10,
+                     bp_stats.drop_permille, bp_stats.rx_queue_bytes,
+                     bp_stats.overloaded ? " (overloaded)" : "");
+        }
+        #endif
+
+        if (g_recovery.count > 0) {
+            ESP_LOGI(TAG, "WiFi recovery: %" PRIu32 " drops, last %" PRIu32 " ms, max %" PRIu32 " ms to the first frame",
+                     g_recovery.count, g_recovery.last_ms, g_recovery.max_ms);
+        }
+
+        source_arbiter_source_t sources[SOURCE_ARBITER_MAX_SOURCES];
+        size_t source_count;
+        if (source_arbiter_get_sources(sources, SOURCE_ARBITER_MAX_SOURCES, &source_count) == ESP_OK &&
+            source_count > 1) {
+            for (size_t i = 0; i < source_count; i++) {
+                uint32_t addr = sources[i].address.sin_addr.s_addr;
+                ESP_LOGI(TAG, "Source %d.%d.%d.%d:%d%s: priority %d, %" PRIu32 " accepted, %" PRIu32 " rejected, idle %" PRIu32 " ms",
+                         (int)((addr >> 0) & 0xFF), (int)((addr >> 8) & 0xFF),
+                         (int)((addr >> 16) & 0xFF), (int)((addr >> 24) & 0xFF),
+                         ntohs(sources[i].address.sin_port), sources[i].owner ? " (owner)" : "",
+                         sources[i].priority, sources[i].accepted_packets,
+                         sources[i].rejected_packets, sources[i].idle_ms);
+            }
+        }
+
+        ddp_server_stats_t ddp_stats;
+        if (ddp_server_get_stats(&ddp_stats) == ESP_OK && ddp_stats.packets_received > 0) {
+            ESP_LOGI(TAG, "DDP stats: %" PRIu32 " packets (%" PRIu32 " bytes), %" PRIu32 " data, %" PRIu32 " frames pushed, %" PRIu32 " invalid",
+                     ddp_stats.packets_received, ddp_stats.bytes_received, ddp_stats.data_packets,
+                     ddp_stats.frames_pushed, ddp_stats.invalid_packets);
+        }
+
+        e131_receiver_stats_t e131_stats;
+        if (e131_receiver_get_stats(&e131_stats) == ESP_OK && e131_stats.packets_received > 0) {
+            ESP_LOGI(TAG, "E1.31 stats: %" PRIu32 " packets, %" PRIu32 " data, %" PRIu32 " sync, %" PRIu32 " frames, %" PRIu32 " ignored, %" PRIu32 " out of order, %" PRIu32 " invalid",
+                     e131_stats.packets_received, e131_stats.data_packets, e131_stats.sync_packets,
+                     e131_stats.frames_committed, e131_stats.ignored_packets,
+                     e131_stats.sequence_errors, e131_stats.invalid_packets);
+        }
+
+        artnet_receiver_stats_t artnet_stats;
+        if (artnet_receiver_get_stats(&artnet_stats) == ESP_OK && artnet_stats.packets_received > 0) {
+            ESP_LOGI(TAG, "Art-Net stats: %" PRIu32 " packets, %" PRIu32 " ArtDmx, %" PRIu32 " ArtSync, %" PRIu32 " frames, %" PRIu32 " poll replies, %" PRIu32 " ignored, %" PRIu32 " invalid",
+                     artnet_stats.packets_received, artnet_stats.dmx_packets,
+                     artnet_stats.sync_packets, artnet_stats.frames_committed,
+                     artnet_stats.poll_replies, artnet_stats.ignored_packets,
+                     artnet_stats.invalid_packets);
         }
 
         uint32_t transmissions, led_bytes, last_tx;
@@ -420,6 +795,32 @@ void app_main(void)
             ESP_LOGI(TAG, "LED stats: %" PRIu32 " transmissions (%" PRIu32 " bytes)", transmissions, led_bytes);
         }
 
+        clock_sync_status_t sync_status;
+        if (clock_sync_get_status(&sync_status) == ESP_OK && sync_status.samples > 0) {
+            ESP_LOGI(TAG, "Clock sync: %s, offset %" PRId64 " us, drift %" PRId32 " ppb, error +/-%" PRIu32 " us, rtt %" PRIu32 " us, %" PRIu32 " samples, %" PRIu32 " timeouts",
+                     sync_status.synced ? "synced" : "not synced", sync_status.offset_us,
+                     sync_status.drift_ppb, sync_status.error_us, sync_status.min_rtt_us,
+                     sync_status.samples, sync_status.timeouts);
+        }
+
+        jitter_buffer_stats_t jitter_stats;
+        if (jitter_buffer_get_stats(&jitter_stats) == ESP_OK && jitter_stats.frames_queued > 0) {
+            ESP_LOGI(TAG, "Jitter buffer: %" PRIu32 " queued, %" PRIu32 " presented, %" PRIu32 " late, %" PRIu32 " overflow, depth %d (max %d)",
+                     jitter_stats.frames_queued, jitter_stats.frames_presented,
+                     jitter_stats.late_drops, jitter_stats.overflow_drops,
+                     jitter_stats.depth, jitter_stats.max_depth);
+            ESP_LOGI(TAG, "Presentation error <=0.25/0.5/1/2/4/8/16/>16 ms: %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32,
+                     jitter_stats.error_histogram[0], jitter_stats.error_histogram[1],
+                     jitter_stats.error_histogram[2], jitter_stats.error_histogram[3],
+                     jitter_stats.error_histogram[4], jitter_stats.error_histogram[5],
+                     jitter_stats.error_histogram[6], jitter_stats.error_histogram[7]);
+            if (jitter_stats.grid_frames > 0) {
+                ESP_LOGI(TAG, "Grid phase: %" PRIu32 " frames, last %" PRId32 " us, max %" PRIu32 " us",
+                         jitter_stats.grid_frames, jitter_stats.last_phase_error_us,
+                         jitter_stats.max_phase_error_us);
+            }
+        }
+
         vTaskDelay(pdMS_TO_TICKS(30000));
     }
 }
\ No newline at end of file
@@ -1,10 +1,18 @@
 #include "mdns_service.h"
 #include "config.h"
+#include "capabilities.h"
+#include "wifi_manager.h"
+#include "udp_server.h"
+#include "led_driver.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "mdns.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
 
 static const char *TAG = "MDNS_SERVICE";
 
@@ -13,17 +21,210 @@ static bool g_mdns_initialized = false;
 static bool g_mdns_running = false;
 static TimerHandle_t g_announce_timer = NULL;
 static esp_ip4_addr_t g_current_ip = {0};
+static int64_t g_got_ip_us = 0;         // When the current address was started
+static uint32_t g_burst_left = 0;       // Burst announcements still to send
+static uint32_t g_burst_interval_ms = 0;
+static TimerHandle_t g_txt_timer = NULL;
+static int64_t g_txt_time_us = 0;       // When the TXT records were last replaced
+
+// What the board can do; only republished while nothing streams
+typedef struct {
+    char max_leds[8];
+    char channels[4];
+    char order[5];
+    char formats[20];
+    char receivers[16];
+    char fps[8];
+    char proto[4];
+} txt_caps_t;
+
+// TXT record values, as published
+typedef struct {
+    txt_caps_t caps;
+    bool busy;
+    char owner[16];
+} txt_values_t;
+
+static txt_values_t g_txt = {0};
+
+/**
+ * Ask the responder to announce on the station interface
+ * Multicast on WiFi is lossy, so a desktop can miss the responder's own
+ * three announcements; repeating them covers for that.
+ */
+static void announce(void)
+{
+    esp_err_t ret = mdns_netif_action(wifi_manager_get_netif(), MDNS_EVENT_ANNOUNCE_IP4);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to announce: %s", esp_err_to_name(ret));
+        return;
+    }
+    ESP_LOGD(TAG, "Announced " IPSTR ", %" PRId64 " ms after got-IP",
+             IP2STR(&g_current_ip), (esp_timer_get_time() - g_got_ip_us) / 1000);
+}
+
+/**
+ * Start the burst, first announcement after MDNS_ANNOUNCE_BURST_FIRST_MS
+ */
+static void start_burst(void)
+{
+    g_burst_left = MDNS_ANNOUNCE_BURST_COUNT;
+    g_burst_interval_ms = MDNS_ANNOUNCE_BURST_FIRST_MS;
+    if (g_announce_timer) {
+        xTimerChangePeriod(g_announce_timer, pdMS_TO_TICKS(MDNS_ANNOUNCE_BURST_FIRST_MS), 0);
+        xTimerStart(g_announce_timer, 0);
+    }
+}
+
+/**
+ * Append a name to a comma-separated list
+ */
+static void append_name(char* list, size_t size, const char* name)
+{
+    size_t len = strlen(list);
+    snprintf(list + len, size - len, "%s%s", len ? "," : "", name);
+}
+
+/**
+ * Collect the TXT values from the live capabilities and stream state
+ */
+static void collect_txt_values(txt_values_t* values)
+{
+    memset(values, 0, sizeof(*values));
+
+    capabilities_t caps;
+    capabilities_get(&caps);
+    txt_caps_t* c = &values->caps;
+    snprintf(c->max_leds, sizeof(c->max_leds), "%u", caps.led_count);
+    snprintf(c->channels, sizeof(c->channels), "%u", caps.channels);
+    strncpy(c->order, caps.color_order, sizeof(c->order) - 1);
+    snprintf(c->fps, sizeof(c->fps), "%" PRIu32, caps.max_fps_x10 / 10);
+    snprintf(c->proto, sizeof(c->proto), "%u", caps.protocol_version);
+
+    if (caps.pixel_formats & CAPABILITY_FORMAT_RAW) {
+        append_name(c->formats, sizeof(c->formats), "raw");
+    }
+    if (caps.pixel_formats & CAPABILITY_FORMAT_RGB565) {
+        append_name(c->formats, sizeof(c->formats), "rgb565");
+    }
+    if (caps.pixel_formats & CAPABILITY_FORMAT_RGB444) {
+        append_name(c->formats, sizeof(c->formats), "rgb444");
+    }
+    if (caps.receivers & CAPABILITY_RECEIVER_DDP) {
+        append_name(c->receivers, sizeof(c->receivers), "ddp");
+    }
+    if (caps.receivers & CAPABILITY_RECEIVER_E131) {
+        append_name(c->receivers, sizeof(c->receivers), "e131");
+    }
+    if (caps.receivers & CAPABILITY_RECEIVER_ARTNET) {
+        append_name(c->receivers, sizeof(c->receivers), "artnet");
+    }
+
+    // Busy while frames from any protocol were shown recently, whoever
+    // holds the arbitration lock; only a native source has an address
+    led_pipeline_stats_t pipeline = {0};
+    led_driver_get_pipeline_stats(&pipeline);
+    values->busy = pipeline.last_display_us > 0 &&
+                   esp_timer_get_time() - pipeline.last_display_us < MDNS_TXT_BUSY_MS * 1000LL;
+
+    struct sockaddr_in source;
+    if (values->busy && udp_server_get_stream_source(&source)) {
+        uint32_t addr = source.sin_addr.s_addr;
+        snprintf(values->owner, sizeof(values->owner), "%d.%d.%d.%d",
+                 (int)((addr >> 0) & 0xFF), (int)((addr >> 8) & 0xFF),
+                 (int)((addr >> 16) & 0xFF), (int)((addr >> 24) & 0xFF));
+    }
+}
+
+/**
+ * Replace the service's TXT records
+ * The responder announces the service on every replacement.
+ */
+static esp_err_t publish_txt_values(const txt_values_t* values)
+{
+    const txt_caps_t* c = &values->caps;
+    mdns_txt_item_t txt_records[] = {
+        {"version", "1.0"},
+        {"device", "esp32c3"},
+        {"type", "ambient_light"},
+        {"protocol", "udp"},
+        {"proto", c->proto},
+        {"max_leds", c->max_leds},
+        {"ch", c->channels},
+        {"order", c->order},
+        {"fmt", c->formats},
+        {"rx", c->receivers},
+        {"fps", c->fps},
+        {"busy", values->busy ? "1" : "0"},
+        {"owner", values->owner}
+    };
+    size_t count = sizeof(txt_records) / sizeof(txt_records[0]);
+    if (!values->owner[0]) {
+        count--;    // owner is last
+    }
+
+    esp_err_t ret = mdns_service_txt_set(MDNS_SERVICE_NAME, MDNS_PROTOCOL, txt_records, count);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set TXT records: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    g_txt = *values;
+    g_txt_time_us = esp_timer_get_time();
+    ESP_LOGD(TAG, "TXT records: %s LEDs, %s fps, busy=%d%s%s", c->max_leds, c->fps,
+             values->busy, values->owner[0] ? " owner=" : "", values->owner);
+    return ESP_OK;
+}
 
 /**
- * Timer callback for periodic mDNS announcements
+ * Timer callback for TXT record updates
+ * Every replacement costs an announcement, so while a source streams only
+ * the busy/owner hint is updated, and while the board is on the network
+ * replacements are at least MDNS_TXT_MIN_INTERVAL_MS apart. A change held
+ * back is published on a later tick.
+ */
+static void mdns_txt_timer_callback(TimerHandle_t xTimer)
+{
+    txt_values_t values;
+    collect_txt_values(&values);
+    if (values.busy) {
+        values.caps = g_txt.caps;
+    }
+
+    if (memcmp(&values.caps, &g_txt.caps, sizeof(values.caps)) == 0 &&
+        values.busy == g_txt.busy && strcmp(values.owner, g_txt.owner) == 0) {
+        return;
+    }
+    if (g_mdns_running &&
+        esp_timer_get_time() - g_txt_time_us < MDNS_TXT_MIN_INTERVAL_MS * 1000LL) {
+        return;
+    }
+
+    publish_txt_values(&values);
+}
+
+/**
+ * Timer callback for mDNS announcements
+ * Runs the burst with doubling intervals, then settles on
+ * MDNS_ANNOUNCE_INTERVAL.
  */
 static void mdns_announce_timer_callback(TimerHandle_t xTimer)
 {
-    if (g_mdns_running) {
-        ESP_LOGD(TAG, "Sending periodic mDNS announcement");
-        // The mDNS library handles periodic announcements automatically
-        ESP_LOGD(TAG, "mDNS periodic announcement (automatic)");
+    if (!g_mdns_running) {
+        return;
     }
+
+    announce();
+
+    uint32_t next_ms = MDNS_ANNOUNCE_INTERVAL;
+    if (g_burst_left > 0) {
+        g_burst_left--;
+        if (g_burst_left > 0) {
+            g_burst_interval_ms *= 2;
+            next_ms = g_burst_interval_ms;
+        }
+    }
+    xTimerChangePeriod(xTimer, pdMS_TO_TICKS(next_ms), 0);
 }
 
 esp_err_t mdns_service_init(void)
@@ -59,19 +260,59 @@ esp_err_t mdns_service_init(void)
         mdns_free();
         return ret;
     }
+
+    // Add UDP service; with no address yet the responder only takes note,
+    // and probes it along with the hostname on got-IP
+    ESP_LOGI(TAG, "Adding mDNS service: %s%s.local on port %d", MDNS_SERVICE_NAME, MDNS_PROTOCOL, UDP_PORT);
+    ret = mdns_service_add(NULL, MDNS_SERVICE_NAME, MDNS_PROTOCOL, UDP_PORT, NULL, 0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add mDNS service: %s", esp_err_to_name(ret));
+        mdns_free();
+        return ret;
+    }
+    ESP_LOGI(TAG, "mDNS service added successfully");
+    
+    // Add service instance
+    ret = mdns_service_instance_name_set(MDNS_SERVICE_NAME, MDNS_PROTOCOL, "ESP32-C3 Ambient Light");
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set service instance name: %s", esp_err_to_name(ret));
+        // Continue anyway, this is not critical
+    }
+    
+    // Add TXT records with device information; details are in the 0x0F
+    // capabilities response. Not critical, the timer retries.
+    txt_values_t values;
+    collect_txt_values(&values);
+    publish_txt_values(&values);
     
-    // Create announcement timer
+    // Create announcement timer; one-shot, each run sets the next interval
     g_announce_timer = xTimerCreate("mdns_announce",
                                    pdMS_TO_TICKS(MDNS_ANNOUNCE_INTERVAL),
-                                   pdTRUE,  // Auto-reload
+                                   pdFALSE,
                                    NULL,
                                    mdns_announce_timer_callback);
     
-    if (!g_announce_timer) {
-        ESP_LOGE(TAG, "Failed to create mDNS announcement timer");
+    // Create TXT update timer
+    g_txt_timer = xTimerCreate("mdns_txt",
+                              pdMS_TO_TICKS(MDNS_TXT_CHECK_INTERVAL_MS),
+                              pdTRUE,  // Auto-reload
+                              NULL,
+                              mdns_txt_timer_callback);
+    
+    if (!g_announce_timer || !g_txt_timer) {
+        ESP_LOGE(TAG, "Failed to create mDNS timers");
+        if (g_announce_timer) {
+            xTimerDelete(g_announce_timer, 0);
+            g_announce_timer = NULL;
+        }
+        if (g_txt_timer) {
+            xTimerDelete(g_txt_timer, 0);
+            g_txt_timer = NULL;
+        }
         mdns_free();
         return ESP_ERR_NO_MEM;
     }
+    xTimerStart(g_txt_timer, 0);
     
     g_mdns_initialized = true;
     ESP_LOGI(TAG, "mDNS service initialized with hostname: %s.local",
@@ -95,45 +336,13 @@ esp_err_t mdns_service_start(esp_ip4_addr_t ip_addr)
     ESP_LOGI(TAG, "Starting mDNS service with IP: " IPSTR, IP2STR(&ip_addr));
     
     g_current_ip = ip_addr;
-    
-    // Add UDP service
-    ESP_LOGI(TAG, "Adding mDNS service: %s%s.local on port %d", MDNS_SERVICE_NAME, MDNS_PROTOCOL, UDP_PORT);
-    esp_err_t ret = mdns_service_add(NULL, MDNS_SERVICE_NAME, MDNS_PROTOCOL, UDP_PORT, NULL, 0);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to add mDNS service: %s", esp_err_to_name(ret));
-        return ret;
-    }
-    ESP_LOGI(TAG, "mDNS service added successfully");
-    
-    // Add service instance
-    ret = mdns_service_instance_name_set(MDNS_SERVICE_NAME, MDNS_PROTOCOL, "ESP32-C3 Ambient Light");
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to set service instance name: %s", esp_err_to_name(ret));
-        // Continue anyway, this is not critical
-    }
-    
-    // Add TXT records with device information
-    mdns_txt_item_t txt_records[] = {
-        {"version", "1.0"},
-        {"device", "esp32c3"},
-        {"type", "ambient_light"},
-        {"max_leds", "500"},
-        {"protocol", "udp"}
-    };
-    
-    ret = mdns_service_txt_set(MDNS_SERVICE_NAME, MDNS_PROTOCOL, txt_records, 
-                              sizeof(txt_records) / sizeof(txt_records[0]));
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to set TXT records: %s", esp_err_to_name(ret));
-        // Continue anyway, this is not critical
-    }
-    
-    // Start periodic announcements
-    if (g_announce_timer) {
-        xTimerStart(g_announce_timer, 0);
-    }
-    
+    g_got_ip_us = esp_timer_get_time();
     g_mdns_running = true;
+
+    // The responder probes for about a second on got-IP and then announces
+    // three times; announcing while it probes would restart the probe, so
+    // the burst starts once the probe is over
+    start_burst();
     
     ESP_LOGI(TAG, "mDNS service started: %s.%s.local:%d", 
              MDNS_SERVICE_NAME, MDNS_PROTOCOL, UDP_PORT);
@@ -154,15 +363,10 @@ esp_err_t mdns_service_stop(void)
     if (g_announce_timer) {
         xTimerStop(g_announce_timer, 0);
     }
-    
-    // Remove service
-    esp_err_t ret = mdns_service_remove(MDNS_SERVICE_NAME, MDNS_PROTOCOL);
-    if (ret != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to remove mDNS service: %s", esp_err_to_name(ret));
-    }
-    
+
+    // The service stays registered; the responder goes quiet with the link
+    // and probes it again on the next got-IP
     g_mdns_running = false;
-    g_current_ip.addr = 0;
     
     ESP_LOGI(TAG, "mDNS service stopped");
     return ESP_OK;
@@ -184,9 +388,12 @@ esp_err_t mdns_service_update_ip(esp_ip4_addr_t ip_addr)
              IP2STR(&g_current_ip), IP2STR(&ip_addr));
     
     g_current_ip = ip_addr;
-    
-    // The mDNS library automatically updates IP addresses when the network interface changes
-    ESP_LOGI(TAG, "mDNS IP address updated automatically");
+    g_got_ip_us = esp_timer_get_time();
+
+    // The name is already ours, so the new address record is announced
+    // at once rather than waiting for the burst
+    announce();
+    start_burst();
     
     return ESP_OK;
 }
@@ -209,12 +416,21 @@ esp_err_t mdns_service_deinit(void)
     if (g_mdns_running) {
         mdns_service_stop();
     }
+
+    esp_err_t ret = mdns_service_remove(MDNS_SERVICE_NAME, MDNS_PROTOCOL);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to remove mDNS service: %s", esp_err_to_name(ret));
+    }
     
-    // Delete timer
+    // Delete timers
     if (g_announce_timer) {
         xTimerDelete(g_announce_timer, 0);
         g_announce_timer = NULL;
     }
+    if (g_txt_timer) {
+        xTimerDelete(g_txt_timer, 0);
+        g_txt_timer = NULL;
+    }
     
     // Free mDNS
     mdns_free();
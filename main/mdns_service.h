@@ -6,12 +6,19 @@
 
 /**
  * Initialize mDNS service
+ * The service is registered here, before the network is up, so the
+ * responder probes hostname and service together on got-IP instead of
+ * restarting its probe when the service is added. Its TXT records follow
+ * the live capabilities and whether a source is streaming; see
+ * MDNS_TXT_MIN_INTERVAL_MS for how often they may change.
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t mdns_service_init(void);
 
 /**
  * Start mDNS service with given IP address
+ * To be called on got-IP. Starts a burst of announcements following the
+ * responder's own, then announces every MDNS_ANNOUNCE_INTERVAL.
  * @param ip_addr IP address to advertise
  * @return ESP_OK on success, error code otherwise
  */
@@ -19,12 +26,14 @@ esp_err_t mdns_service_start(esp_ip4_addr_t ip_addr);
 
 /**
  * Stop mDNS service
+ * Ends the announcements; the service stays registered for the next start.
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t mdns_service_stop(void);
 
 /**
  * Update mDNS service IP address
+ * A changed address is announced right away and the burst restarted.
  * @param ip_addr New IP address to advertise
  * @return ESP_OK on success, error code otherwise
  */
@@ -0,0 +1,149 @@
+#include "sequence_tracker.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "SEQ_TRACKER";
+
+#define SEQUENCE_MAX_SOURCES    4
+#define SEQUENCE_WINDOW         64      // Sequence numbers tracked behind the newest
+#define SEQUENCE_RESTART_GAP    1024    // Larger backward jumps mean the sender restarted
+#define SEQUENCE_IDLE_MS        2000    // Sources silent this long start over
+
+typedef struct {
+    bool in_use;
+    uint32_t addr;
+    uint16_t port;
+    TickType_t last_seen;
+    uint16_t highest_seq;       // Newest sequence number seen
+    uint64_t window;            // Bit n set: highest_seq - n was received
+    bool frame_committed;
+    uint16_t committed_frame;   // Last frame completed by a PUSH
+} source_state_t;
+
+// Global variables
+static source_state_t g_sources[SEQUENCE_MAX_SOURCES];
+static sequence_tracker_stats_t g_stats = {0};
+
+/**
+ * Find the source's state, claiming the least recently seen slot for a new one
+ */
+static source_state_t* get_source(const struct sockaddr_in* source, TickType_t now)
+{
+    source_state_t* oldest = &g_sources[0];
+
+    for (int i = 0; i < SEQUENCE_MAX_SOURCES; i++) {
+        source_state_t* state = &g_sources[i];
+        if (state->in_use && state->addr == source->sin_addr.s_addr &&
+            state->port == source->sin_port) {
+            if (now - state->last_seen > pdMS_TO_TICKS(SEQUENCE_IDLE_MS)) {
+                state->in_use = false;  // Stream paused; don't count the gap as loss
+            }
+            return state;
+        }
+        if (!state->in_use || (oldest->in_use && state->last_seen < oldest->last_seen)) {
+            oldest = state;
+        }
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->addr = source->sin_addr.s_addr;
+    oldest->port = source->sin_port;
+    return oldest;
+}
+
+esp_err_t sequence_tracker_init(void)
+{
+    memset(g_sources, 0, sizeof(g_sources));
+    memset(&g_stats, 0, sizeof(g_stats));
+    ESP_LOGI(TAG, "Sequence tracker initialized");
+    return ESP_OK;
+}
+
+sequence_result_t sequence_tracker_check(const struct sockaddr_in* source, uint16_t seq,
+                                         uint16_t frame_id, bool push)
+{
+    TickType_t now = xTaskGetTickCount();
+    source_state_t* state = get_source(source, now);
+    state->last_seen = now;
+    bool late = false;
+
+    if (!state->in_use) {
+        state->in_use = true;
+        state->highest_seq = seq;
+        state->window = 1;
+        state->frame_committed = false;
+    } else {
+        // Serial number arithmetic so wrap-around at 65535 is seamless
+        int16_t ahead = (int16_t)(seq - state->highest_seq);
+
+        if (ahead > 0) {
+            // Everything skipped over is presumed lost until it shows up,
+            // however long the burst; only the last window's worth can
+            // still turn up and be taken back
+            g_stats.lost += ahead - 1;
+            state->window = ahead >= SEQUENCE_WINDOW ? 0 : state->window << ahead;
+            state->window |= 1;
+            state->highest_seq = seq;
+        } else if (-ahead < SEQUENCE_WINDOW) {
+            uint64_t bit = 1ULL << -ahead;
+            if (state->window & bit) {
+                g_stats.duplicates++;
+                return SEQUENCE_DUPLICATE;
+            }
+            state->window |= bit;
+            if (g_stats.lost > 0) {
+                g_stats.lost--;
+            }
+            late = true;
+        } else if (-ahead > SEQUENCE_RESTART_GAP) {
+            ESP_LOGI(TAG, "Sequence restarted at %u", seq);
+            state->highest_seq = seq;
+            state->window = 1;
+            state->frame_committed = false;
+        } else {
+            // Too old to tell a duplicate from a late packet; either way
+            // its frame has long been superseded
+            g_stats.stale++;
+            return SEQUENCE_STALE;
+        }
+    }
+
+    // A fragment of a frame older than the last completed one would
+    // overwrite newer pixels. A late fragment of that frame itself (a
+    // reordered or rebuilt one) still belongs on top.
+    if (state->frame_committed && (int16_t)(frame_id - state->committed_frame) < 0) {
+        g_stats.stale++;
+        return SEQUENCE_STALE;
+    }
+
+    // Counted only once accepted, so each packet lands in one counter
+    if (late) {
+        g_stats.reordered++;
+    }
+
+    if (push) {
+        state->frame_committed = true;
+        state->committed_frame = frame_id;
+    }
+
+    return SEQUENCE_ACCEPT;
+}
+
+esp_err_t sequence_tracker_get_stats(sequence_tracker_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *stats = g_stats;
+    return ESP_OK;
+}
+
+esp_err_t sequence_tracker_reset(void)
+{
+    memset(g_sources, 0, sizeof(g_sources));
+    memset(&g_stats, 0, sizeof(g_stats));
+    return ESP_OK;
+}
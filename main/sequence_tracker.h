@@ -0,0 +1,59 @@
+#ifndef SEQUENCE_TRACKER_H
+#define SEQUENCE_TRACKER_H
+
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Verdict for one sequenced packet
+ */
+typedef enum {
+    SEQUENCE_ACCEPT,        // Apply the packet
+    SEQUENCE_DUPLICATE,     // Already seen, drop
+    SEQUENCE_STALE          // Belongs to a frame older than the last committed one, drop
+} sequence_result_t;
+
+/**
+ * Sequence tracker counters, summed over all sources
+ */
+typedef struct {
+    uint32_t lost;          // Sequence numbers skipped and not seen while still in the window
+    uint32_t reordered;     // Accepted packets that arrived after a later sequence number
+    uint32_t duplicates;    // Packets seen more than once
+    uint32_t stale;         // Packets dropped for belonging to an old frame
+} sequence_tracker_stats_t;
+
+/**
+ * Initialize sequence tracker
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t sequence_tracker_init(void);
+
+/**
+ * Check a sequenced packet against its source's window
+ * Must be called from a single task (the UDP server task).
+ * @param source Address the packet came from
+ * @param seq Packet sequence number
+ * @param frame_id Frame the packet belongs to
+ * @param push true if the packet completes its frame
+ * @return Verdict for the packet
+ */
+sequence_result_t sequence_tracker_check(const struct sockaddr_in* source, uint16_t seq,
+                                         uint16_t frame_id, bool push);
+
+/**
+ * Get sequence tracker statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t sequence_tracker_get_stats(sequence_tracker_stats_t* stats);
+
+/**
+ * Reset sequence tracker statistics and source windows
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t sequence_tracker_reset(void);
+
+#endif // SEQUENCE_TRACKER_H
@@ -0,0 +1,327 @@
+#include "source_arbiter.h"
+#include "config.h"
+#include "udp_server.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "SOURCE_ARBITER";
+
+typedef struct {
+    bool in_use;
+    uint32_t addr;
+    uint16_t port;
+    uint8_t priority;
+    TickType_t last_seen;
+    uint32_t accepted_packets;
+    uint32_t rejected_packets;
+} source_entry_t;
+
+// Global variables
+static source_arbiter_mode_t g_mode = SOURCE_ARBITER_MODE_NONE;
+static source_entry_t g_sources[SOURCE_ARBITER_MAX_SOURCES];
+static source_entry_t* g_owner = NULL;
+static source_arbiter_stats_t g_stats = {0};
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;  // The owner is also read from other tasks
+
+static void put_be(uint8_t* out, uint32_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static void log_source(const char* what, const source_entry_t* entry)
+{
+    ESP_LOGI(TAG, "%s %d.%d.%d.%d:%d (priority %d)", what,
+             (int)((entry->addr >> 0) & 0xFF), (int)((entry->addr >> 8) & 0xFF),
+             (int)((entry->addr >> 16) & 0xFF), (int)((entry->addr >> 24) & 0xFF),
+             ntohs(entry->port), entry->priority);
+}
+
+/**
+ * Find the source's entry, reusing the least recently seen non-owner slot
+ * for a new one
+ */
+static source_entry_t* get_source(const struct sockaddr_in* source)
+{
+    source_entry_t* oldest = NULL;
+
+    for (int i = 0; i < SOURCE_ARBITER_MAX_SOURCES; i++) {
+        source_entry_t* entry = &g_sources[i];
+        if (entry->in_use && entry->addr == source->sin_addr.s_addr &&
+            entry->port == source->sin_port) {
+            return entry;
+        }
+        if (entry == g_owner) {
+            continue;
+        }
+        if (!oldest || !entry->in_use ||
+            (oldest->in_use && entry->last_seen < oldest->last_seen)) {
+            oldest = entry;
+        }
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->in_use = true;
+    oldest->addr = source->sin_addr.s_addr;
+    oldest->port = source->sin_port;
+    oldest->priority = CONFIG_SOURCE_DEFAULT_PRIORITY;
+    return oldest;
+}
+
+/**
+ * Drop the lock if its owner has gone quiet
+ * Called with g_lock held; nothing may be logged there, so the entry that
+ * lost the lock is copied out for the caller to log.
+ * @return true if the lock was dropped
+ */
+static bool expire_owner(TickType_t now, source_entry_t* expired)
+{
+    if (g_owner && now - g_owner->last_seen > pdMS_TO_TICKS(CONFIG_SOURCE_LOCK_TIMEOUT_MS)) {
+        *expired = *g_owner;
+        g_owner = NULL;
+        g_stats.lock_timeouts++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Try to give the lock to a source
+ * Called with g_lock held.
+ * @param event Set to what to log about the lock, or NULL if it did not move
+ * @return true if the source holds the lock afterwards
+ */
+static bool try_lock(source_entry_t* entry, const char** event)
+{
+    *event = NULL;
+    if (g_owner == entry) {
+        return true;
+    }
+
+    if (g_owner) {
+        if (g_mode != SOURCE_ARBITER_MODE_PRIORITY || entry->priority <= g_owner->priority) {
+            return false;
+        }
+        g_stats.takeovers++;
+        *event = "Lock taken over by";
+    } else {
+        *event = "Lock taken by";
+    }
+
+    g_owner = entry;
+    return true;
+}
+
+/**
+ * Fill in a status packet; called with g_lock held
+ */
+static void build_status(uint8_t* response, bool granted, TickType_t now)
+{
+    memset(response, 0, SOURCE_CLAIM_STATUS_SIZE);
+    response[0] = PACKET_TYPE_SOURCE_CLAIM;
+    response[1] = SOURCE_CLAIM_KIND_STATUS;
+    response[2] = granted ? 1 : 0;
+
+    if (g_owner) {
+        TickType_t idle = now - g_owner->last_seen;
+        TickType_t timeout = pdMS_TO_TICKS(CONFIG_SOURCE_LOCK_TIMEOUT_MS);
+        response[3] = g_owner->priority;
+        memcpy(&response[4], &g_owner->addr, 4);  // Already in network order
+        memcpy(&response[8], &g_owner->port, 2);
+        put_be(&response[10], idle < timeout ? pdTICKS_TO_MS(timeout - idle) : 0, 2);
+    }
+}
+
+esp_err_t source_arbiter_init(void)
+{
+#if CONFIG_SOURCE_ARBITRATION_PRIORITY
+    g_mode = SOURCE_ARBITER_MODE_PRIORITY;
+#elif CONFIG_SOURCE_ARBITRATION_FIRST_COME
+    g_mode = SOURCE_ARBITER_MODE_FIRST_COME;
+#else
+    g_mode = SOURCE_ARBITER_MODE_NONE;
+#endif
+
+    source_arbiter_reset();
+    ESP_LOGI(TAG, "Source arbiter initialized: mode %s, lock timeout %d ms",
+             g_mode == SOURCE_ARBITER_MODE_PRIORITY     ? "priority"
+             : g_mode == SOURCE_ARBITER_MODE_FIRST_COME ? "first-come"
+                                                        : "none",
+             CONFIG_SOURCE_LOCK_TIMEOUT_MS);
+    return ESP_OK;
+}
+
+bool source_arbiter_accept(const struct sockaddr_in* source)
+{
+    TickType_t now = xTaskGetTickCount();
+    portENTER_CRITICAL(&g_lock);
+
+    // Fast path: the owner streaming, which is nearly every packet
+    if (g_owner && g_owner->addr == source->sin_addr.s_addr && g_owner->port == source->sin_port) {
+        g_owner->last_seen = now;
+        g_owner->accepted_packets++;
+        portEXIT_CRITICAL(&g_lock);
+        return true;
+    }
+
+    source_entry_t expired;
+    bool timed_out = expire_owner(now, &expired);
+
+    source_entry_t* entry = get_source(source);
+    entry->last_seen = now;
+
+    const char* event = NULL;
+    bool accepted = g_mode == SOURCE_ARBITER_MODE_NONE || try_lock(entry, &event);
+    if (accepted) {
+        entry->accepted_packets++;
+    } else {
+        entry->rejected_packets++;
+        g_stats.rejected_packets++;
+    }
+    portEXIT_CRITICAL(&g_lock);
+
+    if (timed_out) {
+        log_source("Lock timed out for", &expired);
+    }
+    if (event) {
+        log_source(event, entry);
+    }
+    return accepted;
+}
+
+bool source_arbiter_handle_packet(const uint8_t* data, size_t len, const struct sockaddr_in* source)
+{
+    if (len < SOURCE_CLAIM_HEADER_SIZE || data[0] != PACKET_TYPE_SOURCE_CLAIM) {
+        return false;
+    }
+
+    if (data[1] != SOURCE_CLAIM_KIND_CLAIM && data[1] != SOURCE_CLAIM_KIND_RELEASE) {
+        return false;
+    }
+    if (data[1] == SOURCE_CLAIM_KIND_CLAIM && len < SOURCE_CLAIM_REQUEST_SIZE) {
+        return false;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    uint8_t response[SOURCE_CLAIM_STATUS_SIZE];
+    source_entry_t expired;
+    const char* event = NULL;
+    bool granted = false;
+
+    portENTER_CRITICAL(&g_lock);
+    bool timed_out = expire_owner(now, &expired);
+
+    source_entry_t* entry = get_source(source);
+    entry->last_seen = now;
+
+    if (data[1] == SOURCE_CLAIM_KIND_CLAIM) {
+        entry->priority = data[2];
+        granted = g_mode == SOURCE_ARBITER_MODE_NONE || try_lock(entry, &event);
+    } else if (g_owner == entry) {
+        event = "Lock released by";
+        g_owner = NULL;
+    }
+
+    build_status(response, granted, now);
+    portEXIT_CRITICAL(&g_lock);
+
+    if (timed_out) {
+        log_source("Lock timed out for", &expired);
+    }
+    if (event) {
+        log_source(event, entry);
+    }
+
+    udp_server_send_to(source, response, sizeof(response));
+    return true;
+}
+
+bool source_arbiter_get_owner(struct sockaddr_in* owner)
+{
+    TickType_t now = xTaskGetTickCount();
+    source_entry_t expired;
+    uint32_t addr = 0;
+    uint16_t port = 0;
+
+    // An owner that stopped sending loses the lock here too, not only when
+    // another source shows up
+    portENTER_CRITICAL(&g_lock);
+    bool timed_out = expire_owner(now, &expired);
+    bool held = g_owner != NULL;
+    if (held) {
+        addr = g_owner->addr;
+        port = g_owner->port;
+    }
+    portEXIT_CRITICAL(&g_lock);
+
+    if (timed_out) {
+        log_source("Lock timed out for", &expired);
+    }
+
+    if (held && owner) {
+        memset(owner, 0, sizeof(*owner));
+        owner->sin_family = AF_INET;
+        owner->sin_addr.s_addr = addr;
+        owner->sin_port = port;
+    }
+    return held;
+}
+
+esp_err_t source_arbiter_get_sources(source_arbiter_source_t* sources, size_t max_sources,
+                                     size_t* count)
+{
+    if (!sources || !count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    *count = 0;
+
+    portENTER_CRITICAL(&g_lock);
+    for (int i = 0; i < SOURCE_ARBITER_MAX_SOURCES && *count < max_sources; i++) {
+        const source_entry_t* entry = &g_sources[i];
+        if (!entry->in_use) {
+            continue;
+        }
+
+        source_arbiter_source_t* out = &sources[(*count)++];
+        memset(out, 0, sizeof(*out));
+        out->address.sin_family = AF_INET;
+        out->address.sin_addr.s_addr = entry->addr;
+        out->address.sin_port = entry->port;
+        out->priority = entry->priority;
+        out->owner = entry == g_owner;
+        out->accepted_packets = entry->accepted_packets;
+        out->rejected_packets = entry->rejected_packets;
+        out->idle_ms = pdTICKS_TO_MS(now - entry->last_seen);
+    }
+    portEXIT_CRITICAL(&g_lock);
+
+    return ESP_OK;
+}
+
+esp_err_t source_arbiter_get_stats(source_arbiter_stats_t* stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    portENTER_CRITICAL(&g_lock);
+    *stats = g_stats;
+    portEXIT_CRITICAL(&g_lock);
+    return ESP_OK;
+}
+
+esp_err_t source_arbiter_reset(void)
+{
+    portENTER_CRITICAL(&g_lock);
+    memset(g_sources, 0, sizeof(g_sources));
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_owner = NULL;
+    portEXIT_CRITICAL(&g_lock);
+    return ESP_OK;
+}
@@ -0,0 +1,100 @@
+#ifndef SOURCE_ARBITER_H
+#define SOURCE_ARBITER_H
+
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SOURCE_ARBITER_MAX_SOURCES  4
+
+/**
+ * Arbitration mode, selected in menuconfig
+ */
+typedef enum {
+    SOURCE_ARBITER_MODE_NONE,       // Every source writes, as before
+    SOURCE_ARBITER_MODE_FIRST_COME, // First source holds the lock until it goes quiet or releases it
+    SOURCE_ARBITER_MODE_PRIORITY    // As first-come, but a higher priority source takes over at once
+} source_arbiter_mode_t;
+
+/**
+ * Per-source view, for statistics
+ */
+typedef struct {
+    struct sockaddr_in address;
+    uint8_t priority;           // Claimed priority, or the configured default
+    bool owner;                 // Source currently holds the lock
+    uint32_t accepted_packets;  // LED data packets let through
+    uint32_t rejected_packets;  // LED data packets dropped for lack of the lock
+    uint32_t idle_ms;           // Time since the last packet
+} source_arbiter_source_t;
+
+/**
+ * Source arbiter statistics
+ */
+typedef struct {
+    uint32_t rejected_packets;  // LED data packets from sources not holding the lock
+    uint32_t takeovers;         // Lock moved from one live source to another
+    uint32_t lock_timeouts;     // Lock dropped because its owner went quiet
+} source_arbiter_stats_t;
+
+/**
+ * Initialize source arbiter
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t source_arbiter_init(void);
+
+/**
+ * Decide whether a source may write LED data
+ * Cheap enough to run on every packet before it is parsed. Must be called
+ * from a single task (the UDP server task).
+ * @param source Address the packet came from
+ * @return true if the packet should be applied, false to drop it
+ */
+bool source_arbiter_accept(const struct sockaddr_in* source);
+
+/**
+ * Handle a received source claim packet (0x0B)
+ * A claim sets the sender's priority and tries to take the lock; a release
+ * gives it up. Both are answered with a status packet.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param source Address the packet came from
+ * @return true if packet was a valid claim packet, false otherwise
+ */
+bool source_arbiter_handle_packet(const uint8_t* data, size_t len, const struct sockaddr_in* source);
+
+/**
+ * Get the source holding the lock
+ * An owner quiet for longer than SOURCE_LOCK_TIMEOUT_MS loses the lock
+ * here. Safe to call from any task.
+ * @param owner Pointer to store the owner's address, may be NULL
+ * @return true if a source holds the lock, false otherwise
+ */
+bool source_arbiter_get_owner(struct sockaddr_in* owner);
+
+/**
+ * Get known sources with their counters
+ * @param sources Array to store sources
+ * @param max_sources Capacity of sources array
+ * @param count Pointer to store number of sources
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t source_arbiter_get_sources(source_arbiter_source_t* sources, size_t max_sources,
+                                     size_t* count);
+
+/**
+ * Get source arbiter statistics
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t source_arbiter_get_stats(source_arbiter_stats_t* stats);
+
+/**
+ * Reset source arbiter statistics, known sources and the lock
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t source_arbiter_reset(void);
+
+#endif // SOURCE_ARBITER_H
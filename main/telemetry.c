@@ -0,0 +1,254 @@
+#include "telemetry.h"
+#include "config.h"
+#include "udp_server.h"
+#include "led_driver.h"
+#include "jitter_buffer.h"
+#include "frame_assembler.h"
+#include "clock_sync.h"
+#include "wifi_manager.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "TELEMETRY";
+
+#define TELEMETRY_MIN_INTERVAL_MS   100
+#define TELEMETRY_MAX_INTERVAL_MS   60000
+// A subscription lapses unless renewed, so a vanished host is not
+// reported to forever
+#define TELEMETRY_LEASE_MS          60000
+
+#define TELEMETRY_FLAG_CLOCK_SYNCED 0x01
+
+// Global variables
+static bool g_initialized = false;
+static esp_timer_handle_t g_report_timer = NULL;
+static struct sockaddr_in g_subscriber;
+static bool g_subscribed = false;
+static int64_t g_lease_expiry_us = 0;
+// The subscription and g_last are used by the esp_timer task and the UDP
+// server task alike
+static SemaphoreHandle_t g_mutex = NULL;
+
+// Counters at the previous report, to send per-interval deltas
+static struct {
+    int64_t time_us;
+    uint32_t packets;
+    uint32_t frames_displayed;
+    uint32_t frames_skipped;
+    uint32_t frames_dropped;
+    uint32_t encode_count;
+    uint64_t encode_time_total_us;
+    uint32_t latency_histogram[LED_LATENCY_HISTOGRAM_BUCKETS];
+} g_last = {0};
+
+static void put_be(uint8_t* out, uint32_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+static uint32_t clamp_u16(uint64_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : (uint32_t)value;
+}
+
+/**
+ * Collect counters and send one report
+ * Layout (big-endian), TELEMETRY_REPORT_SIZE bytes:
+ *   0 type, 1 kind, 2 layout version, 3 flags
+ *   4 uptime ms (u32), 8 interval ms (u16), 10 packets/s (u16)
+ *   12 packets, 16 frames displayed, 20 frames skipped, 24 frames dropped (u32 deltas)
+ *   28 encode avg us, 30 encode max us, 32 wire time us (u16)
+ *   34 receive-to-wire latency histogram, 8 x u32 deltas
+ *   66 minimum free heap (u32), 70 RSSI dBm (i8), 71 reserved
+ */
+static void send_report(int64_t now_us)
+{
+    udp_server_stats_t udp_stats = {0};
+    led_pipeline_stats_t pipeline = {0};
+    udp_server_get_stats(&udp_stats);
+    led_driver_get_pipeline_stats(&pipeline);
+    uint32_t frames_dropped = telemetry_get_dropped_frames();
+
+    int64_t elapsed_us = now_us - g_last.time_us;
+    uint32_t packets = udp_stats.packets_received - g_last.packets;
+    uint32_t encodes = pipeline.encode_count - g_last.encode_count;
+    uint64_t encode_total = pipeline.encode_time_total_us - g_last.encode_time_total_us;
+
+    uint8_t report[TELEMETRY_REPORT_SIZE] = {0};
+    report[0] = PACKET_TYPE_TELEMETRY;
+    report[1] = TELEMETRY_KIND_REPORT;
+    report[2] = TELEMETRY_LAYOUT_VERSION;
+    report[3] = clock_sync_is_synced() ? TELEMETRY_FLAG_CLOCK_SYNCED : 0;
+    put_be(&report[4], (uint32_t)(now_us / 1000), 4);
+    put_be(&report[8], clamp_u16(elapsed_us / 1000), 2);
+    put_be(&report[10], elapsed_us > 0 ? clamp_u16((uint64_t)packets * 1000000 / elapsed_us) : 0, 2);
+    put_be(&report[12], packets, 4);
+    put_be(&report[16], pipeline.frames_displayed - g_last.frames_displayed, 4);
+    put_be(&report[20], pipeline.frames_skipped - g_last.frames_skipped, 4);
+    put_be(&report[24], frames_dropped - g_last.frames_dropped, 4);
+    put_be(&report[28], encodes ? clamp_u16(encode_total / encodes) : 0, 2);
+    put_be(&report[30], clamp_u16(pipeline.encode_time_max_us), 2);
+    put_be(&report[32], clamp_u16(pipeline.last_wire_time_us), 2);
+    for (int i = 0; i < LED_LATENCY_HISTOGRAM_BUCKETS; i++) {
+        put_be(&report[34 + i * 4],
+               pipeline.latency_histogram[i] - g_last.latency_histogram[i], 4);
+    }
+    put_be(&report[66], esp_get_minimum_free_heap_size(), 4);
+    report[70] = (uint8_t)wifi_manager_get_rssi();
+
+    udp_server_send_to(&g_subscriber, report, sizeof(report));
+
+    g_last.time_us = now_us;
+    g_last.packets = udp_stats.packets_received;
+    g_last.frames_displayed = pipeline.frames_displayed;
+    g_last.frames_skipped = pipeline.frames_skipped;
+    g_last.frames_dropped = frames_dropped;
+    g_last.encode_count = pipeline.encode_count;
+    g_last.encode_time_total_us = pipeline.encode_time_total_us;
+    memcpy(g_last.latency_histogram, pipeline.latency_histogram, sizeof(g_last.latency_histogram));
+}
+
+/**
+ * Report timer callback (esp_timer task)
+ */
+static void report_timer_callback(void* arg)
+{
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+    int64_t now_us = esp_timer_get_time();
+
+    if (!g_subscribed) {
+        // Unsubscribed while this shot was already due
+    } else if (now_us > g_lease_expiry_us) {
+        ESP_LOGI(TAG, "Telemetry subscription expired");
+        esp_timer_stop(g_report_timer);
+        g_subscribed = false;
+    } else {
+        send_report(now_us);
+    }
+    xSemaphoreGive(g_mutex);
+}
+
+esp_err_t telemetry_init(void)
+{
+    if (g_initialized) {
+        ESP_LOGW(TAG, "Telemetry already initialized");
+        return ESP_OK;
+    }
+
+    g_mutex = xSemaphoreCreateMutex();
+    if (!g_mutex) {
+        ESP_LOGE(TAG, "Failed to create telemetry mutex");
+        return ESP_ERR_NO_MEM;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = report_timer_callback,
+        .name = "telemetry",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &g_report_timer);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create telemetry timer: %s", esp_err_to_name(ret));
+        vSemaphoreDelete(g_mutex);
+        g_mutex = NULL;
+        return ret;
+    }
+
+    g_initialized = true;
+    ESP_LOGI(TAG, "Telemetry initialized");
+    return ESP_OK;
+}
+
+bool telemetry_handle_packet(const uint8_t* data, size_t len, const struct sockaddr_in* source)
+{
+    if (!g_initialized || !data || !source || len != TELEMETRY_SUBSCRIBE_SIZE ||
+        data[0] != PACKET_TYPE_TELEMETRY || data[1] != TELEMETRY_KIND_SUBSCRIBE) {
+        return false;
+    }
+
+    uint32_t interval_ms = (data[2] << 8) | data[3];
+
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+    esp_timer_stop(g_report_timer);
+
+    if (interval_ms == 0) {
+        ESP_LOGI(TAG, "Telemetry unsubscribed");
+        g_subscribed = false;
+        xSemaphoreGive(g_mutex);
+        return true;
+    }
+
+    if (interval_ms < TELEMETRY_MIN_INTERVAL_MS) {
+        interval_ms = TELEMETRY_MIN_INTERVAL_MS;
+    } else if (interval_ms > TELEMETRY_MAX_INTERVAL_MS) {
+        interval_ms = TELEMETRY_MAX_INTERVAL_MS;
+    }
+
+    bool renewal = g_subscribed && g_subscriber.sin_addr.s_addr == source->sin_addr.s_addr &&
+                   g_subscriber.sin_port == source->sin_port;
+    if (!renewal) {
+        ESP_LOGI(TAG, "Telemetry every %" PRIu32 " ms to %d.%d.%d.%d:%d", interval_ms,
+                 (int)((source->sin_addr.s_addr >> 0) & 0xFF),
+                 (int)((source->sin_addr.s_addr >> 8) & 0xFF),
+                 (int)((source->sin_addr.s_addr >> 16) & 0xFF),
+                 (int)((source->sin_addr.s_addr >> 24) & 0xFF),
+                 ntohs(source->sin_port));
+        // First report of a new subscriber covers the time since boot
+        g_subscriber = *source;
+        memset(&g_last, 0, sizeof(g_last));
+        send_report(esp_timer_get_time());
+    }
+
+    g_subscribed = true;
+    g_lease_expiry_us = esp_timer_get_time() + (int64_t)TELEMETRY_LEASE_MS * 1000;
+    esp_timer_start_periodic(g_report_timer, (uint64_t)interval_ms * 1000);
+    xSemaphoreGive(g_mutex);
+    return true;
+}
+
+uint32_t telemetry_get_dropped_frames(void)
+{
+    jitter_buffer_stats_t jitter_stats = {0};
+    frame_assembler_stats_t assembler_stats = {0};
+    jitter_buffer_get_stats(&jitter_stats);
+    frame_assembler_get_stats(&assembler_stats);
+
+    return jitter_stats.late_drops + jitter_stats.overflow_drops + assembler_stats.frames_dropped;
+}
+
+bool telemetry_is_active(void)
+{
+    return g_subscribed;
+}
+
+esp_err_t telemetry_deinit(void)
+{
+    if (!g_initialized) {
+        ESP_LOGW(TAG, "Telemetry not initialized");
+        return ESP_OK;
+    }
+
+    if (g_report_timer) {
+        esp_timer_stop(g_report_timer);
+        esp_timer_delete(g_report_timer);
+        g_report_timer = NULL;
+    }
+
+    if (g_mutex) {
+        vSemaphoreDelete(g_mutex);
+        g_mutex = NULL;
+    }
+
+    g_subscribed = false;
+    g_initialized = false;
+
+    ESP_LOGI(TAG, "Telemetry deinitialized");
+    return ESP_OK;
+}
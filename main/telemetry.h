@@ -0,0 +1,49 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "esp_err.h"
+#include "lwip/sockets.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Initialize telemetry
+ * Nothing is sent until a host subscribes.
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t telemetry_init(void);
+
+/**
+ * Handle a received telemetry packet (0x0A)
+ * A subscribe packet with a non-zero interval (re)starts reports to its
+ * sender; interval 0 unsubscribes.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param source Address the packet came from
+ * @return true if packet was a valid telemetry packet, false otherwise
+ */
+bool telemetry_handle_packet(const uint8_t* data, size_t len, const struct sockaddr_in* source);
+
+/**
+ * Count frames received but never shown, since boot
+ * Frames only: those the jitter buffer dropped late or on overflow, and
+ * reliable frames dropped at their deadline or superseded. Used by the
+ * telemetry report and backpressure alike.
+ * @return Dropped frame count
+ */
+uint32_t telemetry_get_dropped_frames(void);
+
+/**
+ * Check if a host is subscribed
+ * @return true if reports are being sent, false otherwise
+ */
+bool telemetry_is_active(void);
+
+/**
+ * Deinitialize telemetry
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t telemetry_deinit(void);
+
+#endif // TELEMETRY_H
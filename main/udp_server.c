@@ -2,26 +2,55 @@
 #include "config.h"
 #include "state_machine.h"
 #include "led_driver.h"
+#include "clock_sync.h"
+#include "sequence_tracker.h"
+#include "telemetry.h"
+#include "source_arbiter.h"
+#include "fec_decoder.h"
+#include "frame_assembler.h"
+#include "capabilities.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
+#include "lwip/api.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <stdlib.h>
 #include <string.h>
-#include <errno.h>
 #include <inttypes.h>
 
 static const char *TAG = "UDP_SERVER";
 
+#define STREAM_IDLE_MS          2000    // A sender quiet this long is no longer streaming
+#define STOP_TIMEOUT_MS         500     // Longest wait for the task to leave its loop
+
 // Global variables
-static int g_socket_fd = -1;
+static struct netconn* g_conn = NULL;
+static uint8_t* g_chain_buffer = NULL;  // Datagrams spread over several pbufs are copied here
 static bool g_server_running = false;
 static uint16_t g_server_port = 0;
 static TaskHandle_t g_server_task_handle = NULL;
+static TaskHandle_t g_stop_waiter = NULL;     // Notified by the task once it has left its loop
+
+// Shared frame: LED data offsets are positions in a frame spanning several
+// boards, of which this board shows [g_slice_base, + LED buffer size)
+static bool g_shared_frame = false;
+static uint32_t g_slice_base = 0;
+static struct in_addr g_multicast_group = {0};
+
+// Last sender of accepted LED data, read from the backpressure and mDNS timers
+static struct sockaddr_in g_stream_source;
+static TickType_t g_stream_time = 0;
+static bool g_stream_seen = false;
+static portMUX_TYPE g_stream_lock = portMUX_INITIALIZER_UNLOCKED;
 
 // Callbacks
 static udp_packet_cb_t g_packet_callback = NULL;
 static led_data_cb_t g_led_callback = NULL;
+static led_packed_data_cb_t g_packed_led_callback = NULL;
+static led_scatter_cb_t g_scatter_callback = NULL;
+static led_timed_data_cb_t g_timed_led_callback = NULL;
 
 // Statistics
 static struct {
@@ -30,133 +59,484 @@ static struct {
     uint32_t led_packets;
     uint32_t ping_packets;
     uint32_t invalid_packets;
+    uint32_t outside_slice_packets;
+    uint32_t chained_packets;
+    uint32_t handle_count;
+    uint64_t handle_time_total_us;
+    uint32_t handle_time_max_us;
     TickType_t last_led_data_time;  // Last time LED data was received
 } g_stats = {0};
 
+static void put_be(uint8_t* out, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; i--) {
+        out[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
 /**
- * UDP server task
+ * Cut LED data down to this board's slice of a shared frame
+ * @return false if none of the data belongs to this board
  */
-static void udp_server_task(void *pvParameters)
+static bool select_slice(uint32_t* offset, uint8_t** data, size_t* len)
 {
-    uint8_t rx_buffer[MAX_PACKET_SIZE];
-    struct sockaddr_in source_addr;
-    socklen_t socklen = sizeof(source_addr);
-    
-    ESP_LOGI(TAG, "UDP server task started on port %d", g_server_port);
-    
-    while (g_server_running) {
-        // Receive data
-        int len = recvfrom(g_socket_fd, rx_buffer, sizeof(rx_buffer) - 1, 0,
-                          (struct sockaddr *)&source_addr, &socklen);
-        
-        if (len < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // Timeout, continue
-                vTaskDelay(pdMS_TO_TICKS(10));
-                continue;
-            } else {
-                ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
+    if (!g_shared_frame) {
+        return true;
+    }
+
+    uint64_t start = *offset;
+    uint64_t end = start + *len;
+    uint64_t slice_end = (uint64_t)g_slice_base + led_driver_get_buffer_size();
+
+    if (end <= g_slice_base || start >= slice_end) {
+        return false;
+    }
+
+    if (start < g_slice_base) {
+        *data += g_slice_base - start;
+        start = g_slice_base;
+    }
+    if (end > slice_end) {
+        end = slice_end;
+    }
+
+    *offset = start - g_slice_base;
+    *len = end - start;
+    return true;
+}
+
+static bool is_led_data_type(uint8_t packet_type)
+{
+    switch (packet_type) {
+        case PACKET_TYPE_LED_DATA:
+        case PACKET_TYPE_LED_RGB565:
+        case PACKET_TYPE_LED_RGB444:
+        case PACKET_TYPE_LED_SCATTER:
+        case PACKET_TYPE_LED_DATA_EXT:
+        case PACKET_TYPE_FEC_PARITY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Answer a ping
+ * A 1-byte ping gets the legacy 1-byte pong. An extended ping gets its
+ * host timestamp echoed with board receive/transmit times and the last
+ * frame's receive-to-wire latency, so the host can separate network RTT
+ * from board processing time.
+ */
+static int send_ping_response(const uint8_t* data, size_t len,
+                              const struct sockaddr_in* dest, int64_t rx_time_us)
+{
+    uint8_t response[PING_EXT_RESPONSE_SIZE];
+    size_t response_len = 1;
+    response[0] = PACKET_TYPE_PING;
+
+    if (len >= PING_EXT_REQUEST_SIZE && data[1] == PING_EXT_VERSION) {
+        response[1] = PING_EXT_VERSION;
+        memcpy(&response[2], &data[2], 8);  // Host timestamp, echoed untouched
+        put_be(&response[10], (uint64_t)rx_time_us, 8);
+        put_be(&response[26], led_driver_get_last_frame_latency_us(), 4);
+        // Last so it covers everything above
+        put_be(&response[18], (uint64_t)esp_timer_get_time(), 8);
+        response_len = PING_EXT_RESPONSE_SIZE;
+    }
+
+    if (udp_server_send_to(dest, response, response_len) != ESP_OK) {
+        return -1;
+    }
+    return response_len;
+}
+
+/**
+ * Apply a 0x02 or 0x08 LED data packet
+ * Packets rebuilt from FEC parity come back through here with rebuilt set.
+ */
+static void handle_led_data_packet(const uint8_t* data, int len,
+                                   const struct sockaddr_in* source_addr, int64_t rx_time_us,
+                                   bool rebuilt)
+{
+    uint8_t packet_type = data[0];
+
+    // Parse LED data packet (legacy 16-bit or extended 32-bit offset)
+    led_data_ext_header_t header = {0};
+    uint8_t* led_data;
+    size_t led_len;
+    bool valid;
+
+    if (packet_type == PACKET_TYPE_LED_DATA) {
+        uint16_t legacy_offset;
+        valid = udp_server_parse_led_packet(data, len, &legacy_offset,
+                                            &led_data, &led_len);
+        header.byte_offset = legacy_offset;
+    } else {
+        valid = udp_server_parse_led_packet_ext(data, len, &header,
+                                                &led_data, &led_len);
+    }
+
+    if (valid && (header.flags & LED_DATA_EXT_FLAG_FEC) && !rebuilt) {
+        const uint8_t* recovered;
+        size_t recovered_len;
+        fec_decoder_add_packet(source_addr, header.frame_id, header.fec_group, header.fec_index,
+                               header.fec_size, data, len, &recovered, &recovered_len);
+        // The missing packet comes earlier in the frame; apply it first,
+        // since this one may be the PUSH that completes the frame
+        if (recovered) {
+            handle_led_data_packet(recovered, recovered_len, source_addr, rx_time_us, true);
+        }
+    }
+
+    if (valid && (header.flags & LED_DATA_EXT_FLAG_SEQUENCE)) {
+        sequence_result_t verdict = sequence_tracker_check(
+            source_addr, header.sequence, header.frame_id,
+            (header.flags & LED_DATA_EXT_FLAG_PUSH) != 0);
+        if (verdict != SEQUENCE_ACCEPT) {
+            ESP_LOGD(TAG, "Dropping %s packet: seq=%u, frame=%u",
+                     verdict == SEQUENCE_DUPLICATE ? "duplicate" : "stale",
+                     header.sequence, header.frame_id);
+            return;
+        }
+    }
+
+    if (!valid) {
+        ESP_LOGW(TAG, "Invalid LED data packet: type=0x%02X, %d bytes", packet_type, len);
+        g_stats.invalid_packets++;
+        return;
+    }
+
+    bool push = (header.flags & LED_DATA_EXT_FLAG_PUSH) != 0;
+    bool in_slice = select_slice(&header.byte_offset, &led_data, &led_len);
+    if (!in_slice) {
+        g_stats.outside_slice_packets++;
+        led_len = 0;
+    } else {
+        ESP_LOGD(TAG, "Received LED data: offset=%" PRIu32 ", len=%" PRIu32,
+                 header.byte_offset, (uint32_t)led_len);
+        g_stats.led_packets++;
+
+        // Update last LED data received time for timeout detection
+        g_stats.last_led_data_time = xTaskGetTickCount();
+    }
+
+    if (header.flags & LED_DATA_EXT_FLAG_FRAGMENT) {
+        // Held back until the whole frame is there; see deliver_reliable_frame()
+        frame_assembler_add(source_addr, &header, in_slice ? header.byte_offset : 0,
+                            led_data, led_len, rx_time_us);
+    } else if (!in_slice) {
+        // The frame still ends here for this board
+        if ((header.flags & LED_DATA_EXT_FLAG_TIMESTAMP) && push && g_timed_led_callback) {
+            g_timed_led_callback(header.pts_us, 0, led_data, 0, true);
+        }
+        return;
+    } else if (header.flags & LED_DATA_EXT_FLAG_TIMESTAMP) {
+        if (g_timed_led_callback) {
+            g_timed_led_callback(header.pts_us, header.byte_offset, led_data, led_len, push);
+        }
+    } else if (g_led_callback) {
+        // Stamp and transmit under one lock hold, so another receiver's
+        // transmit cannot take this stamp
+        led_driver_lock();
+        led_driver_mark_frame_received(rx_time_us);
+        g_led_callback(header.byte_offset, led_data, led_len);
+        led_driver_unlock();
+    }
+
+    if (g_packet_callback && in_slice) {
+        g_packet_callback((udp_packet_type_t)packet_type, data, len);
+    }
+}
+
+/**
+ * Hand a complete reliable frame to the LED data callbacks
+ * Timestamped frames go to the jitter buffer fragment by fragment with
+ * PUSH on the last; others are applied as one scatter update, so a single
+ * transmit shows the whole frame.
+ */
+static void deliver_reliable_frame(bool timed, uint64_t pts_us, const led_data_run_t* runs,
+                                   size_t run_count, int64_t first_rx_us)
+{
+    if (timed) {
+        if (!g_timed_led_callback) {
+            return;
+        }
+        for (size_t i = 0; i < run_count; i++) {
+            g_timed_led_callback(pts_us, runs[i].offset, runs[i].data, runs[i].len,
+                                 i == run_count - 1);
+        }
+        if (run_count == 0) {
+            g_timed_led_callback(pts_us, 0, NULL, 0, true);
+        }
+    } else if (g_scatter_callback && run_count > 0) {
+        led_driver_lock();
+        led_driver_mark_frame_received(first_rx_us);
+        g_scatter_callback(runs, run_count);
+        led_driver_unlock();
+    }
+}
+
+/**
+ * Handle one received datagram
+ * data is the datagram itself, straight out of the receive pbuf; LED data
+ * is copied from it into the LED buffer once.
+ */
+static void handle_packet(uint8_t* data, int len, const struct sockaddr_in* source_addr,
+                          int64_t rx_time_us)
+{
+    // Update statistics
+    g_stats.packets_received++;
+    g_stats.bytes_received += len;
+
+    // Drop LED data from sources not holding the lock before any work
+    if (is_led_data_type(data[0])) {
+        if (!source_arbiter_accept(source_addr)) {
+            return;
+        }
+        TickType_t now = xTaskGetTickCount();
+        portENTER_CRITICAL(&g_stream_lock);
+        g_stream_source = *source_addr;
+        g_stream_time = now;
+        g_stream_seen = true;
+        portEXIT_CRITICAL(&g_stream_lock);
+    }
+
+    ESP_LOGD(TAG, "Received %d bytes from %d.%d.%d.%d:%d",
+             len,
+             (int)((source_addr->sin_addr.s_addr >> 0) & 0xFF),
+             (int)((source_addr->sin_addr.s_addr >> 8) & 0xFF),
+             (int)((source_addr->sin_addr.s_addr >> 16) & 0xFF),
+             (int)((source_addr->sin_addr.s_addr >> 24) & 0xFF),
+             ntohs(source_addr->sin_port));
+
+    // Process packet
+    if (len >= 1) {
+        uint8_t packet_type = data[0];
+
+        switch (packet_type) {
+            case PACKET_TYPE_PING:
+                ESP_LOGD(TAG, "Received ping packet");
+                g_stats.ping_packets++;
+                state_machine_handle_event(EVENT_PING_RECEIVED);
+
+                // Send ping response
+                int sent = send_ping_response(data, len, source_addr, rx_time_us);
+                if (sent < 0) {
+                    ESP_LOGW(TAG, "Failed to send ping response");
+                } else {
+                    ESP_LOGD(TAG, "Sent %d-byte ping response to %d.%d.%d.%d:%d", sent,
+                            (int)((source_addr->sin_addr.s_addr >> 0) & 0xFF),
+                            (int)((source_addr->sin_addr.s_addr >> 8) & 0xFF),
+                            (int)((source_addr->sin_addr.s_addr >> 16) & 0xFF),
+                            (int)((source_addr->sin_addr.s_addr >> 24) & 0xFF),
+                            ntohs(source_addr->sin_port));
+                }
+
+                if (g_packet_callback) {
+                    g_packet_callback(UDP_PACKET_PING, data, len);
+                }
+                break;
+
+            case PACKET_TYPE_LED_DATA:
+            case PACKET_TYPE_LED_DATA_EXT:
+                handle_led_data_packet(data, len, source_addr, rx_time_us, false);
+                break;
+
+            case PACKET_TYPE_FEC_PARITY: {
+                const uint8_t* recovered;
+                size_t recovered_len;
+
+                if (!fec_decoder_handle_parity(data, len, source_addr, &recovered,
+                                               &recovered_len)) {
+                    ESP_LOGW(TAG, "Invalid FEC parity packet");
+                    g_stats.invalid_packets++;
+                    break;
+                }
+                if (recovered) {
+                    handle_led_data_packet(recovered, recovered_len, source_addr, rx_time_us,
+                                           true);
+                }
+                if (g_packet_callback) {
+                    g_packet_callback(UDP_PACKET_FEC_PARITY, data, len);
+                }
                 break;
             }
-        } else if (len == 0) {
-            ESP_LOGW(TAG, "Received empty packet");
-            continue;
-        }
-        
-        // Update statistics
-        g_stats.packets_received++;
-        g_stats.bytes_received += len;
-        
-        ESP_LOGD(TAG, "Received %d bytes from %d.%d.%d.%d:%d",
-                 len,
-                 (int)((source_addr.sin_addr.s_addr >> 0) & 0xFF),
-                 (int)((source_addr.sin_addr.s_addr >> 8) & 0xFF),
-                 (int)((source_addr.sin_addr.s_addr >> 16) & 0xFF),
-                 (int)((source_addr.sin_addr.s_addr >> 24) & 0xFF),
-                 ntohs(source_addr.sin_port));
-        
-        // Process packet
-        if (len >= 1) {
-            uint8_t packet_type = rx_buffer[0];
-            
-            switch (packet_type) {
-                case PACKET_TYPE_PING:
-                    ESP_LOGD(TAG, "Received ping packet");
-                    g_stats.ping_packets++;
-                    state_machine_handle_event(EVENT_PING_RECEIVED);
-
-                    // Send ping response
-                    uint8_t ping_response = PACKET_TYPE_PING;
-                    int sent = sendto(g_socket_fd, &ping_response, 1, 0,
-                                    (struct sockaddr *)&source_addr, sizeof(source_addr));
-                    if (sent < 0) {
-                        ESP_LOGW(TAG, "Failed to send ping response: errno %d", errno);
-                    } else {
-                        ESP_LOGD(TAG, "Sent ping response to %d.%d.%d.%d:%d",
-                                (int)((source_addr.sin_addr.s_addr >> 0) & 0xFF),
-                                (int)((source_addr.sin_addr.s_addr >> 8) & 0xFF),
-                                (int)((source_addr.sin_addr.s_addr >> 16) & 0xFF),
-                                (int)((source_addr.sin_addr.s_addr >> 24) & 0xFF),
-                                ntohs(source_addr.sin_port));
+
+            case PACKET_TYPE_LED_RGB565:
+            case PACKET_TYPE_LED_RGB444: {
+                uint16_t led_offset;
+                led_pixel_format_t format;
+                uint8_t* pixel_data;
+                size_t pixel_len;
+
+                if (udp_server_parse_packed_led_packet(data, len, &led_offset, &format,
+                                                       &pixel_data, &pixel_len)) {
+                    ESP_LOGD(TAG, "Received packed LED data: type=0x%02X, led_offset=%d, len=%" PRIu32,
+                             packet_type, led_offset, (uint32_t)pixel_len);
+                    g_stats.led_packets++;
+                    g_stats.last_led_data_time = xTaskGetTickCount();
+
+                    if (g_packed_led_callback) {
+                        led_driver_lock();
+                        led_driver_mark_frame_received(rx_time_us);
+                        g_packed_led_callback(led_offset, format, pixel_data, pixel_len);
+                        led_driver_unlock();
                     }
 
                     if (g_packet_callback) {
-                        g_packet_callback(UDP_PACKET_PING, rx_buffer, len);
+                        g_packet_callback((udp_packet_type_t)packet_type, data, len);
                     }
-                    break;
-                    
-                case PACKET_TYPE_LED_DATA:
-                    if (len >= LED_DATA_HEADER_SIZE) {
-                        // Parse LED data packet
-                        uint16_t offset;
-                        uint8_t* led_data;
-                        size_t led_len;
-
-                        if (udp_server_parse_led_packet(rx_buffer, len, &offset, &led_data, &led_len)) {
-                            ESP_LOGD(TAG, "Received LED data: offset=%d, len=%" PRIu32, offset, (uint32_t)led_len);
-                            g_stats.led_packets++;
-
-                            // Update last LED data received time for timeout detection
-                            g_stats.last_led_data_time = xTaskGetTickCount();
-
-                            if (g_led_callback) {
-                                g_led_callback(offset, led_data, led_len);
-                            }
-
-                            if (g_packet_callback) {
-                                g_packet_callback(UDP_PACKET_LED_DATA, rx_buffer, len);
-                            }
-                        } else {
-                            ESP_LOGW(TAG, "Invalid LED data packet");
-                            g_stats.invalid_packets++;
-                        }
-                    } else {
-                        ESP_LOGW(TAG, "LED data packet too short: %d bytes", len);
-                        g_stats.invalid_packets++;
+                } else {
+                    ESP_LOGW(TAG, "Invalid packed LED data packet");
+                    g_stats.invalid_packets++;
+                }
+                break;
+            }
+
+            case PACKET_TYPE_LED_SCATTER: {
+                led_data_run_t runs[LED_SCATTER_MAX_RUNS];
+                size_t run_count;
+
+                if (udp_server_parse_scatter_packet(data, len, runs, LED_SCATTER_MAX_RUNS,
+                                                    &run_count)) {
+                    ESP_LOGD(TAG, "Received scatter LED data: %" PRIu32 " runs", (uint32_t)run_count);
+                    g_stats.led_packets++;
+                    g_stats.last_led_data_time = xTaskGetTickCount();
+
+                    if (g_scatter_callback) {
+                        led_driver_lock();
+                        led_driver_mark_frame_received(rx_time_us);
+                        g_scatter_callback(runs, run_count);
+                        led_driver_unlock();
                     }
-                    break;
-                    
-                case PACKET_TYPE_IGNORE_1:
-                case PACKET_TYPE_IGNORE_2:
-                    ESP_LOGD(TAG, "Ignoring packet type 0x%02X", packet_type);
-                    break;
-                    
-                default:
-                    ESP_LOGW(TAG, "Unknown packet type: 0x%02X", packet_type);
+
+                    if (g_packet_callback) {
+                        g_packet_callback(UDP_PACKET_LED_SCATTER, data, len);
+                    }
+                } else {
+                    ESP_LOGW(TAG, "Invalid scatter LED data packet");
                     g_stats.invalid_packets++;
-                    break;
+                }
+                break;
+            }
+
+            case PACKET_TYPE_TIME_SYNC:
+                if (!clock_sync_handle_packet(data, len, source_addr, rx_time_us)) {
+                    ESP_LOGW(TAG, "Invalid time sync packet");
+                    g_stats.invalid_packets++;
+                } else if (g_packet_callback) {
+                    g_packet_callback(UDP_PACKET_TIME_SYNC, data, len);
+                }
+                break;
+
+            case PACKET_TYPE_TELEMETRY:
+                if (!telemetry_handle_packet(data, len, source_addr)) {
+                    ESP_LOGW(TAG, "Invalid telemetry packet");
+                    g_stats.invalid_packets++;
+                } else if (g_packet_callback) {
+                    g_packet_callback(UDP_PACKET_TELEMETRY, data, len);
+                }
+                break;
+
+            case PACKET_TYPE_SOURCE_CLAIM:
+                if (!source_arbiter_handle_packet(data, len, source_addr)) {
+                    ESP_LOGW(TAG, "Invalid source claim packet");
+                    g_stats.invalid_packets++;
+                } else if (g_packet_callback) {
+                    g_packet_callback(UDP_PACKET_SOURCE_CLAIM, data, len);
+                }
+                break;
+
+            case PACKET_TYPE_CAPABILITIES:
+                if (!capabilities_handle_packet(data, len, source_addr)) {
+                    ESP_LOGW(TAG, "Invalid capabilities packet");
+                    g_stats.invalid_packets++;
+                } else if (g_packet_callback) {
+                    g_packet_callback(UDP_PACKET_CAPABILITIES, data, len);
+                }
+                break;
+
+            case PACKET_TYPE_IGNORE_1:
+            case PACKET_TYPE_IGNORE_2:
+                ESP_LOGD(TAG, "Ignoring packet type 0x%02X", packet_type);
+                break;
+
+            default:
+                ESP_LOGW(TAG, "Unknown packet type: 0x%02X", packet_type);
+                g_stats.invalid_packets++;
+                break;
+        }
+    }
+}
+
+static void udp_server_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "UDP server task started on port %d", g_server_port);
+
+    while (g_server_running) {
+        // Blocks until a datagram arrives; udp_server_stop() sends one to wake it
+        struct netbuf* buf;
+        err_t err = netconn_recv(g_conn, &buf);
+        if (err != ERR_OK) {
+            ESP_LOGE(TAG, "netconn_recv failed: err %d", err);
+            break;
+        }
+
+        if (!g_server_running) {
+            netbuf_delete(buf);
+            break;
+        }
+
+        // Taken as early as possible; clock sync depends on it
+        int64_t rx_time_us = esp_timer_get_time();
+
+        struct sockaddr_in source_addr = {0};
+        const ip_addr_t* from = netbuf_fromaddr(buf);
+        source_addr.sin_family = AF_INET;
+        source_addr.sin_addr.s_addr = IP_IS_V4(from) ? ip4_addr_get_u32(ip_2_ip4(from)) : 0;
+        source_addr.sin_port = htons(netbuf_fromport(buf));
+
+        // A datagram normally arrives in one pbuf and is parsed in place.
+        // Only reassembled or chained ones are copied out, into a buffer
+        // allocated the first time one shows up.
+        uint8_t* data = buf->p->payload;
+        int len = buf->p->len;
+        if (buf->p->next) {
+            if (!g_chain_buffer) {
+                g_chain_buffer = malloc(MAX_PACKET_SIZE);
             }
+            len = g_chain_buffer ? netbuf_copy(buf, g_chain_buffer, MAX_PACKET_SIZE) : 0;
+            data = g_chain_buffer;
+            g_stats.chained_packets++;
+        }
+
+        if (len > 0) {
+            handle_packet(data, len, &source_addr, rx_time_us);
+        } else {
+            ESP_LOGW(TAG, "Received empty packet");
+        }
+        netbuf_delete(buf);
+
+        uint32_t handle_us = (uint32_t)(esp_timer_get_time() - rx_time_us);
+        g_stats.handle_count++;
+        g_stats.handle_time_total_us += handle_us;
+        if (handle_us > g_stats.handle_time_max_us) {
+            g_stats.handle_time_max_us = handle_us;
         }
     }
-    
+
     ESP_LOGI(TAG, "UDP server task ended");
     g_server_task_handle = NULL;
+    if (g_stop_waiter) {
+        xTaskNotifyGive(g_stop_waiter);
+    }
     vTaskDelete(NULL);
 }
 
 esp_err_t udp_server_init(uint16_t port)
 {
-    if (g_socket_fd >= 0) {
+    if (g_conn) {
         ESP_LOGW(TAG, "UDP server already initialized");
         return ESP_OK;
     }
@@ -164,31 +544,38 @@ esp_err_t udp_server_init(uint16_t port)
     ESP_LOGI(TAG, "Initializing UDP server on port %d", port);
     
     g_server_port = port;
+    sequence_tracker_init();
+    source_arbiter_init();
+    fec_decoder_init();
+    frame_assembler_init(deliver_reliable_frame);
+
+    g_slice_base = (uint32_t)CONFIG_UDP_SLICE_BASE_LED * strlen(CONFIG_LED_COLOR_ORDER_STRING);
+    g_multicast_group.s_addr = 0;
+    if (strlen(CONFIG_UDP_MULTICAST_GROUP) > 0 &&
+        (!inet_aton(CONFIG_UDP_MULTICAST_GROUP, &g_multicast_group) ||
+         !IN_MULTICAST(ntohl(g_multicast_group.s_addr)))) {
+        ESP_LOGE(TAG, "Invalid multicast group: %s", CONFIG_UDP_MULTICAST_GROUP);
+        g_multicast_group.s_addr = 0;
+    }
+    g_shared_frame = g_slice_base > 0 || g_multicast_group.s_addr != 0;
+    if (g_shared_frame) {
+        ESP_LOGI(TAG, "Shared frame slice starts at LED %d (byte %" PRIu32 ")",
+                 CONFIG_UDP_SLICE_BASE_LED, g_slice_base);
+    }
     
-    // Create socket
-    g_socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
-    if (g_socket_fd < 0) {
-        ESP_LOGE(TAG, "Unable to create socket: errno %d", errno);
+    // A netconn rather than a socket: received datagrams are handed over
+    // as pbufs and parsed where they are, instead of being copied out first
+    g_conn = netconn_new(NETCONN_UDP);
+    if (!g_conn) {
+        ESP_LOGE(TAG, "Unable to create netconn");
         return ESP_FAIL;
     }
-    
-    // Set socket timeout
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = UDP_RECEIVE_TIMEOUT_MS * 1000;
-    setsockopt(g_socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    
-    // Bind socket
-    struct sockaddr_in dest_addr;
-    dest_addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons(port);
-    
-    int err = bind(g_socket_fd, (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-    if (err < 0) {
-        ESP_LOGE(TAG, "Socket unable to bind: errno %d", errno);
-        close(g_socket_fd);
-        g_socket_fd = -1;
+
+    err_t err = netconn_bind(g_conn, IP_ADDR_ANY, port);
+    if (err != ERR_OK) {
+        ESP_LOGE(TAG, "Netconn unable to bind: err %d", err);
+        netconn_delete(g_conn);
+        g_conn = NULL;
         return ESP_FAIL;
     }
     
@@ -200,21 +587,35 @@ esp_err_t udp_server_start(void)
 {
     ESP_LOGI(TAG, "udp_server_start() called");
 
-    if (g_socket_fd < 0) {
-        ESP_LOGE(TAG, "UDP server not initialized - socket_fd: %d", g_socket_fd);
+    if (!g_conn) {
+        ESP_LOGE(TAG, "UDP server not initialized");
         return ESP_ERR_INVALID_STATE;
     }
 
     if (g_server_running) {
-        ESP_LOGW(TAG, "UDP server already running");
+        // Kept through a WiFi drop; the state machine still waits to hear it
+        ESP_LOGI(TAG, "UDP server already running");
+        state_machine_handle_event(EVENT_UDP_LISTENING);
         return ESP_OK;
     }
 
-    ESP_LOGI(TAG, "Starting UDP server on socket %d", g_socket_fd);
+    ESP_LOGI(TAG, "Starting UDP server on port %d", g_server_port);
+
+    // Joined here rather than at init, since it needs the interface up
+    if (g_multicast_group.s_addr != 0) {
+        ip_addr_t group;
+        ip_addr_set_ip4_u32(&group, g_multicast_group.s_addr);
+        err_t err = netconn_join_leave_group(g_conn, &group, IP_ADDR_ANY, NETCONN_JOIN);
+        if (err != ERR_OK) {
+            ESP_LOGE(TAG, "Failed to join multicast group %s: err %d",
+                     CONFIG_UDP_MULTICAST_GROUP, err);
+        } else {
+            ESP_LOGI(TAG, "Joined multicast group %s", CONFIG_UDP_MULTICAST_GROUP);
+        }
+    }
 
     g_server_running = true;
 
-    // Create server task with larger stack size to accommodate rx_buffer
     ESP_LOGI(TAG, "Creating UDP server task...");
     BaseType_t result = xTaskCreate(udp_server_task,
                                    "udp_server",
@@ -253,60 +654,179 @@ esp_err_t udp_server_stop(void)
     
     ESP_LOGI(TAG, "Stopping UDP server");
     
+    g_stop_waiter = xTaskGetCurrentTaskHandle();
     g_server_running = false;
+
+    if (g_multicast_group.s_addr != 0) {
+        ip_addr_t group;
+        ip_addr_set_ip4_u32(&group, g_multicast_group.s_addr);
+        netconn_join_leave_group(g_conn, &group, IP_ADDR_ANY, NETCONN_LEAVE);
+    }
     
-    // Wait for task to finish
+    // The task blocks in netconn_recv() without a timeout; a datagram to
+    // itself over loopback wakes it to see the flag. The byte is an ignored
+    // packet type, so it is harmless should it arrive after a restart.
     if (g_server_task_handle) {
-        // Give task time to finish gracefully
-        vTaskDelay(pdMS_TO_TICKS(100));
-        
-        if (g_server_task_handle) {
+        static const uint8_t wakeup = PACKET_TYPE_IGNORE_1;
+        struct sockaddr_in self = {
+            .sin_family = AF_INET,
+            .sin_port = htons(g_server_port),
+            .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+        };
+        udp_server_send_to(&self, &wakeup, sizeof(wakeup));
+
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STOP_TIMEOUT_MS)) == 0 && g_server_task_handle) {
+            ESP_LOGW(TAG, "UDP server task did not stop, deleting it");
             vTaskDelete(g_server_task_handle);
             g_server_task_handle = NULL;
         }
     }
+    g_stop_waiter = NULL;
     
     ESP_LOGI(TAG, "UDP server stopped");
     return ESP_OK;
 }
 
+esp_err_t udp_server_rejoin_multicast(void)
+{
+    if (!g_conn || !g_server_running || g_multicast_group.s_addr == 0) {
+        return ESP_OK;
+    }
+
+    ip_addr_t group;
+    ip_addr_set_ip4_u32(&group, g_multicast_group.s_addr);
+    netconn_join_leave_group(g_conn, &group, IP_ADDR_ANY, NETCONN_LEAVE);
+    err_t err = netconn_join_leave_group(g_conn, &group, IP_ADDR_ANY, NETCONN_JOIN);
+    if (err != ERR_OK) {
+        ESP_LOGE(TAG, "Failed to rejoin multicast group %s: err %d", CONFIG_UDP_MULTICAST_GROUP, err);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Rejoined multicast group %s", CONFIG_UDP_MULTICAST_GROUP);
+    return ESP_OK;
+}
+
 bool udp_server_is_running(void)
 {
     return g_server_running;
 }
 
+esp_err_t udp_server_send_to(const struct sockaddr_in* dest, const uint8_t* data, size_t len)
+{
+    if (!g_conn || !dest || !data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct netbuf* buf = netbuf_new();
+    if (!buf) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Referenced, not copied; netconn_sendto() returns once it is sent
+    ip_addr_t addr;
+    ip_addr_set_ip4_u32(&addr, dest->sin_addr.s_addr);
+    err_t err = netbuf_ref(buf, data, len);
+    if (err == ERR_OK) {
+        err = netconn_sendto(g_conn, buf, &addr, ntohs(dest->sin_port));
+    }
+    netbuf_delete(buf);
+
+    if (err != ERR_OK) {
+        ESP_LOGW(TAG, "netconn_sendto failed: err %d", err);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
+bool udp_server_get_stream_source(struct sockaddr_in* source)
+{
+    TickType_t now = xTaskGetTickCount();
+    struct sockaddr_in last;
+
+    portENTER_CRITICAL(&g_stream_lock);
+    bool streaming = g_stream_seen && now - g_stream_time <= pdMS_TO_TICKS(STREAM_IDLE_MS);
+    last = g_stream_source;
+    portEXIT_CRITICAL(&g_stream_lock);
+
+    // Holding the lock is not streaming; only recent LED data counts
+    if (!streaming) {
+        return false;
+    }
+
+    if (!source_arbiter_get_owner(source) && source) {
+        *source = last;
+    }
+    return true;
+}
+
+int udp_server_get_rx_queue_bytes(void)
+{
+#if LWIP_SO_RCVBUF
+    return g_conn ? g_conn->recv_avail : -1;
+#else
+    return -1;  // lwIP only counts queued bytes with LWIP_SO_RCVBUF
+#endif
+}
+
 esp_err_t udp_server_receive_packet(uint8_t* buffer, size_t buffer_size, 
                                    size_t* received_len, uint32_t timeout_ms)
 {
-    if (g_socket_fd < 0 || !buffer || !received_len) {
+    if (!g_conn || !buffer || !received_len) {
         return ESP_ERR_INVALID_ARG;
     }
+
+    // The server task blocks on the same netconn; both would race for
+    // datagrams and the receive timeout
+    if (g_server_running) {
+        ESP_LOGW(TAG, "Cannot receive directly while the server task is running");
+        return ESP_ERR_INVALID_STATE;
+    }
     
-    struct sockaddr_in source_addr;
-    socklen_t socklen = sizeof(source_addr);
-    
-    // Set socket timeout
-    struct timeval timeout;
-    timeout.tv_sec = timeout_ms / 1000;
-    timeout.tv_usec = (timeout_ms % 1000) * 1000;
-    setsockopt(g_socket_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    
-    int len = recvfrom(g_socket_fd, buffer, buffer_size, 0,
-                      (struct sockaddr *)&source_addr, &socklen);
+    struct netbuf* buf;
+    netconn_set_recvtimeout(g_conn, timeout_ms);
+    err_t err = netconn_recv(g_conn, &buf);
+    netconn_set_recvtimeout(g_conn, 0);     // Back to blocking for the server task
     
-    if (len < 0) {
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            return ESP_ERR_TIMEOUT;
-        } else {
-            ESP_LOGE(TAG, "recvfrom failed: errno %d", errno);
-            return ESP_FAIL;
-        }
+    if (err == ERR_TIMEOUT) {
+        return ESP_ERR_TIMEOUT;
+    } else if (err != ERR_OK) {
+        ESP_LOGE(TAG, "netconn_recv failed: err %d", err);
+        return ESP_FAIL;
     }
     
-    *received_len = len;
+    *received_len = netbuf_copy(buf, buffer, buffer_size);
+    netbuf_delete(buf);
     return ESP_OK;
 }
 
+/**
+ * Check that [offset, offset + len) lies inside the LED buffer
+ */
+static bool validate_led_data_range(uint32_t offset, size_t len)
+{
+    // Shared frames span several boards; select_slice() clips instead
+    if (g_shared_frame) {
+        return true;
+    }
+
+    // Get actual LED channels from configuration
+    size_t led_channels = strlen(CONFIG_LED_COLOR_ORDER_STRING);
+
+    // offset is byte offset, len is data length in bytes; compare without
+    // adding so neither side can wrap
+    size_t max_buffer_size = (size_t)MAX_LED_COUNT * led_channels;
+    if (offset > max_buffer_size || len > max_buffer_size - offset) {
+        ESP_LOGW(TAG,
+                 "LED data exceeds buffer: byte_offset=%" PRIu32 ", data_len=%" PRIu32
+                 ", max_buffer=%" PRIu32,
+                 offset, (uint32_t)len, (uint32_t)max_buffer_size);
+        return false;
+    }
+
+    return true;
+}
+
 bool udp_server_parse_led_packet(const uint8_t* data, size_t len,
                                 uint16_t* offset, uint8_t** led_data, size_t* led_len)
 {
@@ -326,24 +846,223 @@ bool udp_server_parse_led_packet(const uint8_t* data, size_t len,
     *led_data = (uint8_t*)(data + LED_DATA_HEADER_SIZE);
     *led_len = len - LED_DATA_HEADER_SIZE;
 
-    // Get actual LED channels from configuration
-    int led_channels = strlen(CONFIG_LED_COLOR_ORDER_STRING);
-
     // Note: We do NOT validate LED data length to be multiple of channels
     // This allows for UDP packet fragmentation and partial updates
     // The desktop application is responsible for sending correct data
 
-    // Validate offset and length don't exceed buffer size
-    // offset is byte offset, led_len is data length in bytes
-    uint16_t max_buffer_size = MAX_LED_COUNT * led_channels;
-    if (*offset + *led_len > max_buffer_size) {
-      ESP_LOGW(TAG,
-               "LED data exceeds buffer: byte_offset=%d, data_len=%" PRIu32
-               ", max_buffer=%d",
-               *offset, (uint32_t)*led_len, max_buffer_size);
-      return false;
+    return validate_led_data_range(*offset, *led_len);
+}
+
+bool udp_server_parse_led_packet_ext(const uint8_t* data, size_t len,
+                                     led_data_ext_header_t* header, uint8_t** led_data,
+                                     size_t* led_len)
+{
+    if (!data || len < LED_DATA_EXT_HEADER_SIZE || !header || !led_data || !led_len) {
+        return false;
+    }
+
+    if (data[0] != PACKET_TYPE_LED_DATA_EXT) {
+        return false;
+    }
+
+    if (data[1] != LED_DATA_EXT_VERSION) {
+        ESP_LOGW(TAG, "Unsupported LED data header version %d", data[1]);
+        return false;
+    }
+
+    // Unknown flags may change the header layout, so refuse to guess
+    uint8_t flags = data[2];
+    if (flags & ~LED_DATA_EXT_FLAGS_SUPPORTED) {
+        ESP_LOGW(TAG, "Unsupported LED data flags 0x%02X", flags);
+        return false;
     }
 
+    // Parse offset (big-endian, 32-bit)
+    uint32_t offset = ((uint32_t)data[3] << 24) | ((uint32_t)data[4] << 16) |
+                      ((uint32_t)data[5] << 8) | (uint32_t)data[6];
+
+    if (flags & LED_DATA_EXT_FLAG_LED_UNITS) {
+        uint32_t led_channels = strlen(CONFIG_LED_COLOR_ORDER_STRING);
+        if (offset > UINT32_MAX / led_channels) {
+            return false;
+        }
+        offset *= led_channels;
+    }
+
+    size_t header_len = LED_DATA_EXT_HEADER_SIZE;
+    uint64_t pts_us = 0;
+
+    if (flags & LED_DATA_EXT_FLAG_TIMESTAMP) {
+        if (len - header_len < LED_DATA_EXT_TIMESTAMP_SIZE) {
+            return false;
+        }
+        for (int i = 0; i < LED_DATA_EXT_TIMESTAMP_SIZE; i++) {
+            pts_us = (pts_us << 8) | data[header_len + i];
+        }
+        header_len += LED_DATA_EXT_TIMESTAMP_SIZE;
+    }
+
+    uint16_t sequence = 0;
+    uint16_t frame_id = 0;
+
+    if (flags & LED_DATA_EXT_FLAG_SEQUENCE) {
+        if (len - header_len < LED_DATA_EXT_SEQUENCE_SIZE) {
+            return false;
+        }
+        sequence = (data[header_len] << 8) | data[header_len + 1];
+        frame_id = (data[header_len + 2] << 8) | data[header_len + 3];
+        header_len += LED_DATA_EXT_SEQUENCE_SIZE;
+    }
+
+    uint8_t fec_group = 0;
+    uint8_t fec_index = 0;
+    uint8_t fec_size = 0;
+
+    if (flags & LED_DATA_EXT_FLAG_FEC) {
+        // Parity groups are identified by frame id
+        if (!(flags & LED_DATA_EXT_FLAG_SEQUENCE) || len - header_len < LED_DATA_EXT_FEC_SIZE) {
+            return false;
+        }
+        fec_group = data[header_len];
+        fec_index = data[header_len + 1];
+        fec_size = data[header_len + 2];
+        if (fec_size == 0 || fec_size > FEC_MAX_GROUP_SIZE || fec_index >= fec_size) {
+            return false;
+        }
+        header_len += LED_DATA_EXT_FEC_SIZE;
+    }
+
+    uint8_t frag_index = 0;
+    uint8_t frag_count = 0;
+
+    if (flags & LED_DATA_EXT_FLAG_FRAGMENT) {
+        // Reliable frames are identified by frame id
+        if (!(flags & LED_DATA_EXT_FLAG_SEQUENCE) || len - header_len < LED_DATA_EXT_FRAGMENT_SIZE) {
+            return false;
+        }
+        frag_index = data[header_len];
+        frag_count = data[header_len + 1];
+        if (frag_count == 0 || frag_count > FRAME_MAX_FRAGMENTS || frag_index >= frag_count) {
+            return false;
+        }
+        header_len += LED_DATA_EXT_FRAGMENT_SIZE;
+    }
+
+    header->flags = flags;
+    header->byte_offset = offset;
+    header->pts_us = pts_us;
+    header->sequence = sequence;
+    header->frame_id = frame_id;
+    header->fec_group = fec_group;
+    header->fec_index = fec_index;
+    header->fec_size = fec_size;
+    header->frag_index = frag_index;
+    header->frag_count = frag_count;
+    *led_data = (uint8_t*)(data + header_len);
+    *led_len = len - header_len;
+
+    return validate_led_data_range(header->byte_offset, *led_len);
+}
+
+bool udp_server_parse_packed_led_packet(const uint8_t* data, size_t len, uint16_t* led_offset,
+                                        led_pixel_format_t* format, uint8_t** pixel_data,
+                                        size_t* pixel_len)
+{
+    if (!data || len <= LED_PACKED_HEADER_SIZE || !led_offset || !format ||
+        !pixel_data || !pixel_len) {
+        return false;
+    }
+
+    switch (data[0]) {
+        case PACKET_TYPE_LED_RGB565:
+            *format = LED_PIXEL_FORMAT_RGB565;
+            break;
+        case PACKET_TYPE_LED_RGB444:
+            *format = LED_PIXEL_FORMAT_RGB444;
+            break;
+        default:
+            return false;
+    }
+
+    // Parse LED offset (big-endian, LED units)
+    *led_offset = (data[1] << 8) | data[2];
+
+    *pixel_data = (uint8_t*)(data + LED_PACKED_HEADER_SIZE);
+    *pixel_len = len - LED_PACKED_HEADER_SIZE;
+
+    // Unlike 0x02, pixels cannot be split across packets
+    size_t pixel_count = led_driver_packed_pixel_count(*format, *pixel_len);
+    if (pixel_count == 0) {
+        return false;
+    }
+
+    if ((size_t)*led_offset + pixel_count > MAX_LED_COUNT) {
+        ESP_LOGW(TAG, "Packed LED data exceeds buffer: led_offset=%d, pixels=%" PRIu32
+                 ", max_leds=%d", *led_offset, (uint32_t)pixel_count, MAX_LED_COUNT);
+        return false;
+    }
+
+    return true;
+}
+
+bool udp_server_parse_scatter_packet(const uint8_t* data, size_t len, led_data_run_t* runs,
+                                     size_t max_runs, size_t* run_count)
+{
+    if (!data || len < LED_SCATTER_HEADER_SIZE || !runs || !run_count) {
+        return false;
+    }
+
+    if (data[0] != PACKET_TYPE_LED_SCATTER) {
+        return false;
+    }
+
+    size_t count = data[1];
+    if (count == 0 || count > max_runs) {
+        ESP_LOGW(TAG, "Invalid scatter run count: %" PRIu32, (uint32_t)count);
+        return false;
+    }
+
+    size_t max_buffer_size = (size_t)MAX_LED_COUNT * strlen(CONFIG_LED_COLOR_ORDER_STRING);
+    size_t pos = LED_SCATTER_HEADER_SIZE;
+
+    for (size_t i = 0; i < count; i++) {
+        // All arithmetic below is on size_t with values bounded by len,
+        // so a hostile length field cannot wrap the cursor
+        if (len - pos < LED_SCATTER_RUN_HEADER_SIZE) {
+            ESP_LOGW(TAG, "Scatter run %" PRIu32 " header truncated", (uint32_t)i);
+            return false;
+        }
+
+        size_t offset = (data[pos] << 8) | data[pos + 1];
+        size_t run_len = (data[pos + 2] << 8) | data[pos + 3];
+        pos += LED_SCATTER_RUN_HEADER_SIZE;
+
+        if (run_len == 0 || run_len > len - pos) {
+            ESP_LOGW(TAG, "Scatter run %" PRIu32 " length %" PRIu32 " invalid",
+                     (uint32_t)i, (uint32_t)run_len);
+            return false;
+        }
+
+        if (offset + run_len > max_buffer_size) {
+            ESP_LOGW(TAG, "Scatter run exceeds buffer: byte_offset=%" PRIu32 ", len=%" PRIu32
+                     ", max_buffer=%" PRIu32, (uint32_t)offset, (uint32_t)run_len,
+                     (uint32_t)max_buffer_size);
+            return false;
+        }
+
+        runs[i].offset = (uint32_t)offset;
+        runs[i].data = data + pos;
+        runs[i].len = run_len;
+        pos += run_len;
+    }
+
+    // Trailing bytes mean the host and board disagree on the layout
+    if (pos != len) {
+        ESP_LOGW(TAG, "Scatter packet has %" PRIu32 " trailing bytes", (uint32_t)(len - pos));
+        return false;
+    }
+
+    *run_count = count;
     return true;
 }
 
@@ -359,13 +1078,63 @@ esp_err_t udp_server_register_led_callback(led_data_cb_t callback)
     return ESP_OK;
 }
 
-esp_err_t udp_server_get_stats(uint32_t* packets_received, uint32_t* bytes_received,
-                              uint32_t* led_packets, uint32_t* ping_packets)
+esp_err_t udp_server_register_packed_led_callback(led_packed_data_cb_t callback)
+{
+    g_packed_led_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t udp_server_register_scatter_callback(led_scatter_cb_t callback)
+{
+    g_scatter_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t udp_server_register_timed_led_callback(led_timed_data_cb_t callback)
+{
+    g_timed_led_callback = callback;
+    return ESP_OK;
+}
+
+esp_err_t udp_server_get_stats(udp_server_stats_t* stats)
 {
-    if (packets_received) *packets_received = g_stats.packets_received;
-    if (bytes_received) *bytes_received = g_stats.bytes_received;
-    if (led_packets) *led_packets = g_stats.led_packets;
-    if (ping_packets) *ping_packets = g_stats.ping_packets;
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sequence_tracker_stats_t seq_stats;
+    sequence_tracker_get_stats(&seq_stats);
+    source_arbiter_stats_t arbiter_stats;
+    source_arbiter_get_stats(&arbiter_stats);
+    fec_decoder_stats_t fec_stats;
+    fec_decoder_get_stats(&fec_stats);
+    frame_assembler_stats_t assembler_stats;
+    frame_assembler_get_stats(&assembler_stats);
+
+    stats->packets_received = g_stats.packets_received;
+    stats->bytes_received = g_stats.bytes_received;
+    stats->led_packets = g_stats.led_packets;
+    stats->ping_packets = g_stats.ping_packets;
+    stats->invalid_packets = g_stats.invalid_packets;
+    stats->outside_slice_packets = g_stats.outside_slice_packets;
+    stats->lost_packets = seq_stats.lost;
+    stats->reordered_packets = seq_stats.reordered;
+    stats->duplicate_packets = seq_stats.duplicates;
+    stats->stale_packets = seq_stats.stale;
+    stats->rejected_source_packets = arbiter_stats.rejected_packets;
+    stats->fec_recovered_packets = fec_stats.recovered_packets;
+    stats->fec_recovered_frames = fec_stats.frames_recovered;
+    stats->fec_unrecoverable_frames = fec_stats.frames_unrecoverable;
+    stats->reliable_frames = assembler_stats.frames_completed;
+    stats->reliable_recovered_frames = assembler_stats.frames_recovered;
+    stats->reliable_dropped_frames = assembler_stats.frames_dropped;
+    stats->nacks_sent = assembler_stats.nacks_sent;
+    stats->chained_packets = g_stats.chained_packets;
+    stats->handle_time_avg_us = g_stats.handle_count ?
+        (uint32_t)(g_stats.handle_time_total_us / g_stats.handle_count) : 0;
+    stats->handle_time_max_us = g_stats.handle_time_max_us;
+    stats->stack_free_min = g_server_task_handle ?
+        uxTaskGetStackHighWaterMark(g_server_task_handle) : 0;
 
     return ESP_OK;
 }
@@ -373,6 +1142,10 @@ esp_err_t udp_server_get_stats(uint32_t* packets_received, uint32_t* bytes_recei
 esp_err_t udp_server_reset_stats(void)
 {
     memset(&g_stats, 0, sizeof(g_stats));
+    sequence_tracker_reset();
+    source_arbiter_reset();
+    fec_decoder_reset();
+    frame_assembler_reset();
     ESP_LOGI(TAG, "UDP server statistics reset");
     return ESP_OK;
 }
@@ -386,16 +1159,22 @@ esp_err_t udp_server_deinit(void)
         udp_server_stop();
     }
 
-    // Close socket
-    if (g_socket_fd >= 0) {
-        close(g_socket_fd);
-        g_socket_fd = -1;
+    // Close netconn
+    if (g_conn) {
+        netconn_delete(g_conn);
+        g_conn = NULL;
     }
+    free(g_chain_buffer);
+    g_chain_buffer = NULL;
 
     // Reset variables
     g_server_port = 0;
     g_packet_callback = NULL;
     g_led_callback = NULL;
+    g_packed_led_callback = NULL;
+    g_scatter_callback = NULL;
+    g_timed_led_callback = NULL;
+    g_stream_seen = false;
     memset(&g_stats, 0, sizeof(g_stats));
 
     ESP_LOGI(TAG, "UDP server deinitialized");
@@ -3,6 +3,8 @@
 
 #include "esp_err.h"
 #include "config.h"
+#include "led_driver.h"
+#include "lwip/sockets.h"
 #include <stdint.h>
 #include <stddef.h>
 
@@ -13,19 +15,82 @@ typedef enum {
     UDP_PACKET_PING = PACKET_TYPE_PING,         // 0x01
     UDP_PACKET_LED_DATA = PACKET_TYPE_LED_DATA, // 0x02
     UDP_PACKET_IGNORE_1 = PACKET_TYPE_IGNORE_1, // 0x03
-    UDP_PACKET_IGNORE_2 = PACKET_TYPE_IGNORE_2  // 0x04
+    UDP_PACKET_IGNORE_2 = PACKET_TYPE_IGNORE_2, // 0x04
+    UDP_PACKET_LED_RGB565 = PACKET_TYPE_LED_RGB565, // 0x05
+    UDP_PACKET_LED_RGB444 = PACKET_TYPE_LED_RGB444, // 0x06
+    UDP_PACKET_LED_SCATTER = PACKET_TYPE_LED_SCATTER, // 0x07
+    UDP_PACKET_LED_DATA_EXT = PACKET_TYPE_LED_DATA_EXT, // 0x08
+    UDP_PACKET_TIME_SYNC = PACKET_TYPE_TIME_SYNC, // 0x09
+    UDP_PACKET_TELEMETRY = PACKET_TYPE_TELEMETRY, // 0x0A
+    UDP_PACKET_SOURCE_CLAIM = PACKET_TYPE_SOURCE_CLAIM, // 0x0B
+    UDP_PACKET_FEC_PARITY = PACKET_TYPE_FEC_PARITY, // 0x0C
+    UDP_PACKET_NACK = PACKET_TYPE_NACK, // 0x0D
+    UDP_PACKET_CAPABILITIES = PACKET_TYPE_CAPABILITIES // 0x0F
 } udp_packet_type_t;
 
 /**
  * LED data packet structure
  */
 typedef struct {
-    uint8_t type;           // Packet type (0x02)
-    uint16_t offset;        // LED offset (big-endian)
+    uint8_t type;           // Packet type (0x02 or 0x08)
+    uint32_t offset;        // Byte offset in LED buffer
     uint8_t* led_data;      // Pointer to LED data
     size_t led_data_len;    // Length of LED data
 } led_data_packet_t;
 
+/**
+ * One (offset, length, data) run of a scatter packet
+ */
+typedef struct {
+    uint32_t offset;        // Byte offset in LED buffer
+    const uint8_t* data;    // Pointer to LED data
+    size_t len;             // Length of LED data
+} led_data_run_t;
+
+/**
+ * Parsed extended LED data header (0x08)
+ */
+typedef struct {
+    uint8_t flags;          // LED_DATA_EXT_FLAG_* bits
+    uint32_t byte_offset;   // Byte offset in LED buffer (LED-unit offsets are converted)
+    uint64_t pts_us;        // Host presentation timestamp, valid with LED_DATA_EXT_FLAG_TIMESTAMP
+    uint16_t sequence;      // Packet sequence number, valid with LED_DATA_EXT_FLAG_SEQUENCE
+    uint16_t frame_id;      // Frame the packet belongs to, valid with LED_DATA_EXT_FLAG_SEQUENCE
+    uint8_t fec_group;      // Parity group within the frame, valid with LED_DATA_EXT_FLAG_FEC
+    uint8_t fec_index;      // Position in the parity group, valid with LED_DATA_EXT_FLAG_FEC
+    uint8_t fec_size;       // Data packets in the parity group, valid with LED_DATA_EXT_FLAG_FEC
+    uint8_t frag_index;     // Fragment of the frame, valid with LED_DATA_EXT_FLAG_FRAGMENT
+    uint8_t frag_count;     // Fragments in the frame, valid with LED_DATA_EXT_FLAG_FRAGMENT
+} led_data_ext_header_t;
+
+/**
+ * UDP server statistics
+ */
+typedef struct {
+    uint32_t packets_received;  // Total packets received
+    uint32_t bytes_received;    // Total bytes received
+    uint32_t led_packets;       // LED data packets applied
+    uint32_t ping_packets;      // Ping packets received
+    uint32_t invalid_packets;   // Malformed or unknown packets
+    uint32_t outside_slice_packets; // Shared-frame LED data meant for other boards
+    uint32_t lost_packets;      // Sequence numbers never received
+    uint32_t reordered_packets; // Sequenced packets that arrived late but were used
+    uint32_t duplicate_packets; // Sequenced packets received twice, dropped
+    uint32_t stale_packets;     // Sequenced packets of superseded frames, dropped
+    uint32_t rejected_source_packets; // LED data from sources not holding the lock
+    uint32_t fec_recovered_packets; // Lost packets rebuilt from FEC parity
+    uint32_t fec_recovered_frames; // Frames made whole by FEC
+    uint32_t fec_unrecoverable_frames; // FEC-protected frames still missing data
+    uint32_t reliable_frames;   // Reliable frames delivered whole
+    uint32_t reliable_recovered_frames; // Reliable frames completed after a NACK
+    uint32_t reliable_dropped_frames; // Reliable frames dropped at their deadline
+    uint32_t nacks_sent;        // NACK packets sent
+    uint32_t chained_packets;   // Datagrams spread over several pbufs, copied before parsing
+    uint32_t handle_time_avg_us; // Receive to pbuf release, per datagram
+    uint32_t handle_time_max_us;
+    uint32_t stack_free_min;    // Least free stack the server task has had (bytes)
+} udp_server_stats_t;
+
 /**
  * UDP packet callback function type
  */
@@ -33,8 +98,28 @@ typedef void (*udp_packet_cb_t)(udp_packet_type_t type, const uint8_t* data, siz
 
 /**
  * LED data callback function type
+ * offset is always a byte offset, whichever packet format carried it
+ */
+typedef void (*led_data_cb_t)(uint32_t offset, const uint8_t* data, size_t len);
+
+/**
+ * Packed (reduced bit-depth) LED data callback function type
+ */
+typedef void (*led_packed_data_cb_t)(uint16_t led_offset, led_pixel_format_t format,
+                                     const uint8_t* data, size_t len);
+
+/**
+ * Timestamped LED data callback function type
+ * push is true on the packet that completes the frame.
  */
-typedef void (*led_data_cb_t)(uint16_t offset, const uint8_t* data, size_t len);
+typedef void (*led_timed_data_cb_t)(uint64_t pts_us, uint32_t offset, const uint8_t* data,
+                                    size_t len, bool push);
+
+/**
+ * Scatter LED data callback function type
+ * Called once per packet with all runs; they form a single update.
+ */
+typedef void (*led_scatter_cb_t)(const led_data_run_t* runs, size_t run_count);
 
 /**
  * Initialize UDP server
@@ -55,19 +140,53 @@ esp_err_t udp_server_start(void);
  */
 esp_err_t udp_server_stop(void);
 
+/**
+ * Renew the multicast group membership after the IP address changed
+ * The netconn is bound to any address and needs no rebind.
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t udp_server_rejoin_multicast(void);
+
 /**
  * Check if UDP server is running
  * @return true if running, false otherwise
  */
 bool udp_server_is_running(void);
 
+/**
+ * Send a packet from the server socket
+ * @param dest Destination address
+ * @param data Packet data
+ * @param len Length of packet data
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t udp_server_send_to(const struct sockaddr_in* dest, const uint8_t* data, size_t len);
+
+/**
+ * Get the source currently streaming LED data
+ * Nothing streams once no LED data was let through for 2 seconds.
+ * Otherwise it is the source holding the lock when arbitration is enabled,
+ * and the last sender of LED data if not.
+ * @param source Pointer to store the source's address, may be NULL
+ * @return true if a source is streaming, false otherwise
+ */
+bool udp_server_get_stream_source(struct sockaddr_in* source);
+
+/**
+ * Get the number of bytes waiting in the server socket's receive queue
+ * @return Bytes queued, or -1 if the network stack cannot tell
+ */
+int udp_server_get_rx_queue_bytes(void);
+
 /**
  * Receive a UDP packet (blocking with timeout)
+ * Only while the server task is stopped; it owns the socket while it runs.
  * @param buffer Buffer to store received data
  * @param buffer_size Size of the buffer
  * @param received_len Pointer to store actual received length
  * @param timeout_ms Timeout in milliseconds
- * @return ESP_OK on success, ESP_ERR_TIMEOUT on timeout, other error codes on failure
+ * @return ESP_OK on success, ESP_ERR_TIMEOUT on timeout, ESP_ERR_INVALID_STATE
+ *         while the server task is running, other error codes on failure
  */
 esp_err_t udp_server_receive_packet(uint8_t* buffer, size_t buffer_size, 
                                    size_t* received_len, uint32_t timeout_ms);
@@ -84,6 +203,48 @@ esp_err_t udp_server_receive_packet(uint8_t* buffer, size_t buffer_size,
 bool udp_server_parse_led_packet(const uint8_t* data, size_t len, 
                                 uint16_t* offset, uint8_t** led_data, size_t* led_len);
 
+/**
+ * Parse extended LED data packet (0x08, 32-bit offset)
+ * Optional header fields follow the offset in ascending flag bit order.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param header Pointer to store parsed header
+ * @param led_data Pointer to store LED data pointer
+ * @param led_len Pointer to store LED data length
+ * @return true if packet is valid extended LED data packet, false otherwise
+ */
+bool udp_server_parse_led_packet_ext(const uint8_t* data, size_t len,
+                                     led_data_ext_header_t* header, uint8_t** led_data,
+                                     size_t* led_len);
+
+/**
+ * Parse packed (RGB565/RGB444) LED data packet
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param led_offset Pointer to store offset in LED units
+ * @param format Pointer to store pixel format
+ * @param pixel_data Pointer to store packed pixel data pointer
+ * @param pixel_len Pointer to store packed pixel data length
+ * @return true if packet is valid packed LED data packet, false otherwise
+ */
+bool udp_server_parse_packed_led_packet(const uint8_t* data, size_t len, uint16_t* led_offset,
+                                        led_pixel_format_t* format, uint8_t** pixel_data,
+                                        size_t* pixel_len);
+
+/**
+ * Parse and validate scatter LED data packet
+ * All runs are validated before any is returned, so a packet is either
+ * applied completely or rejected.
+ * @param data Raw packet data
+ * @param len Length of packet data
+ * @param runs Array to store parsed runs
+ * @param max_runs Capacity of runs array
+ * @param run_count Pointer to store number of runs
+ * @return true if packet is valid scatter packet, false otherwise
+ */
+bool udp_server_parse_scatter_packet(const uint8_t* data, size_t len, led_data_run_t* runs,
+                                     size_t max_runs, size_t* run_count);
+
 /**
  * Register packet callback
  * @param callback Callback function to register
@@ -98,16 +259,35 @@ esp_err_t udp_server_register_packet_callback(udp_packet_cb_t callback);
  */
 esp_err_t udp_server_register_led_callback(led_data_cb_t callback);
 
+/**
+ * Register packed LED data callback
+ * @param callback Callback function to register
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t udp_server_register_packed_led_callback(led_packed_data_cb_t callback);
+
+/**
+ * Register timestamped LED data callback
+ * Extended LED data packets carrying a presentation timestamp are routed
+ * here instead of to the LED data callback.
+ * @param callback Callback function to register
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t udp_server_register_timed_led_callback(led_timed_data_cb_t callback);
+
+/**
+ * Register scatter LED data callback
+ * @param callback Callback function to register
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t udp_server_register_scatter_callback(led_scatter_cb_t callback);
+
 /**
  * Get server statistics
- * @param packets_received Pointer to store total packets received
- * @param bytes_received Pointer to store total bytes received
- * @param led_packets Pointer to store LED packets received
- * @param ping_packets Pointer to store ping packets received
+ * @param stats Pointer to store statistics
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t udp_server_get_stats(uint32_t* packets_received, uint32_t* bytes_received,
-                              uint32_t* led_packets, uint32_t* ping_packets);
+esp_err_t udp_server_get_stats(udp_server_stats_t* stats);
 
 /**
  * Reset server statistics
@@ -0,0 +1,58 @@
+#include "universe_map.h"
+#include "esp_log.h"
+#include <string.h>
+#include <inttypes.h>
+
+static const char *TAG = "UNIVERSE_MAP";
+
+esp_err_t universe_map_build(universe_map_t* map, uint16_t first_universe, size_t buffer_size,
+                             uint8_t channels_per_led)
+{
+    if (!map || channels_per_led == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(map, 0, sizeof(*map));
+    map->first_universe = first_universe;
+    map->channels_per_universe = (DMX_UNIVERSE_SIZE / channels_per_led) * channels_per_led;
+
+    size_t needed = (buffer_size + map->channels_per_universe - 1) / map->channels_per_universe;
+    if (needed > UNIVERSE_MAP_MAX_UNIVERSES) {
+        ESP_LOGW(TAG, "LED buffer needs %" PRIu32 " universes, mapping the first %d",
+                 (uint32_t)needed, UNIVERSE_MAP_MAX_UNIVERSES);
+        needed = UNIVERSE_MAP_MAX_UNIVERSES;
+    }
+
+    uint32_t offset = 0;
+    for (size_t i = 0; i < needed; i++) {
+        size_t remaining = buffer_size - offset;
+        universe_map_entry_t* entry = &map->entries[i];
+        entry->universe = first_universe + i;
+        entry->byte_offset = offset;
+        entry->length = remaining < map->channels_per_universe ? remaining
+                                                               : map->channels_per_universe;
+        offset += entry->length;
+    }
+    map->count = needed;
+
+    ESP_LOGI(TAG, "Universes %d-%d, %d channels each",
+             first_universe, (int)(first_universe + needed - 1), map->channels_per_universe);
+    return ESP_OK;
+}
+
+const universe_map_entry_t* universe_map_lookup(const universe_map_t* map, uint16_t universe)
+{
+    // Consecutive universes, so the table is indexed directly
+    uint16_t index = universe - map->first_universe;
+    return index < map->count ? &map->entries[index] : NULL;
+}
+
+size_t universe_map_index(const universe_map_t* map, const universe_map_entry_t* entry)
+{
+    return entry - map->entries;
+}
+
+uint32_t universe_map_all_mask(const universe_map_t* map)
+{
+    return map->count >= 32 ? UINT32_MAX : (1UL << map->count) - 1;
+}
@@ -0,0 +1,67 @@
+#ifndef UNIVERSE_MAP_H
+#define UNIVERSE_MAP_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stddef.h>
+
+#define UNIVERSE_MAP_MAX_UNIVERSES  16
+#define DMX_UNIVERSE_SIZE           512
+
+/**
+ * Where one universe lands in the LED buffer
+ */
+typedef struct {
+    uint16_t universe;      // Universe number
+    uint32_t byte_offset;   // Byte offset in LED buffer of channel 1
+    uint16_t length;        // Channels used, always whole LEDs
+} universe_map_entry_t;
+
+/**
+ * Consecutive universes laid end to end over the LED buffer
+ * Each universe carries as many whole LEDs as fit in 512 channels
+ * (170 RGB or 128 RGBW), so no LED straddles two universes.
+ */
+typedef struct {
+    uint16_t first_universe;
+    uint16_t channels_per_universe;
+    size_t count;
+    universe_map_entry_t entries[UNIVERSE_MAP_MAX_UNIVERSES];
+} universe_map_t;
+
+/**
+ * Build the universe table for an LED buffer
+ * Universes beyond UNIVERSE_MAP_MAX_UNIVERSES are left unmapped.
+ * @param map Map to fill
+ * @param first_universe Universe carrying the first LED
+ * @param buffer_size LED buffer size in bytes
+ * @param channels_per_led Bytes per LED
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t universe_map_build(universe_map_t* map, uint16_t first_universe, size_t buffer_size,
+                             uint8_t channels_per_led);
+
+/**
+ * Look up a universe
+ * @param map Map to search
+ * @param universe Universe number
+ * @return Entry for the universe, or NULL if it does not belong to this board
+ */
+const universe_map_entry_t* universe_map_lookup(const universe_map_t* map, uint16_t universe);
+
+/**
+ * Get the index of a mapped universe, for per-universe bookkeeping
+ * @param map Map the entry belongs to
+ * @param entry Entry returned by universe_map_lookup
+ * @return Index in 0..count-1
+ */
+size_t universe_map_index(const universe_map_t* map, const universe_map_entry_t* entry);
+
+/**
+ * Get a bit mask with one bit set per mapped universe index
+ * @param map Map to describe
+ * @return Mask of all mapped universes, for tracking frame completeness
+ */
+uint32_t universe_map_all_mask(const universe_map_t* map);
+
+#endif // UNIVERSE_MAP_H
@@ -5,10 +5,14 @@
 #include "esp_wifi.h"
 #include "esp_netif.h"
 #include "esp_event.h"
+#include "esp_timer.h"
+#include "nvs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "freertos/semphr.h"
 #include <string.h>
+#include <inttypes.h>
 
 static const char *TAG = "WIFI_MANAGER";
 
@@ -16,6 +20,16 @@ static const char *TAG = "WIFI_MANAGER";
 #define WIFI_CONNECTED_BIT    BIT0
 #define WIFI_FAIL_BIT         BIT1
 
+// Last AP joined, so the next connect can skip the scan
+#define WIFI_CACHE_NAMESPACE  "wifi_cache"
+#define WIFI_CACHE_KEY        "ap"
+
+typedef struct {
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+} wifi_ap_cache_t;
+
 // Global variables
 static EventGroupHandle_t g_wifi_event_group;
 static esp_netif_t *g_sta_netif = NULL;
@@ -23,6 +37,116 @@ static wifi_status_t g_wifi_status = WIFI_STATUS_DISCONNECTED;
 static esp_ip4_addr_t g_ip_addr = {0};
 static wifi_event_cb_t g_event_callback = NULL;
 static int g_retry_count = 0;
+static bool g_streaming = false;
+static int64_t g_ps_since_us = 0;      // When the current power save mode was set
+static SemaphoreHandle_t g_ps_mutex = NULL;  // Power save is switched from several tasks
+static wifi_config_t g_wifi_config;
+static wifi_ap_cache_t g_ap_cache;
+static bool g_directed = false;        // g_wifi_config names the cached BSSID and channel
+static bool g_associated = false;
+static int64_t g_connect_start_us = 0;
+static int64_t g_associated_us = 0;
+static wifi_connect_timing_t g_timing = {0};
+
+static const char* ps_to_string(wifi_ps_type_t ps)
+{
+    switch (ps) {
+        case WIFI_PS_NONE: return "none";
+        case WIFI_PS_MIN_MODEM: return "min modem";
+        case WIFI_PS_MAX_MODEM: return "max modem";
+        default: return "unknown";
+    }
+}
+
+static bool load_ap_cache(const char* ssid)
+{
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+
+    size_t len = sizeof(g_ap_cache);
+    esp_err_t ret = nvs_get_blob(handle, WIFI_CACHE_KEY, &g_ap_cache, &len);
+    nvs_close(handle);
+
+    // An AP cached for other credentials is no use
+    if (ret != ESP_OK || len != sizeof(g_ap_cache) || g_ap_cache.channel == 0 ||
+        strncmp(g_ap_cache.ssid, ssid, sizeof(g_ap_cache.ssid)) != 0) {
+        memset(&g_ap_cache, 0, sizeof(g_ap_cache));
+        return false;
+    }
+    return true;
+}
+
+static void save_ap_cache(const wifi_event_sta_connected_t* event)
+{
+    wifi_ap_cache_t cache = {0};
+    strncpy(cache.ssid, (const char*)g_wifi_config.sta.ssid, sizeof(cache.ssid) - 1);
+    memcpy(cache.bssid, event->bssid, sizeof(cache.bssid));
+    cache.channel = event->channel;
+
+    // Written only when the AP changes, to spare the flash
+    if (memcmp(&cache, &g_ap_cache, sizeof(cache)) == 0) {
+        return;
+    }
+
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(handle, WIFI_CACHE_KEY, &cache, sizeof(cache)) == ESP_OK &&
+        nvs_commit(handle) == ESP_OK) {
+        g_ap_cache = cache;
+        ESP_LOGI(TAG, "Cached AP %02x:%02x:%02x:%02x:%02x:%02x on channel %d",
+                 cache.bssid[0], cache.bssid[1], cache.bssid[2],
+                 cache.bssid[3], cache.bssid[4], cache.bssid[5], cache.channel);
+    }
+    nvs_close(handle);
+}
+
+static void clear_ap_cache(void)
+{
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_CACHE_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+        nvs_erase_key(handle, WIFI_CACHE_KEY);
+        nvs_commit(handle);
+        nvs_close(handle);
+    }
+    memset(&g_ap_cache, 0, sizeof(g_ap_cache));
+}
+
+/**
+ * Use the static address from the firmware config, if there is one
+ * With DHCP stopped, esp_netif reports the address as soon as the
+ * station associates.
+ * @return true if a static address was set
+ */
+static bool apply_static_ip(void)
+{
+    esp_netif_ip_info_t ip_info = {0};
+    uint32_t dns = 0;
+    if (!config_get_static_ip(&ip_info.ip.addr, &ip_info.netmask.addr, &ip_info.gw.addr, &dns)) {
+        return false;
+    }
+
+    esp_netif_dhcpc_stop(g_sta_netif);
+    esp_err_t ret = esp_netif_set_ip_info(g_sta_netif, &ip_info);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set static IP, using DHCP: %s", esp_err_to_name(ret));
+        esp_netif_dhcpc_start(g_sta_netif);
+        return false;
+    }
+
+    if (dns != 0) {
+        esp_netif_dns_info_t dns_info = {0};
+        dns_info.ip.u_addr.ip4.addr = dns;
+        dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+        esp_netif_set_dns_info(g_sta_netif, ESP_NETIF_DNS_MAIN, &dns_info);
+    }
+
+    ESP_LOGI(TAG, "Static IP " IPSTR ", DHCP skipped", IP2STR(&ip_info.ip));
+    return true;
+}
 
 /**
  * WiFi event handler
@@ -32,15 +156,42 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
         ESP_LOGI(TAG, "WiFi station started");
+        g_connect_start_us = esp_timer_get_time();
         esp_wifi_connect();
         g_wifi_status = WIFI_STATUS_CONNECTING;
         
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        g_associated = true;
+        g_associated_us = esp_timer_get_time();
+        g_timing.associate_ms = (uint32_t)((g_associated_us - g_connect_start_us) / 1000);
+#if CONFIG_WIFI_FAST_CONNECT
+        save_ap_cache((const wifi_event_sta_connected_t*)event_data);
+#endif
+
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        bool was_associated = g_associated;
+        g_associated = false;
+
+        // The cached AP has gone or moved channel: scan like a first connect
+        if (g_directed && !was_associated) {
+            ESP_LOGW(TAG, "Cached AP not found, falling back to a full scan");
+            g_directed = false;
+            g_timing.cached_ap = false;
+            g_wifi_config.sta.bssid_set = false;
+            g_wifi_config.sta.channel = 0;
+            esp_wifi_set_config(WIFI_IF_STA, &g_wifi_config);
+            clear_ap_cache();
+            g_connect_start_us = esp_timer_get_time();
+            esp_wifi_connect();
+            return;
+        }
+
         ESP_LOGW(TAG, "WiFi disconnected");
         g_wifi_status = WIFI_STATUS_DISCONNECTED;
         g_ip_addr.addr = 0;
         
         if (g_retry_count < WIFI_MAXIMUM_RETRY) {
+            g_connect_start_us = esp_timer_get_time();
             esp_wifi_connect();
             g_retry_count++;
             ESP_LOGI(TAG, "Retry to connect to the AP (attempt %d/%d)", 
@@ -61,8 +212,13 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         g_ip_addr = event->ip_info.ip;
         g_wifi_status = WIFI_STATUS_CONNECTED;
         g_retry_count = 0;
+        g_timing.ip_ms = (uint32_t)((esp_timer_get_time() - g_associated_us) / 1000);
         
         ESP_LOGI(TAG, "Got IP address: " IPSTR, IP2STR(&g_ip_addr));
+        ESP_LOGI(TAG, "Connected in %" PRIu32 " ms: associated %" PRIu32 " ms (%s), IP %" PRIu32 " ms (%s)",
+                 g_timing.associate_ms + g_timing.ip_ms,
+                 g_timing.associate_ms, g_timing.cached_ap ? "cached AP" : "scan",
+                 g_timing.ip_ms, g_timing.static_ip ? "static" : "DHCP");
         
         xEventGroupSetBits(g_wifi_event_group, WIFI_CONNECTED_BIT);
         state_machine_handle_event(EVENT_WIFI_CONNECTED);
@@ -84,6 +240,14 @@ esp_err_t wifi_manager_init(void)
         ESP_LOGE(TAG, "Failed to create WiFi event group");
         return ESP_ERR_NO_MEM;
     }
+
+    g_ps_mutex = xSemaphoreCreateMutex();
+    if (!g_ps_mutex) {
+        ESP_LOGE(TAG, "Failed to create power save mutex");
+        vEventGroupDelete(g_wifi_event_group);
+        g_wifi_event_group = NULL;
+        return ESP_ERR_NO_MEM;
+    }
     
     // Initialize TCP/IP stack
     ESP_ERROR_CHECK(esp_netif_init());
@@ -125,17 +289,37 @@ esp_err_t wifi_manager_connect(const char* ssid, const char* password)
     ESP_LOGI(TAG, "Connecting to WiFi SSID: %s", ssid);
     
     // Configure WiFi
-    wifi_config_t wifi_config = {0};
-    strncpy((char*)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
+    memset(&g_wifi_config, 0, sizeof(g_wifi_config));
+    strncpy((char*)g_wifi_config.sta.ssid, ssid, sizeof(g_wifi_config.sta.ssid) - 1);
     if (password) {
-        strncpy((char*)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
+        strncpy((char*)g_wifi_config.sta.password, password, sizeof(g_wifi_config.sta.password) - 1);
+    }
+
+    // Go straight to the last AP joined; the disconnect handler scans
+    // normally if it is not there
+#if CONFIG_WIFI_FAST_CONNECT
+    g_directed = load_ap_cache(ssid);
+#endif
+    if (g_directed) {
+        g_wifi_config.sta.bssid_set = true;
+        memcpy(g_wifi_config.sta.bssid, g_ap_cache.bssid, sizeof(g_ap_cache.bssid));
+        g_wifi_config.sta.channel = g_ap_cache.channel;
+        ESP_LOGI(TAG, "Connecting to cached AP on channel %d", g_ap_cache.channel);
     }
+    g_timing.cached_ap = g_directed;
+    g_timing.static_ip = apply_static_ip();
     
     // Set WiFi configuration
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
+    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &g_wifi_config));
     
     // Start WiFi
     ESP_ERROR_CHECK(esp_wifi_start());
+
+    // Kept by the driver across reconnects
+    xSemaphoreTake(g_ps_mutex, portMAX_DELAY);
+    esp_wifi_set_ps(g_streaming ? WIFI_PS_NONE : WIFI_IDLE_POWER_SAVE);
+    g_ps_since_us = esp_timer_get_time();
+    xSemaphoreGive(g_ps_mutex);
     
     g_retry_count = 0;
     g_wifi_status = WIFI_STATUS_CONNECTING;
@@ -168,6 +352,11 @@ esp_ip4_addr_t wifi_manager_get_ip(void)
     return g_ip_addr;
 }
 
+esp_netif_t* wifi_manager_get_netif(void)
+{
+    return g_sta_netif;
+}
+
 wifi_status_t wifi_manager_get_status(void)
 {
     return g_wifi_status;
@@ -179,6 +368,49 @@ esp_err_t wifi_manager_register_callback(wifi_event_cb_t callback)
     return ESP_OK;
 }
 
+esp_err_t wifi_manager_get_connect_timing(wifi_connect_timing_t* timing)
+{
+    if (!timing) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *timing = g_timing;
+    return ESP_OK;
+}
+
+esp_err_t wifi_manager_set_streaming(bool streaming)
+{
+    if (!g_ps_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // The check and the switch go together, so two callers cannot leave
+    // the driver in the mode opposite to g_streaming
+    xSemaphoreTake(g_ps_mutex, portMAX_DELAY);
+    if (streaming == g_streaming) {
+        xSemaphoreGive(g_ps_mutex);
+        return ESP_OK;
+    }
+
+    wifi_ps_type_t ps = streaming ? WIFI_PS_NONE : WIFI_IDLE_POWER_SAVE;
+    esp_err_t ret = esp_wifi_set_ps(ps);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(g_ps_mutex);
+        ESP_LOGW(TAG, "Failed to set power save %s: %s", ps_to_string(ps), esp_err_to_name(ret));
+        return ret;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    int64_t held_ms = g_ps_since_us ? (now_us - g_ps_since_us) / 1000 : 0;
+    g_streaming = streaming;
+    g_ps_since_us = now_us;
+    xSemaphoreGive(g_ps_mutex);
+
+    ESP_LOGI(TAG, "Power save %s (%s, previous mode held %" PRId64 " ms)",
+             ps_to_string(ps), streaming ? "streaming" : "idle", held_ms);
+    return ESP_OK;
+}
+
 int8_t wifi_manager_get_rssi(void)
 {
     wifi_ap_record_t ap_info;
@@ -225,6 +457,10 @@ esp_err_t wifi_manager_deinit(void)
         vEventGroupDelete(g_wifi_event_group);
         g_wifi_event_group = NULL;
     }
+    if (g_ps_mutex) {
+        vSemaphoreDelete(g_ps_mutex);
+        g_ps_mutex = NULL;
+    }
     
     g_wifi_status = WIFI_STATUS_DISCONNECTED;
     g_ip_addr.addr = 0;
@@ -16,6 +16,16 @@ typedef enum {
     WIFI_STATUS_ERROR
 } wifi_status_t;
 
+/**
+ * How the last connection was made and how long it took
+ */
+typedef struct {
+    bool static_ip;                 // Address from the firmware config, no DHCP
+    bool cached_ap;                 // Joined the cached BSSID and channel without a scan
+    uint32_t associate_ms;          // Connect start to association
+    uint32_t ip_ms;                 // Association to IP address
+} wifi_connect_timing_t;
+
 /**
  * WiFi event callback function type
  */
@@ -53,6 +63,12 @@ bool wifi_manager_is_connected(void);
  */
 esp_ip4_addr_t wifi_manager_get_ip(void);
 
+/**
+ * Get the station network interface
+ * @return esp_netif handle, NULL before wifi_manager_init()
+ */
+esp_netif_t* wifi_manager_get_netif(void);
+
 /**
  * Get WiFi connection status
  * @return Current WiFi status
@@ -66,6 +82,23 @@ wifi_status_t wifi_manager_get_status(void);
  */
 esp_err_t wifi_manager_register_callback(wifi_event_cb_t callback);
 
+/**
+ * Get how the last connection was made
+ * @param timing Pointer to store the timing
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t wifi_manager_get_connect_timing(wifi_connect_timing_t* timing);
+
+/**
+ * Set the power save mode for streaming or idle
+ * Streaming turns power save off so packets are not held back until the
+ * next beacon; idle goes back to WIFI_IDLE_POWER_SAVE. Safe to call from
+ * any task.
+ * @param streaming true while LED data is streaming
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t wifi_manager_set_streaming(bool streaming);
+
 /**
  * Get WiFi signal strength (RSSI)
  * @return RSSI value in dBm
@@ -0,0 +1,391 @@
+#!/usr/bin/env python3
+"""
+Time host for the ambient light board clock synchronization (packet 0x09).
+
+The board asks for the time; this script answers. Send a START packet to
+make the board use this host, then answer every REQUEST with the host's
+receive and transmit timestamps:
+
+    REQUEST  (board -> host): 09 01 <seq> <t1 u64>
+    RESPONSE (host -> board): 09 02 <seq> <t1 u64> <t2 u64> <t3 u64>
+
+All timestamps are microseconds, big-endian. Host timestamps come from
+time.monotonic(); frame timestamps (0x08 TIMESTAMP flag) sent by the same
+host must use the same clock.
+
+Several boards can share one time host; their timestamped frames are then
+latched on the same presentation grid boundary. With --status the host
+polls every board for its estimated sync error and grid phase error:
+
+    STATUS REQUEST (host -> board): 09 04
+    STATUS         (board -> host): 09 05 <synced u8> <error_us u32>
+                                    <grid_frames u32> <phase_us i32> <max_phase_us u32>
+
+--selftest runs a simulated board on loopback that applies the same
+min-delay filter and drift estimate as main/clock_sync.c, with a skewed,
+drifting local clock and random queueing delay, and checks that its view
+of host time converges. --simulate N runs N such boards at once, each
+latching frames on the presentation grid, and checks that they all hit
+the grid within --limit-us of each other.
+
+Examples:
+    python3 tools/clock-sync-host.py board-left.local board-right.local --status 5
+    python3 tools/clock-sync-host.py --selftest --drift-ppm 40 --duration 30
+    python3 tools/clock-sync-host.py --simulate 3 --duration 20
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+
+PACKET_TYPE_TIME_SYNC = 0x09
+KIND_START = 0x00
+KIND_REQUEST = 0x01
+KIND_RESPONSE = 0x02
+KIND_STOP = 0x03
+KIND_STATUS_REQUEST = 0x04
+KIND_STATUS = 0x05
+
+REQUEST_FORMAT = ">BBBQ"
+RESPONSE_FORMAT = ">BBBQQQ"
+STATUS_FORMAT = ">BBBIIiI"
+
+# Mirrors main/clock_sync.c
+SAMPLES = 8
+MIN_SAMPLES = 4
+FAST_INTERVAL_US = 200_000
+INTERVAL_US = 1_000_000
+MAX_RTT_US = 100_000
+DRIFT_MIN_SPAN_US = 4_000_000
+DRIFT_ANCHOR_US = 60_000_000
+MAX_DRIFT_PPB = 500_000
+GRID_PERIOD_US = 16_667
+LATENCY_US = 40_000
+
+
+def host_now_us():
+    return time.monotonic_ns() // 1000
+
+
+def serve(sock, boards=None, stop_event=None, verbose=False, status_interval=0):
+    """Answer time requests until stop_event is set (or forever)."""
+    sock.settimeout(0.2)
+    answered = 0
+    next_status = time.monotonic() + status_interval
+    while stop_event is None or not stop_event.is_set():
+        if status_interval and boards and time.monotonic() >= next_status:
+            for board in boards:
+                sock.sendto(bytes((PACKET_TYPE_TIME_SYNC, KIND_STATUS_REQUEST)), board)
+            next_status += status_interval
+        try:
+            data, addr = sock.recvfrom(64)
+        except socket.timeout:
+            continue
+        t2 = host_now_us()
+        if len(data) < 2 or data[0] != PACKET_TYPE_TIME_SYNC:
+            continue
+        if boards is not None and addr not in boards:
+            continue
+        if data[1] == KIND_STATUS and len(data) == struct.calcsize(STATUS_FORMAT):
+            _, _, synced, error, frames, phase, max_phase = struct.unpack(STATUS_FORMAT, data)
+            print(f"{addr[0]}:{addr[1]} synced={bool(synced)} error=+/-{error} us "
+                  f"grid_frames={frames} phase={phase} us max_phase={max_phase} us")
+            continue
+        if data[1] != KIND_REQUEST or len(data) != struct.calcsize(REQUEST_FORMAT):
+            continue
+        _, _, seq, t1 = struct.unpack(REQUEST_FORMAT, data)
+        t3 = host_now_us()
+        sock.sendto(struct.pack(RESPONSE_FORMAT, PACKET_TYPE_TIME_SYNC, KIND_RESPONSE,
+                                seq, t1, t2, t3), addr)
+        answered += 1
+        if verbose:
+            print(f"answered request {seq} from {addr[0]}:{addr[1]}")
+    return answered
+
+
+class SimulatedBoard:
+    """Board side of the exchange with a deliberately bad local clock."""
+
+    def __init__(self, host_addr, offset_us, drift_ppm, max_queue_us):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("127.0.0.1", 0))
+        self.sock.settimeout(0.05)
+        self.host_addr = host_addr
+        self.base = host_now_us()
+        self.offset_us = offset_us
+        self.drift = drift_ppm * 1e-6
+        self.max_queue_us = max_queue_us
+        self.seq = 0
+
+        self.samples = []
+        self.count = 0
+        self.anchor = None
+        self.drift_valid = False
+        self.last_fit = None
+        self.jitter_us = 0
+        self.model = None  # (ref_local, offset, drift_ppb)
+        self.synced = False
+
+    def local_now_us(self):
+        host = host_now_us()
+        return int(host + self.offset_us + (host - self.base) * self.drift)
+
+    def local_to_host(self, local_us):
+        ref, offset, drift_ppb = self.model
+        return local_us + offset + (local_us - ref) * drift_ppb // 1_000_000_000
+
+    def host_to_local(self, host_us):
+        ref, offset, drift_ppb = self.model
+        local_us = host_us - offset
+        return local_us - (local_us - ref) * drift_ppb // 1_000_000_000
+
+    def queue_delay(self):
+        # Emulates WiFi/lwIP queueing: mostly small, occasionally large
+        if random.random() < 0.2:
+            time.sleep(random.uniform(0, self.max_queue_us) / 1e6)
+
+    def exchange(self):
+        self.seq = (self.seq + 1) & 0xFF
+        self.queue_delay()
+        t1 = self.local_now_us()
+        self.sock.sendto(struct.pack(REQUEST_FORMAT, PACKET_TYPE_TIME_SYNC, KIND_REQUEST,
+                                     self.seq, t1), self.host_addr)
+        try:
+            data, _ = self.sock.recvfrom(64)
+        except socket.timeout:
+            return
+        self.queue_delay()
+        t4 = self.local_now_us()
+        _, kind, seq, t1, t2, t3 = struct.unpack(RESPONSE_FORMAT, data)
+        if kind == KIND_RESPONSE and seq == self.seq:
+            self.handle_response(t1, t2, t3, t4)
+
+    def handle_response(self, t1, t2, t3, t4):
+        rtt = (t4 - t1) - (t3 - t2)
+        if t4 < t1 or rtt < 0 or t4 - t1 > MAX_RTT_US:
+            return
+
+        local = t1 + (t4 - t1) // 2
+        offset = ((t2 - t1) + (t3 - t4)) // 2
+
+        if self.synced:
+            residual = offset - (self.local_to_host(local) - local)
+            self.jitter_us += int((abs(residual) - self.jitter_us) / 8)
+
+        sample = (local, offset, rtt)
+        if len(self.samples) < SAMPLES:
+            self.samples.append(sample)
+        else:
+            self.samples[self.count % SAMPLES] = sample
+        self.count += 1
+
+        best = min(self.samples, key=lambda s: s[2])
+        if best[0] == self.last_fit:
+            return
+        self.last_fit = best[0]
+
+        drift_ppb = self.model[2] if self.model else 0
+        if self.anchor is None:
+            self.anchor = best
+        elif best[0] - self.anchor[0] >= DRIFT_MIN_SPAN_US:
+            span = best[0] - self.anchor[0]
+            measured = int((best[1] - self.anchor[1]) * 1_000_000_000 / span)
+            measured = max(-MAX_DRIFT_PPB, min(MAX_DRIFT_PPB, measured))
+            drift_ppb = drift_ppb + int((measured - drift_ppb) / 4) if self.drift_valid else measured
+            self.drift_valid = True
+            if span >= DRIFT_ANCHOR_US:
+                self.anchor = best
+
+        self.model = (best[0], best[1], drift_ppb)
+        self.error_us = best[2] // 2 + self.jitter_us
+        self.synced = self.count >= MIN_SAMPLES
+
+    def error_now_us(self):
+        """Board's view of host time minus true host time."""
+        local = self.local_now_us()
+        truth = host_now_us()
+        return self.local_to_host(local) - truth
+
+
+def selftest(args):
+    host_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    host_sock.bind(("127.0.0.1", 0))
+    stop = threading.Event()
+    server = threading.Thread(target=serve, args=(host_sock, None, stop), daemon=True)
+    server.start()
+
+    board = SimulatedBoard(host_sock.getsockname(), args.offset_us, args.drift_ppm,
+                           args.max_queue_us)
+    print(f"simulated board: offset {args.offset_us} us, drift {args.drift_ppm} ppm, "
+          f"queueing up to {args.max_queue_us} us")
+    print(f"{'time s':>7} {'samples':>8} {'synced':>7} {'drift ppm':>10} "
+          f"{'est. error us':>14} {'true error us':>14}")
+
+    start = time.monotonic()
+    next_report = start
+    errors = []
+    while time.monotonic() - start < args.duration:
+        board.exchange()
+        elapsed = time.monotonic() - start
+        if board.synced:
+            errors.append((elapsed, board.error_now_us()))
+        if time.monotonic() >= next_report and board.model:
+            true_err = board.error_now_us() if board.synced else float("nan")
+            print(f"{elapsed:>7.1f} {board.count:>8} {str(board.synced):>7} "
+                  f"{board.model[2] / 1000:>10.2f} {board.error_us:>14} {true_err:>14.0f}")
+            next_report += 1.0
+        interval = FAST_INTERVAL_US if board.count < SAMPLES else INTERVAL_US
+        time.sleep(interval / 1e6 / args.speedup)
+
+    stop.set()
+    server.join()
+
+    # Judge only the second half, after the drift estimate had time to settle
+    settled = [abs(e) for t, e in errors if t >= args.duration / 2]
+    if not settled:
+        print("FAIL: board never synchronized")
+        return 1
+    worst = max(settled)
+    print(f"worst |error| over last {args.duration / 2:.0f} s: {worst} us "
+          f"(limit {args.limit_us} us), drift estimate {board.model[2] / 1000:.2f} ppm "
+          f"(expected {-args.drift_ppm / (1 + args.drift_ppm * 1e-6):.2f} ppm)")
+    if worst > args.limit_us:
+        print("FAIL")
+        return 1
+    print("PASS")
+    return 0
+
+
+def present_on_grid(board, stop, phases):
+    """Latch frames like jitter_buffer.c does once the clock is synced."""
+    while not stop.is_set():
+        if not board.synced:
+            time.sleep(0.05)
+            continue
+        pts = host_now_us()
+        grid = -(-(pts + LATENCY_US) // GRID_PERIOD_US) * GRID_PERIOD_US
+        target = board.host_to_local(grid)
+        # The board only knows its own clock, so wait on that
+        while True:
+            remaining = target - board.local_now_us()
+            if remaining <= 0:
+                break
+            time.sleep(max(remaining - 300, 50) / 1e6 if remaining > 400 else 0)
+        phases.append((time.monotonic(), host_now_us() - grid))
+        time.sleep(GRID_PERIOD_US / 1e6 / 2)
+
+
+def simulate(args):
+    host_sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    host_sock.bind(("127.0.0.1", 0))
+    stop = threading.Event()
+    server = threading.Thread(target=serve, args=(host_sock, None, stop), daemon=True)
+    server.start()
+
+    rng = random.Random(1)
+    boards = []
+    for _ in range(args.simulate):
+        offset = rng.randint(1, 10_000) * 1_000_000 + rng.randint(0, 999_999)
+        drift = rng.uniform(-args.drift_ppm, args.drift_ppm)
+        boards.append(SimulatedBoard(host_sock.getsockname(), offset, drift, args.max_queue_us))
+
+    def sync_loop(board):
+        while not stop.is_set():
+            board.exchange()
+            interval = FAST_INTERVAL_US if board.count < SAMPLES else INTERVAL_US
+            time.sleep(interval / 1e6 / args.speedup)
+
+    phases = [[] for _ in boards]
+    threads = []
+    for board, board_phases in zip(boards, phases):
+        threads.append(threading.Thread(target=sync_loop, args=(board,), daemon=True))
+        threads.append(threading.Thread(target=present_on_grid, args=(board, stop, board_phases),
+                                        daemon=True))
+    start = time.monotonic()
+    for thread in threads:
+        thread.start()
+    time.sleep(args.duration)
+    stop.set()
+    for thread in threads:
+        thread.join()
+    server.join()
+
+    # Judge only the second half, after sync and drift have settled
+    settle = start + args.duration / 2
+    # Python thread wake-ups add occasional multi-millisecond outliers that
+    # the board's esp_timer does not have, so report p95 next to the max
+    print(f"{'board':>5} {'drift ppm':>10} {'frames':>7} {'median us':>10} {'p95 |phase| us':>15} "
+          f"{'max |phase| us':>15}")
+    medians = []
+    worst = 0
+    for index, (board, board_phases) in enumerate(zip(boards, phases)):
+        settled = sorted(p for t, p in board_phases if t >= settle)
+        if not settled:
+            print(f"FAIL: board {index} presented no frames")
+            return 1
+        median = settled[len(settled) // 2]
+        magnitudes = sorted(abs(p) for p in settled)
+        p95 = magnitudes[int(0.95 * (len(magnitudes) - 1))]
+        medians.append(median)
+        worst = max(worst, p95)
+        print(f"{index:>5} {board.drift * 1e6:>10.2f} {len(settled):>7} {median:>10} {p95:>15} "
+              f"{magnitudes[-1]:>15}")
+
+    skew = max(medians) - min(medians)
+    print(f"median skew between boards: {skew} us, worst p95 phase error: {worst} us "
+          f"(limit {args.limit_us} us)")
+    if skew > args.limit_us:
+        print("FAIL")
+        return 1
+    print("PASS")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hosts", nargs="*", help="board hostnames or IP addresses")
+    parser.add_argument("--port", type=int, default=23042)
+    parser.add_argument("--verbose", action="store_true")
+    parser.add_argument("--status", type=float, default=0, metavar="SECONDS",
+                        help="poll boards for sync and phase error at this interval")
+    parser.add_argument("--selftest", action="store_true", help="loopback convergence test")
+    parser.add_argument("--simulate", type=int, default=0, metavar="N",
+                        help="loopback multi-board grid alignment test with N boards")
+    parser.add_argument("--duration", type=float, default=20.0, help="selftest length in seconds")
+    parser.add_argument("--offset-us", type=int, default=3_600_000_000,
+                        help="selftest board clock offset")
+    parser.add_argument("--drift-ppm", type=float, default=40.0, help="selftest board clock drift")
+    parser.add_argument("--max-queue-us", type=int, default=5000,
+                        help="selftest worst random queueing delay")
+    parser.add_argument("--limit-us", type=int, default=500, help="selftest pass threshold")
+    parser.add_argument("--speedup", type=float, default=4.0,
+                        help="selftest: divide request intervals by this factor")
+    args = parser.parse_args()
+
+    if args.selftest:
+        return selftest(args)
+    if args.simulate:
+        return simulate(args)
+
+    if not args.hosts:
+        parser.error("at least one host is required unless --selftest or --simulate is given")
+
+    boards = {(socket.gethostbyname(host), args.port) for host in args.hosts}
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    for board in boards:
+        sock.sendto(bytes((PACKET_TYPE_TIME_SYNC, KIND_START)), board)
+    print(f"serving time to {', '.join(f'{b[0]}:{b[1]}' for b in boards)}, Ctrl-C to stop")
+    try:
+        serve(sock, boards, verbose=args.verbose, status_interval=args.status)
+    except KeyboardInterrupt:
+        for board in boards:
+            sock.sendto(bytes((PACKET_TYPE_TIME_SYNC, KIND_STOP)), board)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
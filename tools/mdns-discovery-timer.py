@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+Measure how long the ambient light board takes to become discoverable.
+
+Listens passively to mDNS traffic (224.0.0.251:5353) while the board joins
+the network. The board's first probe for <hostname>.local goes out right
+after it gets an address, so it is taken as time zero. From there the
+script reports when a response first carried:
+
+    A     the board's address record (hostname resolves)
+    PTR   _ambient_light._udp.local (service browsers see the board)
+
+and when each later unsolicited announcement was heard. With --query it
+also asks for the service every 250 ms, as a browser would, to show when
+the board first answers a query rather than only announcing.
+
+Reset the board or drop it off the AP after starting the script; --repeat
+waits for that many joins in a row and prints the spread at the end.
+
+Examples:
+    python3 tools/mdns-discovery-timer.py
+    python3 tools/mdns-discovery-timer.py --hostname board-rs --query --repeat 5
+"""
+
+import argparse
+import select
+import socket
+import statistics
+import struct
+import time
+
+MDNS_GROUP = "224.0.0.251"
+MDNS_PORT = 5353
+SERVICE = "_ambient_light._udp.local"
+QUERY_INTERVAL_S = 0.25
+LISTEN_AFTER_S = 10.0               # Announcements heard after the service shows up
+
+TYPE_A = 1
+TYPE_PTR = 12
+FLAG_RESPONSE = 0x8000
+
+
+def read_name(data, offset):
+    """Read a possibly compressed name; returns (name, offset after it)."""
+    labels = []
+    end = None
+    for _ in range(128):                # Bound pointer loops
+        length = data[offset]
+        if length & 0xC0 == 0xC0:
+            if end is None:
+                end = offset + 2
+            offset = ((length & 0x3F) << 8) | data[offset + 1]
+            continue
+        offset += 1
+        if length == 0:
+            break
+        labels.append(data[offset:offset + length].decode("utf-8", "replace"))
+        offset += length
+    return ".".join(labels).lower(), end if end is not None else offset
+
+
+def parse_message(data):
+    """Split a DNS message into (is_response, question names, records)."""
+    _, flags, qdcount, ancount, nscount, arcount = struct.unpack_from(">HHHHHH", data)
+    offset = 12
+    questions = []
+    for _ in range(qdcount):
+        name, offset = read_name(data, offset)
+        offset += 4
+        questions.append(name)
+    records = []
+    for _ in range(ancount + nscount + arcount):
+        name, offset = read_name(data, offset)
+        rtype, _, _, rdlength = struct.unpack_from(">HHIH", data, offset)
+        offset += 10
+        rdata = data[offset:offset + rdlength]
+        if rtype == TYPE_PTR:
+            rdata = read_name(data, offset)[0]
+        elif rtype == TYPE_A and rdlength == 4:
+            rdata = socket.inet_ntoa(rdata)
+        offset += rdlength
+        records.append((name, rtype, rdata))
+    return bool(flags & FLAG_RESPONSE), questions, records
+
+
+def build_ptr_query(name):
+    """A one-question PTR query with the unicast-response bit clear."""
+    qname = b"".join(bytes([len(label)]) + label.encode() for label in name.split(".")) + b"\0"
+    return struct.pack(">HHHHHH", 0, 0, 1, 0, 0, 0) + qname + struct.pack(">HH", TYPE_PTR, 1)
+
+
+def open_socket(interface):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    if hasattr(socket, "SO_REUSEPORT"):
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEPORT, 1)
+    sock.bind(("", MDNS_PORT))
+    membership = socket.inet_aton(MDNS_GROUP) + socket.inet_aton(interface)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_IF, socket.inet_aton(interface))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 255)
+    return sock
+
+
+def measure_join(sock, hostname, query):
+    """Wait for one join and time it; returns a dict of millisecond offsets."""
+    host = hostname.lower() + ".local"
+    result = {"address": None, "a_ms": None, "ptr_ms": None, "announce_ms": []}
+    t0 = None
+    deadline = None
+    next_query = 0.0
+
+    while deadline is None or time.monotonic() < deadline:
+        now = time.monotonic()
+        if query and t0 is not None and now >= next_query:
+            sock.sendto(build_ptr_query(SERVICE), (MDNS_GROUP, MDNS_PORT))
+            next_query = now + QUERY_INTERVAL_S
+        timeout = QUERY_INTERVAL_S if t0 is not None else 1.0
+        if not select.select([sock], [], [], timeout)[0]:
+            continue
+        data, source = sock.recvfrom(9000)
+        now = time.monotonic()
+        try:
+            is_response, questions, records = parse_message(data)
+        except (IndexError, struct.error):
+            continue
+
+        if not is_response:
+            # Probes ask about the name and carry the proposed records
+            if t0 is None and host in questions and any(name == host for name, _, _ in records):
+                print(f"Probe from {source[0]}")
+                t0 = now
+            continue
+        if t0 is None:
+            continue
+
+        ms = (now - t0) * 1000
+        if result["a_ms"] is None:
+            for name, rtype, rdata in records:
+                if name == host and rtype == TYPE_A:
+                    result["a_ms"] = ms
+                    result["address"] = rdata
+                    print(f"  {ms:8.0f} ms  A {rdata}")
+        if any(name == SERVICE and rtype == TYPE_PTR for name, rtype, _ in records):
+            if result["ptr_ms"] is None:
+                result["ptr_ms"] = ms
+                deadline = now + LISTEN_AFTER_S
+                print(f"  {ms:8.0f} ms  PTR {SERVICE}")
+            elif source[0] == result["address"]:
+                result["announce_ms"].append(ms)
+                print(f"  {ms:8.0f} ms  again")
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--hostname", default="board-rs", help="Board mDNS hostname (default: board-rs)")
+    parser.add_argument("--interface", default="0.0.0.0", help="Local address to listen on (default: any)")
+    parser.add_argument("--query", action="store_true", help="Also query for the service every 250 ms")
+    parser.add_argument("--repeat", type=int, default=1, help="Joins to measure (default: 1)")
+    args = parser.parse_args()
+
+    sock = open_socket(args.interface)
+    print(f"Waiting for {args.hostname}.local to probe; reset the board or drop it off the AP")
+
+    ptr_times = []
+    for run in range(args.repeat):
+        result = measure_join(sock, args.hostname, args.query)
+        ptr_times.append(result["ptr_ms"])
+        if args.repeat > 1:
+            print(f"Join {run + 1}/{args.repeat}: service seen {result['ptr_ms']:.0f} ms after the first probe")
+
+    if len(ptr_times) > 1:
+        print(f"Probe to service: min {min(ptr_times):.0f} ms, median {statistics.median(ptr_times):.0f} ms, "
+              f"max {max(ptr_times):.0f} ms")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,370 @@
+#!/usr/bin/env python3
+"""
+Reliable-frame sender for the ambient light board (0x08 FRAGMENT + 0x0D NACK).
+
+Every frame is split into 0x08 packets carrying SEQUENCE and FRAGMENT
+fields, so the board knows how many fragments make up the frame. The board
+holds a frame back until it is complete. If fragments are missing after
+RELIABLE_NACK_DELAY_MS, it sends a NACK listing them, and this sender
+resends exactly those datagrams:
+
+    NACK (board -> host): 0D 01 <frame_id u16> <count u8> <missing bitmap u32>
+
+Bit n of the bitmap is fragment n. Frames still incomplete at the board's
+deadline (RELIABLE_FRAME_DEADLINE_MS) are dropped, never shown partially.
+Recent frames are kept for resending; older NACKs are ignored.
+
+--drop PCT discards that share of first transmissions to exercise the
+resend path against a real board. --standin runs a Linux stand-in for the
+board on loopback instead. It mirrors main/frame_assembler.c: the same
+NACK delay, deadline and slot count, plus --loss PCT random loss on
+everything it receives, resends included. It checks that every delivered
+frame is bit-exact, that no partial frame was ever delivered and that at
+least 90% of frames were delivered.
+--slice BASE:COUNT makes the stand-in show only LEDs BASE..BASE+COUNT-1
+of a larger shared frame (UDP_SLICE_BASE_LED), as boards splitting one
+multicast stream do: fragments outside the slice carry nothing for it but
+must still complete the frame.
+
+Examples:
+    python3 tools/reliable-sender.py board-rs.local --leds 500 --drop 3
+    python3 tools/reliable-sender.py --standin --loss 5 --duration 10
+    python3 tools/reliable-sender.py --standin --leds 1200 --slice 600:300
+"""
+
+import argparse
+import random
+import select
+import socket
+import struct
+import sys
+import threading
+import time
+
+PACKET_TYPE_LED_DATA_EXT = 0x08
+LED_DATA_EXT_VERSION = 1
+LED_DATA_EXT_FLAG_LED_UNITS = 0x01
+LED_DATA_EXT_FLAG_TIMESTAMP = 0x02
+LED_DATA_EXT_FLAG_PUSH = 0x04
+LED_DATA_EXT_FLAG_SEQUENCE = 0x08
+LED_DATA_EXT_FLAG_FEC = 0x10
+LED_DATA_EXT_FLAG_FRAGMENT = 0x20
+PACKET_TYPE_NACK = 0x0D
+NACK_VERSION = 1
+NACK_FORMAT = ">BBHBI"
+
+EXT_HEADER_FORMAT = ">BBBI"
+EXT_HEADER_SIZE = 7
+EXT_TIMESTAMP_SIZE = 8
+EXT_SEQUENCE_SIZE = 4
+EXT_FEC_SIZE = 3
+EXT_FRAGMENT_SIZE = 2
+MAX_FRAGMENTS = 32
+DEFAULT_MAX_PAYLOAD = 1472
+HISTORY_FRAMES = 16
+
+# Mirrors main/frame_assembler.c and the Kconfig defaults
+ASSEMBLER_SLOTS = 3
+NACK_DELAY_S = 0.010
+FRAME_DEADLINE_S = 0.050
+
+
+def make_frame(frame_index, led_count, channels):
+    """A moving gradient; deterministic so the stand-in can check it."""
+    data = bytearray(led_count * channels)
+    for led in range(led_count):
+        for c in range(channels):
+            data[led * channels + c] = (led * 3 + frame_index * 5 + c * 64) & 0xFF
+    return bytes(data)
+
+
+def build_reliable_frame(data, channels, frame_id, first_seq, max_payload, pts_us=None):
+    """Split a frame into sequenced FRAGMENT packets of whole LEDs."""
+    header_size = (EXT_HEADER_SIZE + EXT_SEQUENCE_SIZE + EXT_FRAGMENT_SIZE +
+                   (EXT_TIMESTAMP_SIZE if pts_us is not None else 0))
+    step = ((max_payload - header_size) // channels) * channels
+    starts = list(range(0, len(data), step))
+    if len(starts) > MAX_FRAGMENTS:
+        raise ValueError(f"frame needs {len(starts)} fragments, at most {MAX_FRAGMENTS} allowed")
+
+    packets = []
+    for index, offset in enumerate(starts):
+        flags = LED_DATA_EXT_FLAG_LED_UNITS | LED_DATA_EXT_FLAG_SEQUENCE | LED_DATA_EXT_FLAG_FRAGMENT
+        if pts_us is not None:
+            flags |= LED_DATA_EXT_FLAG_TIMESTAMP
+        if index == len(starts) - 1:
+            flags |= LED_DATA_EXT_FLAG_PUSH
+        packet = struct.pack(EXT_HEADER_FORMAT, PACKET_TYPE_LED_DATA_EXT, LED_DATA_EXT_VERSION,
+                             flags, offset // channels)
+        if pts_us is not None:
+            packet += struct.pack(">Q", pts_us)
+        packet += struct.pack(">HH", (first_seq + index) & 0xFFFF, frame_id & 0xFFFF)
+        packet += bytes((index, len(starts)))
+        packets.append(packet + data[offset:offset + step])
+    return packets
+
+
+def parse_fragment(packet, channels):
+    """Return (frame_id, index, count, byte_offset, data) of a FRAGMENT packet, or None."""
+    if len(packet) < EXT_HEADER_SIZE or packet[0] != PACKET_TYPE_LED_DATA_EXT:
+        return None
+    _, version, flags, offset = struct.unpack(EXT_HEADER_FORMAT, packet[:EXT_HEADER_SIZE])
+    if version != LED_DATA_EXT_VERSION or not flags & LED_DATA_EXT_FLAG_FRAGMENT:
+        return None
+    pos = EXT_HEADER_SIZE
+    if flags & LED_DATA_EXT_FLAG_TIMESTAMP:
+        pos += EXT_TIMESTAMP_SIZE
+    _, frame_id = struct.unpack(">HH", packet[pos:pos + EXT_SEQUENCE_SIZE])
+    pos += EXT_SEQUENCE_SIZE
+    if flags & LED_DATA_EXT_FLAG_FEC:
+        pos += EXT_FEC_SIZE
+    index, count = packet[pos], packet[pos + 1]
+    pos += EXT_FRAGMENT_SIZE
+    if flags & LED_DATA_EXT_FLAG_LED_UNITS:
+        offset *= channels
+    return frame_id, index, count, offset, packet[pos:]
+
+
+class ReliableSender:
+    """Sends frames and answers NACKs from the recent history."""
+
+    def __init__(self, sock, target, drop_pct=0.0):
+        self.sock = sock
+        self.target = target
+        self.drop_pct = drop_pct
+        self.history = {}
+        self.seq = 0
+        self.nacks = 0
+        self.resent = 0
+        self.stale_nacks = 0
+
+    def send_frame(self, frame_id, data, channels, max_payload, pts_us=None):
+        packets = build_reliable_frame(data, channels, frame_id, self.seq, max_payload, pts_us)
+        self.seq += len(packets)
+        self.history[frame_id & 0xFFFF] = packets
+        self.history.pop((frame_id - HISTORY_FRAMES) & 0xFFFF, None)
+        for packet in packets:
+            if random.random() * 100 >= self.drop_pct:
+                self.sock.sendto(packet, self.target)
+        return len(packets)
+
+    def handle(self, data):
+        if len(data) != struct.calcsize(NACK_FORMAT) or data[0] != PACKET_TYPE_NACK:
+            return
+        _, version, frame_id, count, missing = struct.unpack(NACK_FORMAT, data)
+        if version != NACK_VERSION:
+            return
+        self.nacks += 1
+        packets = self.history.get(frame_id)
+        if packets is None or len(packets) != count:
+            self.stale_nacks += 1
+            return
+        for index in range(count):
+            if missing & (1 << index):
+                self.sock.sendto(packets[index], self.target)
+                self.resent += 1
+
+    def poll(self, until):
+        """Answer NACKs until the given perf_counter() time."""
+        while True:
+            remaining = until - time.perf_counter()
+            if remaining <= 0:
+                return
+            ready, _, _ = select.select([self.sock], [], [], remaining)
+            if ready:
+                data, _ = self.sock.recvfrom(64)
+                self.handle(data)
+
+
+class StandInBoard:
+    """Board side of reliable frames, following main/frame_assembler.c."""
+
+    def __init__(self, channels, loss_pct, frame_size, slice_base=None):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.bind(("127.0.0.1", 0))
+        self.sock.settimeout(0.001)
+        self.channels = channels
+        self.loss_pct = loss_pct
+        self.frame_size = frame_size        # Bytes this board shows
+        self.slice_base = slice_base        # Byte offset of its slice, None if not shared
+        self.pending = {}
+        self.delivered_frame = None
+        self.delivered = []
+        self.stats = dict(completed=0, recovered=0, dropped=0, nacks=0, lost_in=0, late=0)
+
+    def address(self):
+        return self.sock.getsockname()
+
+    def drop(self, key, reason):
+        del self.pending[key]
+        self.stats["dropped"] += 1
+
+    def select_slice(self, offset, payload):
+        """Clip to the slice as select_slice() in main/udp_server.c; None if outside it."""
+        if self.slice_base is None:
+            return offset, payload
+        start, end = offset, offset + len(payload)
+        slice_end = self.slice_base + self.frame_size
+        if end <= self.slice_base or start >= slice_end:
+            return None
+        clipped = payload[max(self.slice_base - start, 0):min(end, slice_end) - start]
+        return max(start, self.slice_base) - self.slice_base, clipped
+
+    def add(self, fragment, source, now):
+        frame_id, index, count, offset, payload = fragment
+        selected = self.select_slice(offset, payload)
+        offset, payload = selected if selected else (0, b"")
+        key = (source, frame_id)
+        if self.delivered_frame is not None:
+            behind = (self.delivered_frame - frame_id) & 0xFFFF
+            if behind < 256:
+                self.stats["late"] += 1
+                return
+        frame = self.pending.get(key)
+        if frame is None:
+            if len(self.pending) >= ASSEMBLER_SLOTS:
+                oldest = min(self.pending, key=lambda k: self.pending[k]["first"])
+                self.drop(oldest, "no free slot")
+            frame = dict(count=count, parts={}, nacked=False, first=now,
+                         next_nack=now + NACK_DELAY_S, deadline=now + FRAME_DEADLINE_S)
+            self.pending[key] = frame
+        if frame["count"] != count or index in frame["parts"] or offset + len(payload) > self.frame_size:
+            return
+        frame["parts"][index] = (offset, payload)
+        if len(frame["parts"]) == count:
+            for other in [k for k in self.pending if k[0] == source and k != key and
+                          ((k[1] - frame_id) & 0xFFFF) >= 0x8000]:
+                self.drop(other, "superseded")
+            del self.pending[key]
+            self.stats["completed"] += 1
+            if frame["nacked"]:
+                self.stats["recovered"] += 1
+            self.delivered_frame = frame_id
+            data = bytearray()
+            for i in range(count):
+                data += frame["parts"][i][1]
+            self.delivered.append((frame_id, bytes(data)))
+
+    def tick(self, now):
+        for key in list(self.pending):
+            frame = self.pending[key]
+            if now >= frame["deadline"]:
+                self.drop(key, "deadline")
+            elif now >= frame["next_nack"]:
+                missing = 0
+                for i in range(frame["count"]):
+                    if i not in frame["parts"]:
+                        missing |= 1 << i
+                self.sock.sendto(struct.pack(NACK_FORMAT, PACKET_TYPE_NACK, NACK_VERSION,
+                                             key[1], frame["count"], missing), key[0])
+                frame["nacked"] = True
+                frame["next_nack"] = now + NACK_DELAY_S
+                self.stats["nacks"] += 1
+
+    def run(self, stop):
+        while not stop.is_set():
+            try:
+                packet, source = self.sock.recvfrom(2048)
+            except socket.timeout:
+                packet = None
+            now = time.perf_counter()
+            if packet is not None:
+                if random.random() * 100 < self.loss_pct:
+                    self.stats["lost_in"] += 1
+                else:
+                    fragment = parse_fragment(packet, self.channels)
+                    if fragment:
+                        self.add(fragment, source, now)
+            self.tick(now)
+
+
+def run_sender(sender, args, frames):
+    period = 1.0 / args.fps
+    next_frame = time.perf_counter()
+    fragments = 0
+    for frame_index in range(frames):
+        data = make_frame(frame_index, args.leds, args.channels)
+        pts_us = time.monotonic_ns() // 1000 if args.timed else None
+        fragments += sender.send_frame(frame_index, data, args.channels, args.max_payload, pts_us)
+        next_frame += period
+        sender.poll(next_frame)
+    # Give the last frames their chance to be NACKed
+    sender.poll(time.perf_counter() + FRAME_DEADLINE_S * 2)
+    return fragments
+
+
+def standin(args):
+    slice_base = None
+    frame_size = args.leds * args.channels
+    if args.slice:
+        base, count = (int(v) for v in args.slice.split(":"))
+        if base + count > args.leds:
+            print("--slice must lie within --leds")
+            return 1
+        slice_base, frame_size = base * args.channels, count * args.channels
+    board = StandInBoard(args.channels, args.loss, frame_size, slice_base)
+    stop = threading.Event()
+    thread = threading.Thread(target=board.run, args=(stop,), daemon=True)
+    thread.start()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("127.0.0.1", 0))
+    sender = ReliableSender(sock, board.address())
+    frames = int(args.duration * args.fps)
+    fragments = run_sender(sender, args, frames)
+    stop.set()
+    thread.join()
+
+    start = slice_base or 0
+    corrupt = sum(1 for frame_id, data in board.delivered
+                  if data != make_frame(frame_id, args.leds, args.channels)[start:start + frame_size])
+    s = board.stats
+    print(f"{frames} frames, {fragments} fragments, {args.loss}% loss at the stand-in "
+          f"({s['lost_in']} datagrams lost)")
+    print(f"delivered {s['completed']} ({s['recovered']} after NACK), dropped {s['dropped']}, "
+          f"{s['nacks']} NACKs, {sender.resent} fragments resent, {s['late']} late")
+    print(f"corrupt or partial frames delivered: {corrupt}")
+    # Loss is recovered by resends, so nearly every frame should get through
+    if corrupt or s["completed"] < frames * 0.9:
+        print("FAIL")
+        return 1
+    print("PASS")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", nargs="?", help="board hostname or IP address")
+    parser.add_argument("--port", type=int, default=23042)
+    parser.add_argument("--leds", type=int, default=500)
+    parser.add_argument("--channels", type=int, default=4, help="bytes per LED")
+    parser.add_argument("--fps", type=float, default=30.0)
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds to stream")
+    parser.add_argument("--max-payload", type=int, default=DEFAULT_MAX_PAYLOAD)
+    parser.add_argument("--timed", action="store_true", help="add presentation timestamps")
+    parser.add_argument("--drop", type=float, default=0.0, metavar="PCT",
+                        help="discard this percentage of first transmissions")
+    parser.add_argument("--standin", action="store_true",
+                        help="run against a Linux stand-in for the board on loopback")
+    parser.add_argument("--loss", type=float, default=5.0, metavar="PCT",
+                        help="stand-in: inbound loss, resends included")
+    parser.add_argument("--slice", metavar="BASE:COUNT",
+                        help="stand-in: show only these LEDs of a larger shared frame")
+    args = parser.parse_args()
+
+    if args.standin:
+        return standin(args)
+    if not args.host:
+        parser.error("a board host is required unless --standin is given")
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sender = ReliableSender(sock, (socket.gethostbyname(args.host), args.port), args.drop)
+    frames = int(args.duration * args.fps)
+    fragments = run_sender(sender, args, frames)
+    print(f"{frames} frames, {fragments} fragments, {sender.nacks} NACKs received, "
+          f"{sender.resent} fragments resent, {sender.stale_nacks} NACKs for forgotten frames")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
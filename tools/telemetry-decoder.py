@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Subscribe to ambient light board telemetry (packet 0x0A) and decode it.
+
+    SUBSCRIBE (host -> board): 0A 00 <interval_ms u16>   (0 unsubscribes)
+    REPORT    (board -> host): 0A 01 <layout version> ... 72 bytes, big-endian
+
+The board drops a subscription that is not renewed within 60 s, so this
+script renews it every 20 s. The first report after subscribing covers
+the time since the board booted; every later one covers one interval.
+
+Examples:
+    python3 tools/telemetry-decoder.py board-rs.local --interval 1000
+    python3 tools/telemetry-decoder.py board-rs.local --json > telemetry.jsonl
+"""
+
+import argparse
+import json
+import socket
+import struct
+import sys
+import time
+
+PACKET_TYPE_TELEMETRY = 0x0A
+KIND_SUBSCRIBE = 0x00
+KIND_REPORT = 0x01
+LAYOUT_VERSION = 1
+RENEW_INTERVAL_S = 20
+
+REPORT_FORMAT = ">BBBBIHHIIIIHHH8IIbx"
+REPORT_SIZE = struct.calcsize(REPORT_FORMAT)
+LATENCY_BUCKETS_MS = ("<=1", "<=2", "<=4", "<=8", "<=16", "<=32", "<=64", ">64")
+
+FLAG_CLOCK_SYNCED = 0x01
+
+
+def decode(data):
+    if len(data) != REPORT_SIZE or data[0] != PACKET_TYPE_TELEMETRY or data[1] != KIND_REPORT:
+        return None
+    fields = struct.unpack(REPORT_FORMAT, data)
+    if fields[2] != LAYOUT_VERSION:
+        raise ValueError(f"unsupported telemetry layout {fields[2]}")
+    (_, _, _, flags, uptime_ms, interval_ms, packets_per_s, packets, displayed, skipped,
+     dropped, encode_avg_us, encode_max_us, wire_us) = fields[:14]
+    histogram = list(fields[14:22])
+    min_free_heap, rssi = fields[22:24]
+    return {
+        "clock_synced": bool(flags & FLAG_CLOCK_SYNCED),
+        "uptime_ms": uptime_ms,
+        "interval_ms": interval_ms,
+        "packets_per_s": packets_per_s,
+        "packets": packets,
+        "frames_displayed": displayed,
+        "frames_skipped": skipped,
+        "frames_dropped": dropped,
+        "encode_avg_us": encode_avg_us,
+        "encode_max_us": encode_max_us,
+        "wire_us": wire_us,
+        "latency_histogram": dict(zip(LATENCY_BUCKETS_MS, histogram)),
+        "min_free_heap": min_free_heap,
+        "rssi_dbm": rssi,
+    }
+
+
+def format_report(board, report):
+    hist = " ".join(f"{k}:{v}" for k, v in report["latency_histogram"].items() if v)
+    return (f"{board} up {report['uptime_ms'] / 1000:.0f}s "
+            f"{report['packets_per_s']} pkt/s, frames {report['frames_displayed']} shown "
+            f"{report['frames_skipped']} skipped {report['frames_dropped']} dropped, "
+            f"encode {report['encode_avg_us']}/{report['encode_max_us']} us avg/max, "
+            f"wire {report['wire_us']} us, latency ms [{hist or '-'}], "
+            f"heap min {report['min_free_heap']}, rssi {report['rssi_dbm']} dBm"
+            f"{', clock synced' if report['clock_synced'] else ''}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hosts", nargs="+", help="board hostnames or IP addresses")
+    parser.add_argument("--port", type=int, default=23042)
+    parser.add_argument("--interval", type=int, default=1000, help="report interval in ms")
+    parser.add_argument("--json", action="store_true", help="print one JSON object per report")
+    args = parser.parse_args()
+
+    boards = [(socket.gethostbyname(host), args.port) for host in args.hosts]
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(1.0)
+    subscribe = struct.pack(">BBH", PACKET_TYPE_TELEMETRY, KIND_SUBSCRIBE, args.interval)
+
+    next_renew = 0.0
+    try:
+        while True:
+            if time.monotonic() >= next_renew:
+                for board in boards:
+                    sock.sendto(subscribe, board)
+                next_renew = time.monotonic() + RENEW_INTERVAL_S
+            try:
+                data, addr = sock.recvfrom(256)
+            except socket.timeout:
+                continue
+            report = decode(data)
+            if report is None:
+                continue
+            name = f"{addr[0]}:{addr[1]}"
+            if args.json:
+                print(json.dumps({"board": name, "time": time.time(), **report}), flush=True)
+            else:
+                print(format_report(name, report), flush=True)
+    except KeyboardInterrupt:
+        unsubscribe = struct.pack(">BBH", PACKET_TYPE_TELEMETRY, KIND_SUBSCRIBE, 0)
+        for board in boards:
+            sock.sendto(unsubscribe, board)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -77,6 +77,11 @@ def parse_config(firmware_data, offset):
 
     # LED order (8字节) - 偏移173
     led_order = read_cstring(config_data, 173, 8)
+
+    # 静态 IP (1字节开关 + 4个地址) - 偏移192
+    static_ip_enabled = config_data[192] != 0
+    def read_ip(start):
+        return '.'.join(str(b) for b in config_data[start:start + 4])
     
     return {
         'magic': magic,
@@ -87,7 +92,12 @@ def parse_config(firmware_data, offset):
         'mdns_hostname': mdns_hostname,
         'led_pin': led_pin,
         'max_leds': max_leds,
-        'led_order': led_order
+        'led_order': led_order,
+        'static_ip_enabled': static_ip_enabled,
+        'static_ip': read_ip(193),
+        'static_netmask': read_ip(197),
+        'static_gateway': read_ip(201),
+        'static_dns': read_ip(205)
     }
 
 def main():
@@ -132,6 +142,11 @@ def main():
     print(f"LED 引脚: {config['led_pin']}")
     print(f"最大 LED 数: {config['max_leds']}")
     print(f"LED 颜色顺序: '{config['led_order']}'")
+    if config['static_ip_enabled']:
+        print(f"静态 IP: {config['static_ip']} 掩码 {config['static_netmask']} "
+              f"网关 {config['static_gateway']} DNS {config['static_dns']}")
+    else:
+        print("静态 IP: 未启用 (DHCP)")
     
     print("\n✅ 配置区域验证成功！")
 
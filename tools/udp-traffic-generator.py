@@ -0,0 +1,568 @@
+#!/usr/bin/env python3
+"""
+Host-side traffic generator for the ambient light board.
+
+Streams synthetic frames in a chosen packet format and measures, for every
+frame, the round trip of a 1-byte ping sent right after the frame's last
+datagram. The board handles packets in order on a single task, so the pong
+only comes back after the whole frame has been received, parsed and handed
+to the LED driver; the RTT is therefore an end-to-end latency figure that
+includes the cost of the frame itself.
+
+With --ext-ping the extended ping is used instead: the board reports its
+own receive and send times and the last frame's receive-to-wire latency,
+so network RTT and board-side latency are reported separately.
+
+The ddp format sends standard DDP to port 4048 (--ddp-port), which is
+served by its own task; the ping still goes to the native port, so its RTT
+no longer strictly includes the frame. Use --ext-ping for rx->wire there.
+The artnet format likewise sends one ArtDmx per universe plus an ArtSync
+to port 6454 (--artnet-port), starting at --artnet-universe.
+
+--fec K protects ext/timed frames with one XOR parity packet (0x0C) per K
+data packets (it implies --sequence); --drop PCT discards that share of
+data packets before sending, to watch the board rebuild them.
+
+While LED data is streaming, the board sends the sender a backpressure
+report (0x0E) every 500 ms: the frame rate its output path sustains, the
+rate it is being offered, and how many frames it drops. With --adapt the
+generator follows it, dropping to 90% of the achievable rate while the
+board reports overload and creeping back towards --fps once it does not.
+
+--format auto asks the board for its capabilities (0x0F) first. It takes
+the LED count, bytes per LED, largest unfragmented datagram and measured
+maximum frame rate from the answer, and picks raw 0x02 when a frame fits
+one datagram and RGB565 otherwise. --caps only prints the capabilities.
+
+The board turns WiFi power save off while LED data streams and back on
+once none has arrived for 5 seconds. --idle-pings N waits for that after
+streaming and sends N bare pings, so the RTT distribution with modem
+sleep can be set against the one measured while streaming.
+
+Example:
+    python3 tools/udp-traffic-generator.py board-rs.local --leds 500 --format all
+"""
+
+import argparse
+import random
+import socket
+import statistics
+import struct
+import sys
+import time
+
+PACKET_TYPE_PING = 0x01
+PING_EXT_VERSION = 1
+PING_EXT_RESPONSE_FORMAT = ">BBQQQI"
+PACKET_TYPE_LED_DATA = 0x02
+PACKET_TYPE_LED_RGB565 = 0x05
+PACKET_TYPE_LED_RGB444 = 0x06
+PACKET_TYPE_LED_SCATTER = 0x07
+PACKET_TYPE_LED_DATA_EXT = 0x08
+LED_DATA_EXT_VERSION = 1
+LED_DATA_EXT_FLAG_LED_UNITS = 0x01
+LED_DATA_EXT_FLAG_TIMESTAMP = 0x02
+LED_DATA_EXT_FLAG_PUSH = 0x04
+LED_DATA_EXT_FLAG_SEQUENCE = 0x08
+LED_DATA_EXT_FLAG_FEC = 0x10
+PACKET_TYPE_FEC_PARITY = 0x0C
+FEC_PARITY_VERSION = 1
+FEC_PARITY_HEADER_SIZE = 6
+FEC_MAX_GROUP_SIZE = 16
+PACKET_TYPE_BACKPRESSURE = 0x0E
+BACKPRESSURE_VERSION = 1
+BACKPRESSURE_FORMAT = ">BBBBHHHHHHI"
+BACKPRESSURE_FLAG_OVERLOADED = 0x01
+PACKET_TYPE_CAPABILITIES = 0x0F
+CAPABILITIES_KIND_REQUEST = 0x00
+CAPABILITIES_KIND_RESPONSE = 0x01
+CAPABILITIES_FORMAT = ">BBBBIBBBBB4sxHHHHH"
+CAPABILITY_FORMAT_RGB565 = 0x02
+CAPABILITY_FLAG_FPS_ESTIMATED = 0x04
+
+DDP_FLAG_VERSION_1 = 0x40
+DDP_FLAG_PUSH = 0x01
+DDP_TYPE_RGB_8BIT = 0x0B
+DDP_TYPE_RGBW_8BIT = 0x1B
+DDP_ID_DISPLAY = 0x01
+DDP_HEADER_SIZE = 10
+# Data per packet used by most DDP senders (480 RGB pixels)
+DDP_MAX_DATA = 1440
+
+ARTNET_ID = b"Art-Net\x00"
+ARTNET_OP_DMX = 0x5000
+ARTNET_OP_SYNC = 0x5200
+ARTNET_PROTOCOL_VERSION = 14
+DMX_UNIVERSE_SIZE = 512
+
+# 1500-byte Ethernet/WiFi MTU minus IPv4 and UDP headers
+DEFAULT_MAX_PAYLOAD = 1472
+LED_DATA_TIMEOUT_S = 5.0    # The board leaves streaming mode after this long without LED data
+HEADER_SIZE = 3
+EXT_HEADER_SIZE = 7
+EXT_TIMESTAMP_SIZE = 8
+EXT_SEQUENCE_SIZE = 4
+EXT_FEC_SIZE = 3
+SCATTER_HEADER_SIZE = 2
+SCATTER_RUN_HEADER_SIZE = 4
+SCATTER_MAX_RUNS = 32
+
+FORMATS = ("raw", "ext", "timed", "rgb565", "rgb444", "scatter", "ddp", "artnet")
+
+
+def make_frame(frame_index, led_count):
+    """Moving rainbow as a list of (r, g, b) tuples."""
+    pixels = []
+    for i in range(led_count):
+        phase = (i * 7 + frame_index * 3) % 768
+        if phase < 256:
+            pixels.append((255 - phase, phase, 0))
+        elif phase < 512:
+            phase -= 256
+            pixels.append((0, 255 - phase, phase))
+        else:
+            phase -= 512
+            pixels.append((phase, 0, 255 - phase))
+    return pixels
+
+
+def encode_raw(pixels, channels):
+    out = bytearray()
+    for r, g, b in pixels:
+        # Board default order is GRBW; the generator does not care about
+        # exact colors, only about the byte count
+        out += bytes((g, r, b, 0)[:channels])
+    return bytes(out)
+
+
+def encode_rgb565(pixels):
+    out = bytearray()
+    for r, g, b in pixels:
+        out += struct.pack(">H", ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3))
+    return bytes(out)
+
+
+def encode_rgb444(pixels):
+    out = bytearray()
+    for i in range(0, len(pixels), 2):
+        r0, g0, b0 = pixels[i]
+        p0 = ((r0 >> 4) << 8) | ((g0 >> 4) << 4) | (b0 >> 4)
+        if i + 1 < len(pixels):
+            r1, g1, b1 = pixels[i + 1]
+            p1 = ((r1 >> 4) << 8) | ((g1 >> 4) << 4) | (b1 >> 4)
+            out += bytes((p0 >> 4, ((p0 & 0x0F) << 4) | (p1 >> 8), p1 & 0xFF))
+        else:
+            out += bytes((p0 >> 4, (p0 & 0x0F) << 4))
+    return bytes(out)
+
+
+def build_packets(fmt, pixels, channels, max_payload, pts_us=0, first_universe=0):
+    """Split one frame into datagrams that never exceed max_payload bytes."""
+    room = max_payload - HEADER_SIZE
+    packets = []
+
+    if fmt == "raw":
+        data = encode_raw(pixels, channels)
+        # Keep LEDs whole so a lost datagram never shifts colors
+        step = (room // channels) * channels
+        for offset in range(0, len(data), step):
+            packets.append(struct.pack(">BH", PACKET_TYPE_LED_DATA, offset) + data[offset:offset + step])
+    elif fmt == "ext":
+        data = encode_raw(pixels, channels)
+        leds_per_packet = (max_payload - EXT_HEADER_SIZE) // channels
+        for led in range(0, len(pixels), leds_per_packet):
+            chunk = data[led * channels:(led + leds_per_packet) * channels]
+            header = struct.pack(">BBBI", PACKET_TYPE_LED_DATA_EXT, LED_DATA_EXT_VERSION,
+                                 LED_DATA_EXT_FLAG_LED_UNITS, led)
+            packets.append(header + chunk)
+    elif fmt == "timed":
+        # Every packet carries the frame's presentation timestamp; the last
+        # one sets PUSH so the board knows the frame is complete
+        data = encode_raw(pixels, channels)
+        leds_per_packet = (max_payload - EXT_HEADER_SIZE - EXT_TIMESTAMP_SIZE) // channels
+        starts = list(range(0, len(pixels), leds_per_packet))
+        for led in starts:
+            flags = LED_DATA_EXT_FLAG_LED_UNITS | LED_DATA_EXT_FLAG_TIMESTAMP
+            if led == starts[-1]:
+                flags |= LED_DATA_EXT_FLAG_PUSH
+            chunk = data[led * channels:(led + leds_per_packet) * channels]
+            header = struct.pack(">BBBIQ", PACKET_TYPE_LED_DATA_EXT, LED_DATA_EXT_VERSION,
+                                 flags, led, pts_us)
+            packets.append(header + chunk)
+    elif fmt == "rgb565":
+        leds_per_packet = room // 2
+        for led in range(0, len(pixels), leds_per_packet):
+            chunk = encode_rgb565(pixels[led:led + leds_per_packet])
+            packets.append(struct.pack(">BH", PACKET_TYPE_LED_RGB565, led) + chunk)
+    elif fmt == "rgb444":
+        # Even LED count per packet so every packet starts on a byte boundary
+        leds_per_packet = ((room * 2) // 3) & ~1
+        for led in range(0, len(pixels), leds_per_packet):
+            chunk = encode_rgb444(pixels[led:led + leds_per_packet])
+            packets.append(struct.pack(">BH", PACKET_TYPE_LED_RGB444, led) + chunk)
+    elif fmt == "scatter":
+        # Four screen edges with a gap of unlit LEDs between them; every
+        # edge is a run and as many runs as fit share one datagram
+        data = encode_raw(pixels, channels)
+        edge = max(1, len(pixels) // 4)
+        runs = []
+        for start in range(0, len(pixels), edge):
+            lit = max(1, edge - 2)
+            begin = start * channels
+            end = min(len(data), (start + lit) * channels)
+            chunk_max = ((room - SCATTER_RUN_HEADER_SIZE) // channels) * channels
+            for off in range(begin, end, chunk_max):
+                runs.append((off, data[off:min(end, off + chunk_max)]))
+
+        packet = bytearray()
+        count = 0
+        for off, chunk in runs:
+            needed = SCATTER_RUN_HEADER_SIZE + len(chunk)
+            if count and (len(packet) + needed > room or count == SCATTER_MAX_RUNS):
+                packets.append(bytes((PACKET_TYPE_LED_SCATTER, count)) + bytes(packet))
+                packet = bytearray()
+                count = 0
+            packet += struct.pack(">HH", off, len(chunk)) + chunk
+            count += 1
+        if count:
+            packets.append(bytes((PACKET_TYPE_LED_SCATTER, count)) + bytes(packet))
+    elif fmt == "ddp":
+        # Byte offsets like 0x02, whole LEDs per packet, PUSH on the last;
+        # the 4-bit sequence number cycles 1-15
+        data = encode_raw(pixels, channels)
+        step = (min(DDP_MAX_DATA, max_payload - DDP_HEADER_SIZE) // channels) * channels
+        data_type = {3: DDP_TYPE_RGB_8BIT, 4: DDP_TYPE_RGBW_8BIT}.get(channels, 0)
+        for index, offset in enumerate(range(0, len(data), step)):
+            chunk = data[offset:offset + step]
+            flags = DDP_FLAG_VERSION_1
+            if offset + step >= len(data):
+                flags |= DDP_FLAG_PUSH
+            header = struct.pack(">BBBBIH", flags, index % 15 + 1, data_type,
+                                 DDP_ID_DISPLAY, offset, len(chunk))
+            packets.append(header + chunk)
+    elif fmt == "artnet":
+        # Whole LEDs per universe, as the board maps them, then one ArtSync
+        # so the board latches all universes at once
+        data = encode_raw(pixels, channels)
+        step = (DMX_UNIVERSE_SIZE // channels) * channels
+        for index, offset in enumerate(range(0, len(data), step)):
+            chunk = data[offset:offset + step]
+            header = ARTNET_ID + struct.pack("<H", ARTNET_OP_DMX) + struct.pack(
+                ">HBB", ARTNET_PROTOCOL_VERSION, index % 255 + 1, 0) + struct.pack(
+                "<H", first_universe + index) + struct.pack(">H", len(chunk))
+            packets.append(header + chunk)
+        packets.append(ARTNET_ID + struct.pack("<H", ARTNET_OP_SYNC) +
+                       struct.pack(">HBB", ARTNET_PROTOCOL_VERSION, 0, 0))
+    else:
+        raise ValueError(f"unknown format {fmt}")
+
+    return packets
+
+
+def add_sequence(packets, first_seq, frame_id):
+    """Insert the SEQUENCE field into 0x08 packets; it follows any timestamp."""
+    out = []
+    for i, packet in enumerate(packets):
+        flags = packet[2] | LED_DATA_EXT_FLAG_SEQUENCE
+        pos = EXT_HEADER_SIZE + (EXT_TIMESTAMP_SIZE if flags & LED_DATA_EXT_FLAG_TIMESTAMP else 0)
+        field = struct.pack(">HH", (first_seq + i) & 0xFFFF, frame_id & 0xFFFF)
+        out.append(packet[:2] + bytes((flags,)) + packet[3:pos] + field + packet[pos:])
+    return out
+
+
+def add_fec(packets, frame_id, group_size):
+    """Insert the FEC field into sequenced 0x08 packets and add one parity
+    packet per group: the XOR of every [length][datagram], zero padded to
+    the longest."""
+    out = []
+    for group, first in enumerate(range(0, len(packets), group_size)):
+        members = packets[first:first + group_size]
+        parity = bytearray(2 + max(len(p) for p in members) + EXT_FEC_SIZE)
+        for index, packet in enumerate(members):
+            flags = packet[2] | LED_DATA_EXT_FLAG_FEC
+            pos = (EXT_HEADER_SIZE + EXT_SEQUENCE_SIZE +
+                   (EXT_TIMESTAMP_SIZE if flags & LED_DATA_EXT_FLAG_TIMESTAMP else 0))
+            field = bytes((group & 0xFF, index, len(members)))
+            packet = packet[:2] + bytes((flags,)) + packet[3:pos] + field + packet[pos:]
+            for i, byte in enumerate(struct.pack(">H", len(packet)) + packet):
+                parity[i] ^= byte
+            out.append(packet)
+        out.append(struct.pack(">BBHBB", PACKET_TYPE_FEC_PARITY, FEC_PARITY_VERSION,
+                               frame_id & 0xFFFF, group & 0xFF, len(members)) + bytes(parity))
+    return out
+
+
+def query_capabilities(sock, target, attempts=3):
+    """Ask the board what it supports; returns a dict, or None without an answer."""
+    for _ in range(attempts):
+        sock.sendto(bytes((PACKET_TYPE_CAPABILITIES, CAPABILITIES_KIND_REQUEST)), target)
+        try:
+            while True:
+                reply, _ = sock.recvfrom(64)
+                if (len(reply) == struct.calcsize(CAPABILITIES_FORMAT) and
+                        reply[0] == PACKET_TYPE_CAPABILITIES and reply[1] == CAPABILITIES_KIND_RESPONSE):
+                    break
+        except socket.timeout:
+            continue
+        (_, _, _, protocol, packet_types, ext_flags, formats, receivers, flags, channels,
+         order, leds, max_leds, max_payload, max_fps_x10, frame_us) = struct.unpack(CAPABILITIES_FORMAT, reply)
+        return {
+            "protocol": protocol,
+            "packet_types": [t for t in range(32) if packet_types & (1 << t)],
+            "ext_flags": ext_flags,
+            "formats": formats,
+            "receivers": receivers,
+            "flags": flags,
+            "channels": channels,
+            "order": order.rstrip(b"\0").decode("ascii", "replace"),
+            "leds": leds,
+            "max_leds": max_leds,
+            "max_payload": max_payload,
+            "max_fps": max_fps_x10 / 10.0,
+            "frame_us": frame_us,
+        }
+    return None
+
+
+def apply_capabilities(caps, args):
+    """Fit the stream to the board and pick the format using the fewest datagrams."""
+    args.leds = caps["leds"]
+    args.channels = caps["channels"]
+    args.max_payload = min(args.max_payload, caps["max_payload"])
+    if caps["max_fps"] > 0:
+        args.fps = min(args.fps, caps["max_fps"])
+    raw_bytes = HEADER_SIZE + args.leds * args.channels
+    if raw_bytes <= args.max_payload or not caps["formats"] & CAPABILITY_FORMAT_RGB565:
+        return "raw"
+    return "rgb565"
+
+
+def print_capabilities(caps):
+    estimated = " (estimated)" if caps["flags"] & CAPABILITY_FLAG_FPS_ESTIMATED else ""
+    print(f"protocol {caps['protocol']}, packet types "
+          f"{' '.join(f'{t:02X}' for t in caps['packet_types'])}, 0x08 flags 0x{caps['ext_flags']:02X}")
+    print(f"{caps['leds']} of up to {caps['max_leds']} LEDs, {caps['channels']} channels "
+          f"({caps['order']}), datagrams up to {caps['max_payload']} bytes")
+    print(f"frame time {caps['frame_us']} us, max {caps['max_fps']:.1f} fps{estimated}")
+
+
+def percentile(values, pct):
+    if not values:
+        return float("nan")
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(pct / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def adapt_fps(report, fps, args):
+    """Follow a backpressure report; returns the new frame rate."""
+    (_, version, flags, _, _, achievable_x10, _, _, _, _, _) = struct.unpack(BACKPRESSURE_FORMAT, report)
+    if version != BACKPRESSURE_VERSION or not args.adapt:
+        return fps
+    if flags & BACKPRESSURE_FLAG_OVERLOADED and achievable_x10:
+        return max(1.0, min(fps, achievable_x10 / 10.0 * 0.9))
+    return min(args.fps, fps * 1.05)
+
+
+def rtt_summary(rtts_ms):
+    return {
+        "median_ms": statistics.median(rtts_ms) if rtts_ms else float("nan"),
+        "p95_ms": percentile(rtts_ms, 95),
+        "p99_ms": percentile(rtts_ms, 99),
+        "max_ms": max(rtts_ms) if rtts_ms else float("nan"),
+    }
+
+
+def measure_idle(sock, target, args):
+    """Bare pings with no LED data streaming, so the board is in power save."""
+    time.sleep(LED_DATA_TIMEOUT_S + 1.0)
+    rtts_ms = []
+    lost = 0
+    for _ in range(args.idle_pings):
+        sent_at = time.perf_counter()
+        sock.sendto(bytes((PACKET_TYPE_PING,)), target)
+        try:
+            while True:
+                reply, _ = sock.recvfrom(64)
+                if reply and reply[0] == PACKET_TYPE_PING:
+                    rtts_ms.append((time.perf_counter() - sent_at) * 1000.0)
+                    break
+        except socket.timeout:
+            lost += 1
+        # Spread over the beacon interval rather than in step with it
+        time.sleep(random.uniform(0.05, 0.25))
+    return dict(rtt_summary(rtts_ms), pings=args.idle_pings, lost_pongs=lost)
+
+
+def run_format(sock, target, fmt, args):
+    fps = args.fps
+    min_fps = fps
+    reports = 0
+    frames = int(args.duration * args.fps)
+    rtts_ms = []
+    network_ms = []
+    frame_latency_ms = []
+    lost = 0
+    datagrams = 0
+    payload_bytes = 0
+    seq = 0
+
+    next_frame = time.perf_counter()
+    for frame_index in range(frames):
+        pixels = make_frame(frame_index, args.leds)
+        pts_us = int(time.monotonic() * 1_000_000)
+        if (args.sequence or args.fec) and fmt in ("ext", "timed"):
+            # A parity packet is its header and a length longer than the
+            # longest data packet, and has to fit max_payload too
+            overhead = EXT_SEQUENCE_SIZE
+            if args.fec:
+                overhead += EXT_FEC_SIZE + FEC_PARITY_HEADER_SIZE + 2
+            packets = build_packets(fmt, pixels, args.channels,
+                                    args.max_payload - overhead, pts_us)
+            packets = add_sequence(packets, seq, frame_index)
+            seq += len(packets)
+            if args.fec:
+                packets = add_fec(packets, frame_index, args.fec)
+        else:
+            packets = build_packets(fmt, pixels, args.channels, args.max_payload, pts_us,
+                                    args.artnet_universe)
+        datagrams += len(packets)
+        payload_bytes += sum(len(p) for p in packets)
+
+        data_target = target
+        if fmt == "ddp":
+            data_target = (target[0], args.ddp_port)
+        elif fmt == "artnet":
+            data_target = (target[0], args.artnet_port)
+        for packet in packets:
+            if packet[0] != PACKET_TYPE_FEC_PARITY and random.random() * 100 < args.drop:
+                continue
+            sock.sendto(packet, data_target)
+
+        sent_at = time.perf_counter()
+        if args.ext_ping:
+            sock.sendto(struct.pack(">BBQ", PACKET_TYPE_PING, PING_EXT_VERSION,
+                                    time.monotonic_ns() // 1000), target)
+        else:
+            sock.sendto(bytes((PACKET_TYPE_PING,)), target)
+        try:
+            while True:
+                reply, _ = sock.recvfrom(64)
+                if (reply and reply[0] == PACKET_TYPE_BACKPRESSURE and
+                        len(reply) == struct.calcsize(BACKPRESSURE_FORMAT)):
+                    reports += 1
+                    fps = adapt_fps(reply, fps, args)
+                    min_fps = min(min_fps, fps)
+                elif reply and reply[0] == PACKET_TYPE_PING:
+                    rtt_ms = (time.perf_counter() - sent_at) * 1000.0
+                    rtts_ms.append(rtt_ms)
+                    if len(reply) == struct.calcsize(PING_EXT_RESPONSE_FORMAT):
+                        _, _, _, board_rx, board_tx, frame_us = struct.unpack(
+                            PING_EXT_RESPONSE_FORMAT, reply)
+                        board_ms = (board_tx - board_rx) / 1000.0
+                        network_ms.append(rtt_ms - board_ms)
+                        frame_latency_ms.append(frame_us / 1000.0)
+                    break
+        except socket.timeout:
+            lost += 1
+
+        next_frame += 1.0 / fps
+        delay = next_frame - time.perf_counter()
+        if delay > 0:
+            time.sleep(delay)
+
+    return {
+        "format": fmt,
+        "frames": frames,
+        "datagrams_per_frame": datagrams / frames if frames else 0,
+        "bytes_per_frame": payload_bytes / frames if frames else 0,
+        "lost_pongs": lost,
+        **rtt_summary(rtts_ms),
+        "network_median_ms": statistics.median(network_ms) if network_ms else float("nan"),
+        "frame_latency_median_ms": statistics.median(frame_latency_ms) if frame_latency_ms else float("nan"),
+        "backpressure_reports": reports,
+        "min_fps": min_fps,
+        "final_fps": fps,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="board hostname or IP address")
+    parser.add_argument("--port", type=int, default=23042)
+    parser.add_argument("--leds", type=int, default=500)
+    parser.add_argument("--channels", type=int, default=4, help="bytes per LED for raw 0x02 frames")
+    parser.add_argument("--format", choices=FORMATS + ("all", "auto"), default="all")
+    parser.add_argument("--caps", action="store_true", help="print the board's capabilities and exit")
+    parser.add_argument("--fps", type=float, default=30.0)
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds per format")
+    parser.add_argument("--max-payload", type=int, default=DEFAULT_MAX_PAYLOAD)
+    parser.add_argument("--sequence", action="store_true",
+                        help="add sequence numbers and frame ids to ext/timed packets")
+    parser.add_argument("--fec", type=int, default=0, metavar="K",
+                        help="send one XOR parity packet per K ext/timed data packets")
+    parser.add_argument("--drop", type=float, default=0.0, metavar="PCT",
+                        help="discard this percentage of data packets to simulate loss")
+    parser.add_argument("--ext-ping", action="store_true",
+                        help="use the extended ping to split network RTT from board latency")
+    parser.add_argument("--adapt", action="store_true",
+                        help="lower the frame rate while the board reports overload")
+    parser.add_argument("--idle-pings", type=int, default=0, metavar="N",
+                        help="after streaming, send N pings with the board back in power save")
+    parser.add_argument("--ddp-port", type=int, default=4048, help="board DDP port for the ddp format")
+    parser.add_argument("--artnet-port", type=int, default=6454, help="board Art-Net port for the artnet format")
+    parser.add_argument("--artnet-universe", type=int, default=0, help="port-address of the first LED")
+    parser.add_argument("--timeout", type=float, default=0.5, help="pong timeout in seconds")
+    args = parser.parse_args()
+    if not 0 <= args.fec <= FEC_MAX_GROUP_SIZE:
+        parser.error(f"--fec takes at most {FEC_MAX_GROUP_SIZE} data packets per parity packet")
+
+    target = (socket.gethostbyname(args.host), args.port)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(args.timeout)
+
+    if args.caps or args.format == "auto":
+        caps = query_capabilities(sock, target)
+        if caps is None:
+            print("no capabilities response", file=sys.stderr)
+            return 1
+        print_capabilities(caps)
+        if args.caps:
+            return 0
+        args.format = apply_capabilities(caps, args)
+        print(f"streaming {args.format} at {args.fps:.1f} fps\n")
+
+    formats = FORMATS if args.format == "all" else (args.format,)
+    results = [run_format(sock, target, fmt, args) for fmt in formats]
+    idle = measure_idle(sock, target, args) if args.idle_pings > 0 else None
+
+    print(f"{'format':<8} {'frames':>7} {'dgram/frm':>10} {'bytes/frm':>10} "
+          f"{'lost':>5} {'median ms':>10} {'p95 ms':>8} {'p99 ms':>8}")
+    for r in results:
+        print(f"{r['format']:<8} {r['frames']:>7} {r['datagrams_per_frame']:>10.2f} "
+              f"{r['bytes_per_frame']:>10.0f} {r['lost_pongs']:>5} {r['median_ms']:>10.2f} "
+              f"{r['p95_ms']:>8.2f} {r['p99_ms']:>8.2f}")
+    if args.ext_ping:
+        print()
+        print(f"{'format':<8} {'net rtt ms':>11} {'rx->wire ms':>12}")
+        for r in results:
+            print(f"{r['format']:<8} {r['network_median_ms']:>11.2f} {r['frame_latency_median_ms']:>12.2f}")
+    if args.adapt:
+        print()
+        print(f"{'format':<8} {'reports':>8} {'min fps':>8} {'final fps':>10}")
+        for r in results:
+            print(f"{r['format']:<8} {r['backpressure_reports']:>8} {r['min_fps']:>8.1f} {r['final_fps']:>10.1f}")
+    if idle:
+        print()
+        print(f"{'mode':<18} {'pings':>6} {'lost':>5} {'median ms':>10} {'p95 ms':>8} "
+              f"{'p99 ms':>8} {'max ms':>8}")
+        rows = [(f"{r['format']} streaming", r["frames"], r) for r in results]
+        rows.append(("idle (power save)", idle["pings"], idle))
+        for name, pings, r in rows:
+            print(f"{name:<18} {pings:>6} {r['lost_pongs']:>5} {r['median_ms']:>10.2f} "
+                  f"{r['p95_ms']:>8.2f} {r['p99_ms']:>8.2f} {r['max_ms']:>8.2f}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())